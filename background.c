@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "background.h"
+#include "svg_parser.h"
+#include "prof.h"
+
+const Background background_black = { BACKGROUND_SOLID, 0x000000, 0x000000, NULL, 0, 0 };
+
+/* Where the pixels of a buffer lie in the upright picture */
+typedef struct {
+    int turns;               // Quarter turns from the upright picture to the buffer
+    uint32_t width, height;  // Size of the upright picture
+    uint32_t x, y;           // Upright position of the buffer, without turns only
+} Placement;
+
+/* 0xRRGGBB value of a color */
+static uint32_t color_value(Color c) {
+    return ((uint32_t)c.r << 16) | ((uint32_t)c.g << 8) | c.b;
+}
+
+/* Load a binary PPM with 8-bit channels as the tile */
+static int load_tile(Background *bg, const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s: %m\n", path);
+        return -1;
+    }
+
+    char magic[3];
+    unsigned int width, height, maxval;
+    if (fscanf(fp, "%2s %u %u %u", magic, &width, &height, &maxval) != 4 || strcmp(magic, "P6") != 0 ||
+        maxval != 255 || width == 0 || height == 0 ||
+        width > BACKGROUND_MAX_TILE || height > BACKGROUND_MAX_TILE || fgetc(fp) == EOF) {
+        fprintf(stderr, "%s is not a binary PPM tile up to %ux%u\n", path,
+                BACKGROUND_MAX_TILE, BACKGROUND_MAX_TILE);
+        fclose(fp);
+        return -1;
+    }
+
+    size_t count = (size_t)width * height;
+    uint8_t *rgb = malloc(count * 3);
+    bg->tile = malloc(count * sizeof(uint32_t));
+    if (!rgb || !bg->tile || fread(rgb, 3, count, fp) != count) {
+        fprintf(stderr, "Failed to read the tile from %s\n", path);
+        free(rgb);
+        free(bg->tile);
+        bg->tile = NULL;
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    for (size_t i = 0; i < count; i++) {
+        bg->tile[i] = (rgb[3 * i] << 16) | (rgb[3 * i + 1] << 8) | rgb[3 * i + 2];
+    }
+    free(rgb);
+
+    bg->tile_width = width;
+    bg->tile_height = height;
+    return 0;
+}
+
+/* Parse a background from the command line */
+int background_parse(Background *bg, const char *spec) {
+    *bg = background_black;
+
+    if (strncmp(spec, "tile:", 5) == 0) {
+        bg->kind = BACKGROUND_TILE;
+        return load_tile(bg, spec + 5);
+    }
+
+    // Colors hold no colons, so one separates the gradient ends
+    const char *split = strchr(spec, ':');
+    size_t top_length = split ? (size_t)(split - spec) : strlen(spec);
+    Color top, bottom;
+    if (!parse_color_exact(spec, top_length, &top) ||
+        (split && !parse_color_exact(split + 1, strlen(split + 1), &bottom))) {
+        fprintf(stderr, "Invalid background %s, colors are #rrggbb, #rgb, rgb(r,g,b), black or white\n",
+                spec);
+        return -1;
+    }
+
+    bg->color = color_value(top);
+    if (split) {
+        bg->kind = BACKGROUND_GRADIENT;
+        bg->bottom = color_value(bottom);
+    }
+    return 0;
+}
+
+/* Free the tile of a parsed background */
+void background_free(Background *bg) {
+    free(bg->tile);
+    bg->tile = NULL;
+}
+
+/* Upright picture position of buffer pixel (x, y) */
+static void upright_point(const Placement *pl, uint32_t x, uint32_t y, uint32_t *ux, uint32_t *uy) {
+    switch (pl->turns) {
+        case 1: *ux = y; *uy = pl->height - 1 - x; break;
+        case 2: *ux = pl->width - 1 - x; *uy = pl->height - 1 - y; break;
+        case 3: *ux = pl->width - 1 - y; *uy = x; break;
+        default: *ux = x + pl->x; *uy = y + pl->y; break;
+    }
+}
+
+/* Gradient color of upright row y, rounded per channel */
+static uint32_t gradient_color(const Background *bg, uint32_t y, uint32_t height) {
+    if (height < 2) {
+        return bg->color;
+    }
+
+    uint32_t d = height - 1;
+    uint32_t t = (y < d) ? y : d;
+    uint32_t color = 0;
+    for (int shift = 0; shift <= 16; shift += 8) {
+        uint32_t top = (bg->color >> shift) & 0xFF;
+        uint32_t bottom = (bg->bottom >> shift) & 0xFF;
+        color |= ((top * (d - t) + bottom * t + d / 2) / d) << shift;
+    }
+    return color;
+}
+
+/* Color of upright pixel (x, y) */
+static uint32_t background_color(const Background *bg, const Placement *pl, uint32_t x, uint32_t y) {
+    switch (bg->kind) {
+        case BACKGROUND_GRADIENT: return gradient_color(bg, y, pl->height);
+        case BACKGROUND_TILE: return bg->tile[(y % bg->tile_height) * bg->tile_width + x % bg->tile_width];
+        default: return bg->color;
+    }
+}
+
+/* Buffer rows after which the rows repeat */
+static uint32_t row_period(const Background *bg, const Placement *pl) {
+    if (bg->kind == BACKGROUND_TILE) {
+        return (pl->turns & 1) ? bg->tile_width : bg->tile_height;
+    }
+    return 1;
+}
+
+/* Rows of area outside of skip, built once per repeating row and copied
+ * Templates live in private memory, so nothing is read from the screen.
+ * Each row of an upright gradient has a color of its own, its template is
+ * only filled again when the color changes, which after rounding to the
+ * pixel format takes many rows.
+ */
+static void draw_area(Framebuffer *fb, const Background *bg, const Placement *pl, FbRect area,
+                      const FbRect *skip) {
+    if (area.x1 > fb->vinfo.xres) area.x1 = fb->vinfo.xres;
+    if (area.y1 > fb->vinfo.yres) area.y1 = fb->vinfo.yres;
+    if (area.x1 <= area.x0 || area.y1 <= area.y0) {
+        return;
+    }
+
+    // Part of the area to leave alone, empty unless skip overlaps it
+    FbRect cut = { 0, 0, 0, 0 };
+    if (skip) {
+        cut.x0 = (skip->x0 > area.x0) ? skip->x0 : area.x0;
+        cut.x1 = (skip->x1 < area.x1) ? skip->x1 : area.x1;
+        cut.y0 = (skip->y0 > area.y0) ? skip->y0 : area.y0;
+        cut.y1 = (skip->y1 < area.y1) ? skip->y1 : area.y1;
+        if (cut.x1 <= cut.x0 || cut.y1 <= cut.y0) {
+            memset(&cut, 0, sizeof(cut));
+        }
+    }
+
+    const PixelFormat *fmt = &fb->format;
+    uint32_t width = area.x1 - area.x0;
+    size_t row_bytes = (size_t)width * fmt->bytes_per_pixel;
+    uint32_t period = row_period(bg, pl);
+    bool solid_rows = bg->kind == BACKGROUND_GRADIENT && !(pl->turns & 1);
+    uint32_t row_pixel = 0;
+
+    uint8_t *templates = malloc(period * row_bytes);
+    uint8_t *ready = calloc(period, 1);
+    uint32_t *colors = malloc(width * sizeof(uint32_t));
+    if (!templates || !ready || !colors) {
+        fprintf(stderr, "Failed to allocate background rows\n");
+        free(colors);
+        free(ready);
+        free(templates);
+        return;
+    }
+
+    fb_add_damage(fb, area.x0, area.y0, width, area.y1 - area.y0);
+    PROF_COUNT(PROF_PIXELS, (uint64_t)width * (area.y1 - area.y0) -
+                            (uint64_t)(cut.x1 - cut.x0) * (cut.y1 - cut.y0));
+
+    for (uint32_t y = area.y0; y < area.y1; y++) {
+        // Up to two spans of the row lie outside the cut
+        bool cut_row = y >= cut.y0 && y < cut.y1;
+        uint32_t spans[2][2] = {
+            { area.x0, cut_row ? cut.x0 : area.x1 },
+            { cut_row ? cut.x1 : area.x1, area.x1 },
+        };
+
+        // The first pixel tells which upright row or column the row shows
+        uint32_t ux, uy;
+        upright_point(pl, area.x0, y, &ux, &uy);
+
+        uint32_t key = (period == 1) ? 0 : ((pl->turns & 1) ? ux : uy) % period;
+        uint8_t *row = templates + key * row_bytes;
+        if (solid_rows) {
+            uint32_t pixel = pixel_pack(fmt, gradient_color(bg, uy, pl->height));
+            if (!ready[0] || pixel != row_pixel) {
+                fmt->fill(row, pixel, width);
+                row_pixel = pixel;
+                ready[0] = 1;
+            }
+        } else if (!ready[key]) {
+            for (uint32_t x = 0; x < width; x++) {
+                upright_point(pl, area.x0 + x, y, &ux, &uy);
+                colors[x] = background_color(bg, pl, ux, uy);
+            }
+            fmt->store(fmt, row, colors, width);
+            ready[key] = 1;
+        }
+
+        for (int i = 0; i < 2; i++) {
+            uint32_t x0 = spans[i][0], x1 = spans[i][1];
+            if (x1 > x0) {
+                memcpy(fb_pixel_address(fb, x0, y), row + (size_t)(x0 - area.x0) * fmt->bytes_per_pixel,
+                       (size_t)(x1 - x0) * fmt->bytes_per_pixel);
+            }
+        }
+    }
+
+    free(colors);
+    free(ready);
+    free(templates);
+}
+
+/* Draw the background onto a screen */
+void background_draw(Framebuffer *fb, const Background *bg, int turns, const FbRect *area,
+                     const FbRect *skip) {
+    Placement pl = { turns, fb->vinfo.xres, fb->vinfo.yres, 0, 0 };
+    if (turns & 1) {
+        pl.width = fb->vinfo.yres;
+        pl.height = fb->vinfo.xres;
+    }
+
+    FbRect screen = { 0, 0, fb->vinfo.xres, fb->vinfo.yres };
+    draw_area(fb, bg ? bg : &background_black, &pl, area ? *area : screen, skip);
+}
+
+/* Draw part of the upright picture into an off-screen buffer */
+void background_draw_upright(Framebuffer *buf, const Background *bg, uint32_t x, uint32_t y,
+                             uint32_t width, uint32_t height) {
+    Placement pl = { 0, width, height, x, y };
+    FbRect all = { 0, 0, buf->vinfo.xres, buf->vinfo.yres };
+    draw_area(buf, bg ? bg : &background_black, &pl, all, NULL);
+}
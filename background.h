@@ -0,0 +1,64 @@
+#ifndef BACKGROUND_H
+#define BACKGROUND_H
+
+#include <stdint.h>
+#include "fbsplash.h"
+
+/* Background layer behind the logo
+ * BACKGROUND_SOLID: One color everywhere
+ * BACKGROUND_GRADIENT: Vertical gradient from the top to the bottom color
+ * BACKGROUND_TILE: Picture repeated from the top left corner
+ * The layer is laid out on the upright picture, so a gradient still runs
+ * from top to bottom on rotated panels.
+ */
+typedef enum {
+    BACKGROUND_SOLID,
+    BACKGROUND_GRADIENT,
+    BACKGROUND_TILE,
+} BackgroundKind;
+
+typedef struct {
+    BackgroundKind kind;
+    uint32_t color;          // Solid color or top of the gradient, 0xRRGGBB
+    uint32_t bottom;         // Bottom of the gradient
+    uint32_t *tile;          // Tile pixels as 0xRRGGBB, row by row
+    uint32_t tile_width;
+    uint32_t tile_height;
+} Background;
+
+/* Largest tile edge in pixels */
+#define BACKGROUND_MAX_TILE 1024
+
+/* Plain black, what a NULL background stands for */
+extern const Background background_black;
+
+/* Parse a background from the command line
+ * spec: COLOR for a solid color, TOP:BOTTOM for a gradient or tile:FILE
+ *       for a binary PPM (P6) tile. Colors are #rrggbb, #rgb, rgb(r,g,b),
+ *       black or white, anything else is rejected.
+ * Returns: 0 on success, -1 on a bad spec or unreadable tile
+ */
+int background_parse(Background *bg, const char *spec);
+
+/* Free the tile of a parsed background */
+void background_free(Background *bg);
+
+/* Draw the background onto a screen
+ * Rows that repeat are built once and copied, so every pixel is written
+ * with plain stores and the screen is never read back.
+ * bg: Background or NULL for black
+ * turns: Quarter turns from the upright picture to the panel
+ * area: Screen rectangle to draw, NULL for the whole screen
+ * skip: Rectangle left alone, e.g. one the logo covers completely, or NULL
+ */
+void background_draw(Framebuffer *fb, const Background *bg, int turns, const FbRect *area,
+                     const FbRect *skip);
+
+/* Draw part of the upright picture into an off-screen buffer
+ * x, y: Position of the buffer in the upright picture
+ * width, height: Size of the whole upright picture
+ */
+void background_draw_upright(Framebuffer *buf, const Background *bg, uint32_t x, uint32_t y,
+                             uint32_t width, uint32_t height);
+
+#endif
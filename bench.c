@@ -0,0 +1,1343 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "resolve.h"
+#include "composite.h"
+#include "fbsplash.h"
+#include "svg_renderer.h"
+#include "svg_parser.h"
+#include "svg_loader.h"
+#include "logo_table.h"
+#include "logo_paths.h"
+#include "dt_rotation.h"
+#include "splash_daemon.h"
+#include "background.h"
+#include "text.h"
+#include "qoi.h"
+#include "image.h"
+#include "prof.h"
+
+#define ROW_WIDTH 1920            // Pixels per benchmark row
+#define MIN_BENCH_NS 200000000.0  // Run every measurement for at least 0.2 s
+#define MATRIX_BENCH_NS 50000000.0  // Shorter runs for the many cells of the render matrix
+#define DT_BUSES 60               // Buses of the synthetic device tree
+#define DT_DEVICES 60             // Devices per bus
+
+/* Curves of every kind across the logo area, for the flattening benchmark */
+static const char *const curve_path =
+    "M 0 137 A 137 137 0 1 1 274 137 A 137 137 0 1 1 0 137 Z "
+    "M 60 137 C 60 40 214 40 214 137 S 60 234 60 137 Z "
+    "M 320 0 Q 470 274 620 0 T 920 0 t 300 0 L 1220 274 L 320 274 Z "
+    "m 1000 10 c 200 -20 300 100 300 250 s -250 20 -300 -250 z "
+    "M 1600 20 a 600 120 15 0 1 700 200 l -700 0 Z";
+
+/* Benchmark subcommand */
+typedef struct {
+    const char *name;
+    const char *help;
+    int (*run)(int argc, char **argv);
+} BenchCommand;
+
+/* Monotonic time in nanoseconds */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Small deterministic generator so every run sees the same data */
+static uint32_t bench_random(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/* Fill a row with coverage shaped like a logo scanline
+ * Runs of empty, solid and anti-aliased pixels alternate.
+ */
+static void make_coverage_row(float *coverage, uint32_t width) {
+    uint32_t state = 1;
+    uint32_t x = 0;
+
+    while (x < width) {
+        uint32_t run = 4 + bench_random(&state) % 60;
+        uint32_t kind = bench_random(&state) % 3;
+        for (uint32_t i = 0; i < run && x < width; i++, x++) {
+            if (kind == 0) {
+                coverage[x] = 0.0f;
+            } else if (kind == 1) {
+                coverage[x] = 1.0f;
+            } else {
+                coverage[x] = (float)(bench_random(&state) % 1000) / 1000.0f;
+            }
+        }
+    }
+}
+
+/* Coverage resolve and RGB565 pack kernels, in pixels per nanosecond */
+static int bench_resolve(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    float *pattern = malloc(ROW_WIDTH * sizeof(float));
+    float *coverage = malloc(ROW_WIDTH * sizeof(float));
+    uint8_t *quantized = malloc(ROW_WIDTH);
+    uint32_t *colors = malloc(ROW_WIDTH * sizeof(uint32_t));
+    uint16_t *packed = malloc(ROW_WIDTH * sizeof(uint16_t));
+    if (!pattern || !coverage || !quantized || !colors || !packed) {
+        fprintf(stderr, "Failed to allocate benchmark buffers\n");
+        free(packed);
+        free(colors);
+        free(quantized);
+        free(coverage);
+        free(pattern);
+        return 1;
+    }
+
+    make_coverage_row(pattern, ROW_WIDTH);
+    for (uint32_t x = 0; x < ROW_WIDTH; x++) {
+        colors[x] = composite_scale(0xD42A2A, (uint32_t)(pattern[x] * 255));
+    }
+
+    // Kernels clear the coverage, so every row is restored from the pattern.
+    // The copy alone is timed too and taken out of the resolve numbers.
+    uint64_t rows = 0;
+    double start = now_ns(), copy_ns;
+    do {
+        for (int i = 0; i < 1000; i++, rows++) {
+            memcpy(coverage, pattern, ROW_WIDTH * sizeof(float));
+            __asm__ __volatile__("" : : "r"(coverage) : "memory");
+        }
+        copy_ns = now_ns() - start;
+    } while (copy_ns < MIN_BENCH_NS);
+    double copy_per_row = copy_ns / rows;
+
+    const ResolveKernel *kernel;
+    for (unsigned int k = 0; (kernel = resolve_kernel_get(k)) != NULL; k++) {
+        rows = 0;
+        start = now_ns();
+        double elapsed;
+        do {
+            for (int i = 0; i < 1000; i++, rows++) {
+                memcpy(coverage, pattern, ROW_WIDTH * sizeof(float));
+                kernel->resolve(coverage, quantized, ROW_WIDTH);
+            }
+            elapsed = now_ns() - start;
+        } while (elapsed < MIN_BENCH_NS);
+        double resolve_per_row = elapsed / rows - copy_per_row;
+
+        rows = 0;
+        start = now_ns();
+        do {
+            for (int i = 0; i < 1000; i++, rows++) {
+                kernel->pack_rgb565(packed, colors, ROW_WIDTH);
+                __asm__ __volatile__("" : : "r"(packed) : "memory");
+            }
+            elapsed = now_ns() - start;
+        } while (elapsed < MIN_BENCH_NS);
+        double pack_per_row = elapsed / rows;
+
+        printf("resolve kernel=%s width=%u resolve_pixels_per_ns=%.3f pack_rgb565_pixels_per_ns=%.3f\n",
+               kernel->name, ROW_WIDTH, ROW_WIDTH / resolve_per_row, ROW_WIDTH / pack_per_row);
+    }
+
+    free(packed);
+    free(colors);
+    free(quantized);
+    free(coverage);
+    free(pattern);
+    return 0;
+}
+
+/* Edge blending per pixel, the float blend_pixel() call against the span kernels
+ * Rows carry the alpha of a logo scanline over a mid-grey screen, which the
+ * kernels have to read back for every partly covered pixel.
+ */
+static int bench_blend(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    float *coverage = malloc(ROW_WIDTH * sizeof(float));
+    uint8_t *alpha = malloc(ROW_WIDTH);
+    uint32_t *colors = malloc(ROW_WIDTH * sizeof(uint32_t));
+    if (!coverage || !alpha || !colors) {
+        fprintf(stderr, "Failed to allocate benchmark buffers\n");
+        free(colors);
+        free(alpha);
+        free(coverage);
+        return 1;
+    }
+
+    const uint32_t fill = 0xD42A2A;
+    make_coverage_row(coverage, ROW_WIDTH);
+    for (uint32_t x = 0; x < ROW_WIDTH; x++) {
+        alpha[x] = composite_tables()->vibrancy[(uint32_t)(coverage[x] * 255 + 0.5f)];
+        colors[x] = composite_scale(fill, alpha[x]);
+    }
+
+    static const uint32_t depths[] = { 16, 32 };
+    static const char *const methods[] = { "blend_pixel", "blend_span", "over", "over_linear" };
+
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+        FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false, ROW_WIDTH, 16, depths[d], 0, 0 };
+        Framebuffer *fb = fb_init(&config);
+        if (!fb) {
+            fprintf(stderr, "Failed to set up a %ux16 screen\n", ROW_WIDTH);
+            free(colors);
+            free(alpha);
+            free(coverage);
+            return 1;
+        }
+        const PixelFormat *fmt = &fb->format;
+
+        for (size_t m = 0; m < sizeof(methods) / sizeof(methods[0]); m++) {
+            uint64_t rows = 0;
+            double start = now_ns(), elapsed;
+            do {
+                for (uint32_t y = 0; y < fb->vinfo.yres; y++, rows++) {
+                    uint8_t *dst = fb_pixel_address(fb, 0, y);
+                    fmt->fill(dst, pixel_pack(fmt, 0x808080), ROW_WIDTH);
+                    switch (m) {
+                        case 0:
+                            for (uint32_t x = 0; x < ROW_WIDTH; x++) {
+                                blend_pixel(fb, x, y, fill, coverage[x]);
+                            }
+                            break;
+                        case 1: fmt->blend(fmt, dst, fill, alpha, ROW_WIDTH); break;
+                        case 2: fmt->over(fmt, dst, colors, alpha, ROW_WIDTH); break;
+                        default: fmt->over_linear(fmt, dst, colors, alpha, ROW_WIDTH); break;
+                    }
+                }
+                elapsed = now_ns() - start;
+            } while (elapsed < MIN_BENCH_NS);
+            printf("blend method=%s bpp=%u ns_per_pixel=%.3f\n", methods[m], depths[d],
+                   elapsed / rows / ROW_WIDTH);
+        }
+
+        fb_cleanup(fb);
+    }
+
+    free(colors);
+    free(alpha);
+    free(coverage);
+    return 0;
+}
+
+/* Render the logo once per engine and display mode on a memory screen
+ * Every engine is compared to one untimed render of the reference engine.
+ */
+static int bench_raster(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static const struct { uint32_t width, height; } modes[] = {
+        { 320, 240 }, { 800, 480 }, { 1920, 1080 },
+    };
+    static const struct { const char *name; RenderAA aa; } engines[] = {
+        { "supersample", RENDER_AA_SUPERSAMPLE },
+        { "analytic", RENDER_AA_ANALYTIC },
+        { "fixed", RENDER_AA_FIXED },
+    };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false,
+                            modes[m].width, modes[m].height, 32, 0, 0 };
+        Framebuffer *fb = fb_init(&config);
+        DisplayInfo *display_info = fb ? calculate_display_info(fb, &logo_scene.view_box, 0) : NULL;
+        uint8_t *reference = fb ? malloc(fb->screensize) : NULL;
+        if (!fb || !display_info || !reference) {
+            fprintf(stderr, "Failed to set up a %ux%u screen\n", modes[m].width, modes[m].height);
+            free(reference);
+            free(display_info);
+            fb_cleanup(fb);
+            return 1;
+        }
+
+        RenderOptions reference_options = { RENDER_AA_REFERENCE, 0, NULL, false, NULL, false };
+        fb_fill_rect(fb, 0, 0, fb->vinfo.xres, fb->vinfo.yres, 0x000000);
+        render_scene(fb, &logo_scene, display_info, &reference_options);
+        memcpy(reference, fb->screen, fb->screensize);
+
+        for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+            RenderOptions options = { engines[e].aa, 0, NULL, false, NULL, false };
+            uint64_t frames = 0;
+            double start = now_ns(), elapsed;
+            do {
+                fb_fill_rect(fb, 0, 0, fb->vinfo.xres, fb->vinfo.yres, 0x000000);
+                render_scene(fb, &logo_scene, display_info, &options);
+                frames++;
+                elapsed = now_ns() - start;
+            } while (elapsed < MIN_BENCH_NS);
+
+            uint32_t max_diff = 0, over_one = 0;
+            for (size_t i = 0; i < fb->screensize; i++) {
+                uint32_t diff = abs(fb->screen[i] - reference[i]);
+                if (diff > max_diff) max_diff = diff;
+                if (diff > 1) over_one++;
+            }
+
+            printf("raster engine=%s %ux%u ms_per_frame=%.3f max_diff=%u bytes_over_1lsb=%u\n",
+                   engines[e].name, fb->vinfo.xres, fb->vinfo.yres, elapsed / frames / 1e6,
+                   max_diff, over_one);
+        }
+
+        free(reference);
+        free(display_info);
+        fb_cleanup(fb);
+    }
+
+    return 0;
+}
+
+/* Pixels that differ from a reference screen and the largest channel difference */
+static void compare_screen(const Framebuffer *fb, const uint8_t *reference, uint64_t *pixels,
+                           uint32_t *max_diff) {
+    const PixelFormat *fmt = &fb->format;
+    *pixels = 0;
+    *max_diff = 0;
+
+    for (uint32_t y = 0; y < fb->vinfo.yres; y++) {
+        size_t offset = (size_t)y * fb->finfo.line_length;
+        for (uint32_t x = 0; x < fb->vinfo.xres; x++, offset += fmt->bytes_per_pixel) {
+            uint32_t a = pixel_unpack(fmt, pixel_load(fmt, fb->pixels + offset));
+            uint32_t b = pixel_unpack(fmt, pixel_load(fmt, reference + offset));
+            if (a == b) {
+                continue;
+            }
+            (*pixels)++;
+            for (int shift = 0; shift <= 16; shift += 8) {
+                uint32_t diff = abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+                if (diff > *max_diff) *max_diff = diff;
+            }
+        }
+    }
+}
+
+/* Parse the logo from its SVG source at a tolerance
+ * paths: Receives the parsed paths, for free_svg_path()
+ * scene: Receives copies of them in drawing order
+ * Returns: 0 on success, -1 if a path does not parse
+ */
+static int parse_logo(float tolerance, SVGPath **paths, SVGPath *scene) {
+    for (unsigned int i = 0; i < logo_num_paths; i++) {
+        paths[i] = parse_svg_path(logo_path_data[i], logo_path_colors[i], tolerance);
+        if (!paths[i]) {
+            while (i > 0) free_svg_path(paths[--i]);
+            return -1;
+        }
+        scene[i] = *paths[i];
+    }
+    return 0;
+}
+
+/* Heap allocations of one render, -1 without the profiler built in */
+static int64_t count_render_allocations(Framebuffer *fb, const SVGScene *scene,
+                                        const DisplayInfo *display_info, const RenderOptions *options) {
+#ifdef SPLASH_NO_PROFILE
+    (void)fb;
+    (void)scene;
+    (void)display_info;
+    (void)options;
+    return -1;
+#else
+    bool was_enabled = prof_enabled;
+    prof_enabled = true;
+    uint64_t before = prof_count_get(PROF_ALLOCATIONS);
+    render_scene(fb, scene, display_info, options);
+    int64_t allocations = (int64_t)(prof_count_get(PROF_ALLOCATIONS) - before);
+    prof_enabled = was_enabled;
+    return allocations;
+#endif
+}
+
+/* Parse and render the logo over a matrix of modes, depths and rotations
+ * Every cell parses the SVG source at the tolerance of its resolution, then
+ * renders it with each engine on a single thread and compares the pixels
+ * with the reference engine. One line per engine and cell, all key=value.
+ */
+static int bench_matrix(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static const struct { uint32_t width, height; } modes[] = {
+        { 320, 240 }, { 640, 480 }, { 800, 480 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 },
+    };
+    static const uint32_t depths[] = { 16, 32 };
+    static const struct { const char *name; RenderAA aa; } engines[] = {
+        { "supersample", RENDER_AA_SUPERSAMPLE },
+        { "analytic", RENDER_AA_ANALYTIC },
+        { "fixed", RENDER_AA_FIXED },
+    };
+
+    SVGPath **paths = malloc(logo_num_paths * sizeof(SVGPath *));
+    SVGPath *scene_paths = malloc(logo_num_paths * sizeof(SVGPath));
+    if (!paths || !scene_paths) {
+        fprintf(stderr, "Failed to allocate benchmark buffers\n");
+        free(scene_paths);
+        free(paths);
+        return 1;
+    }
+
+    int status = 0;
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++) {
+            for (int rotation = 0; rotation < 360; rotation += 90) {
+                FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false,
+                                    modes[m].width, modes[m].height, depths[d], 0, 0 };
+                Framebuffer *fb = fb_init(&config);
+                DisplayInfo *display_info = fb ? calculate_display_info(fb, &logo_view_box, rotation) : NULL;
+                uint8_t *reference = fb ? malloc(fb->screensize) : NULL;
+                if (!fb || !display_info || !reference) {
+                    fprintf(stderr, "Failed to set up a %ux%u screen\n", modes[m].width, modes[m].height);
+                    free(reference);
+                    free(display_info);
+                    fb_cleanup(fb);
+                    status = 1;
+                    goto out;
+                }
+                uint64_t screen_pixels = (uint64_t)fb->vinfo.xres * fb->vinfo.yres;
+
+                // Parsing on its own, then once more for the scene that is drawn
+                float tolerance = render_flatten_tolerance(display_info);
+                uint64_t parses = 0;
+                double start = now_ns(), parse_ns;
+                do {
+                    if (parse_logo(tolerance, paths, scene_paths) != 0) {
+                        fprintf(stderr, "Failed to parse the logo\n");
+                        free(reference);
+                        free(display_info);
+                        fb_cleanup(fb);
+                        status = 1;
+                        goto out;
+                    }
+                    for (unsigned int i = 0; i < logo_num_paths; i++) {
+                        free_svg_path(paths[i]);
+                    }
+                    parses++;
+                    parse_ns = now_ns() - start;
+                } while (parse_ns < MATRIX_BENCH_NS);
+                if (parse_logo(tolerance, paths, scene_paths) != 0) {
+                    fprintf(stderr, "Failed to parse the logo\n");
+                    free(reference);
+                    free(display_info);
+                    fb_cleanup(fb);
+                    status = 1;
+                    goto out;
+                }
+                SVGScene scene = { scene_paths, logo_num_paths, 0.0f, 0.0f, 0.0f, 0.0f, logo_view_box };
+
+                RenderOptions options = { RENDER_AA_REFERENCE, rotation, NULL, false, NULL, false };
+                fb_fill_rect(fb, 0, 0, fb->vinfo.xres, fb->vinfo.yres, 0x000000);
+                render_scene(fb, &scene, display_info, &options);
+                memcpy(reference, fb->pixels, fb->screensize);
+
+                for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+                    options.aa = engines[e].aa;
+                    uint64_t frames = 0;
+                    double elapsed;
+                    start = now_ns();
+                    do {
+                        fb_fill_rect(fb, 0, 0, fb->vinfo.xres, fb->vinfo.yres, 0x000000);
+                        render_scene(fb, &scene, display_info, &options);
+                        frames++;
+                        elapsed = now_ns() - start;
+                    } while (elapsed < MATRIX_BENCH_NS);
+
+                    uint64_t diff_pixels;
+                    uint32_t max_diff;
+                    compare_screen(fb, reference, &diff_pixels, &max_diff);
+
+                    printf("matrix engine=%s width=%u height=%u bpp=%u rotation=%d parse_ms=%.3f "
+                           "ms_per_frame=%.3f ns_per_pixel=%.3f allocations=%lld diff_pixels=%llu max_diff=%u\n",
+                           engines[e].name, fb->vinfo.xres, fb->vinfo.yres, depths[d], rotation,
+                           parse_ns / parses / 1e6, elapsed / frames / 1e6, elapsed / frames / screen_pixels,
+                           (long long)count_render_allocations(fb, &scene, display_info, &options),
+                           (unsigned long long)diff_pixels, max_diff);
+                }
+
+                for (unsigned int i = 0; i < logo_num_paths; i++) {
+                    free_svg_path(paths[i]);
+                }
+                free(reference);
+                free(display_info);
+                fb_cleanup(fb);
+            }
+        }
+    }
+
+out:
+    free(scene_paths);
+    free(paths);
+    return status;
+}
+
+/* Rotated logo, blitted upright raster against turned geometry */
+static int bench_rotate(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static const struct { uint32_t width, height, bpp; } modes[] = {
+        { 480, 800, 16 }, { 1080, 1920, 16 }, { 1080, 1920, 32 },
+    };
+    static const struct { const char *name; bool geometry; } methods[] = {
+        { "blit", false },
+        { "geometry", true },
+    };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false,
+                            modes[m].width, modes[m].height, modes[m].bpp, 0, 0 };
+        Framebuffer *fb = fb_init(&config);
+        uint8_t *reference = fb ? malloc(fb->screensize) : NULL;
+        if (!fb || !reference) {
+            fprintf(stderr, "Failed to set up a %ux%u screen\n", modes[m].width, modes[m].height);
+            free(reference);
+            fb_cleanup(fb);
+            return 1;
+        }
+
+        for (int rotation = 90; rotation < 360; rotation += 90) {
+            DisplayInfo *display_info = calculate_display_info(fb, &logo_scene.view_box, rotation);
+            if (!display_info) {
+                fprintf(stderr, "Failed to calculate display information\n");
+                free(reference);
+                fb_cleanup(fb);
+                return 1;
+            }
+
+            for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+                RenderOptions options = { RENDER_AA_DEFAULT, rotation, NULL, methods[i].geometry,
+                                          NULL, false };
+                uint64_t frames = 0;
+                double start = now_ns(), elapsed;
+                do {
+                    fb_fill_rect(fb, 0, 0, fb->vinfo.xres, fb->vinfo.yres, 0x000000);
+                    render_scene(fb, &logo_scene, display_info, &options);
+                    frames++;
+                    elapsed = now_ns() - start;
+                } while (elapsed < MIN_BENCH_NS);
+
+                // Sampling differs along the turned axis, so a few pixels may differ
+                uint32_t max_diff = 0, over_one = 0;
+                if (i == 0) {
+                    memcpy(reference, fb->screen, fb->screensize);
+                } else {
+                    for (size_t j = 0; j < fb->screensize; j++) {
+                        uint32_t diff = abs(fb->screen[j] - reference[j]);
+                        if (diff > max_diff) max_diff = diff;
+                        if (diff > 1) over_one++;
+                    }
+                }
+
+                printf("rotate method=%s %ux%u bpp=%u rotation=%d ms_per_frame=%.3f max_diff=%u bytes_over_1lsb=%u\n",
+                       methods[i].name, fb->vinfo.xres, fb->vinfo.yres, modes[m].bpp, rotation,
+                       elapsed / frames / 1e6, max_diff, over_one);
+            }
+            free(display_info);
+        }
+
+        free(reference);
+        fb_cleanup(fb);
+    }
+
+    return 0;
+}
+
+/* Write a file of the synthetic device tree
+ * Returns: 0 on success, -1 on failure
+ */
+static int write_file(const char *dir, const char *name, const void *data, size_t len) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        return -1;
+    }
+    size_t written = fwrite(data, 1, len, fp);
+    return (fclose(fp) == 0 && written == len) ? 0 : -1;
+}
+
+/* Add a node with a compatible string and optionally a rotation */
+static int make_node(const char *path, const char *compatible, int rotation) {
+    static const unsigned char reg[8] = { 0x7e, 0x20, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00 };
+
+    if (mkdir(path, 0755) == -1 ||
+        write_file(path, "compatible", compatible, strlen(compatible) + 1) == -1 ||
+        write_file(path, "reg", reg, sizeof(reg)) == -1 ||
+        write_file(path, "status", "okay", 5) == -1) {
+        return -1;
+    }
+    if (rotation >= 0) {
+        unsigned char cell[4] = { 0, 0, (rotation >> 8) & 0xFF, rotation & 0xFF };
+        return write_file(path, "rotation", cell, sizeof(cell));
+    }
+    return 0;
+}
+
+/* Build a device tree shaped like a real board
+ * Thousands of bus devices, an overlay decoy rotation and a panel deep
+ * below its DSI host, plus a flattened blob to key the cache on.
+ */
+static int make_device_tree(const char *base) {
+    char path[1024];
+    char name[64];
+
+    snprintf(path, sizeof(path), "%s/tree", base);
+    if (make_node(path, "raspberrypi,4-model-b", -1) == -1) {
+        return -1;
+    }
+
+    // Overlay parameters named rotation that are not the panel's
+    snprintf(path, sizeof(path), "%s/tree/__overrides__", base);
+    if (make_node(path, "none", 270) == -1) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/tree/soc", base);
+    if (make_node(path, "simple-bus", -1) == -1) {
+        return -1;
+    }
+    for (int bus = 0; bus < DT_BUSES; bus++) {
+        snprintf(path, sizeof(path), "%s/tree/soc/bus@%x", base, bus);
+        if (make_node(path, "simple-bus", -1) == -1) {
+            return -1;
+        }
+        for (int dev = 0; dev < DT_DEVICES; dev++) {
+            snprintf(path, sizeof(path), "%s/tree/soc/bus@%x/device@%x", base, bus, dev);
+            if (make_node(path, "vendor,device", -1) == -1) {
+                return -1;
+            }
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/tree/soc/bus@%x/dsi@7e700000", base, DT_BUSES - 1);
+    if (make_node(path, "brcm,bcm2835-dsi1", -1) == -1) {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/tree/soc/bus@%x/dsi@7e700000/panel@0", base, DT_BUSES - 1);
+    if (make_node(path, "raspberrypi,7inch-touchscreen-panel", 90) == -1) {
+        return -1;
+    }
+
+    // Blob contents only matter for the checksum
+    static uint8_t blob[65536];
+    uint32_t state = 1;
+    for (size_t i = 0; i < sizeof(blob); i++) {
+        blob[i] = (uint8_t)bench_random(&state);
+    }
+    snprintf(name, sizeof(name), "fdt");
+    return write_file(base, name, blob, sizeof(blob));
+}
+
+/* Add /aliases pointing at the panel */
+static int make_aliases(const char *base) {
+    char path[1024];
+    char target[128];
+
+    snprintf(path, sizeof(path), "%s/tree/aliases", base);
+    snprintf(target, sizeof(target), "/soc/bus@%x/dsi@7e700000/panel@0", DT_BUSES - 1);
+    if (mkdir(path, 0755) == -1 ||
+        write_file(path, "serial0", "/soc/bus@0/device@0", 20) == -1 ||
+        write_file(path, "display0", target, strlen(target) + 1) == -1) {
+        return -1;
+    }
+    return 0;
+}
+
+/* nftw callback removing one entry */
+static int remove_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+/* Time dt_get_rotation() with one configuration */
+static void time_dt_lookup(const char *name, const DtConfig *config) {
+    uint64_t lookups = 0;
+    int rotation = 0;
+    double start = now_ns(), elapsed;
+    do {
+        rotation = dt_get_rotation(config);
+        lookups++;
+        elapsed = now_ns() - start;
+    } while (elapsed < MIN_BENCH_NS);
+
+    printf("dt lookup=%s nodes=%u us_per_lookup=%.3f rotation=%d\n", name,
+           DT_BUSES * (DT_DEVICES + 1) + 4, elapsed / lookups / 1e3, rotation);
+}
+
+/* Background layer against clearing every pixel through set_pixel() */
+static int bench_background(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static const struct { uint32_t width, height, bpp; } modes[] = {
+        { 1920, 1080, 16 }, { 1920, 1080, 32 }, { 3840, 2160, 32 },
+    };
+    static uint32_t tile[32 * 32];
+    for (uint32_t i = 0; i < 32 * 32; i++) {
+        tile[i] = ((i / 32 / 8 + i % 32 / 8) & 1) ? 0x283060 : 0x101828;
+    }
+    const Background kinds[] = {
+        { BACKGROUND_SOLID, 0x102040, 0, NULL, 0, 0 },
+        { BACKGROUND_GRADIENT, 0x102040, 0x805020, NULL, 0, 0 },
+        { BACKGROUND_TILE, 0, 0, tile, 32, 32 },
+    };
+    static const char *const kind_names[] = { "solid", "gradient", "tile" };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false,
+                            modes[m].width, modes[m].height, modes[m].bpp, 0, 0 };
+        Framebuffer *fb = fb_init(&config);
+        if (!fb) {
+            fprintf(stderr, "Failed to set up a %ux%u screen\n", modes[m].width, modes[m].height);
+            return 1;
+        }
+
+        // What the splash did before there was a background layer
+        uint64_t frames = 0;
+        double start = now_ns(), elapsed;
+        do {
+            for (uint32_t y = 0; y < fb->vinfo.yres; y++) {
+                for (uint32_t x = 0; x < fb->vinfo.xres; x++) {
+                    set_pixel(fb, x, y, 0x000000);
+                }
+            }
+            frames++;
+            elapsed = now_ns() - start;
+        } while (elapsed < MIN_BENCH_NS);
+        printf("background kind=set_pixel %ux%u-%u ms_per_frame=%.3f\n", fb->vinfo.xres, fb->vinfo.yres,
+               fb->vinfo.bits_per_pixel, elapsed / frames / 1e6);
+
+        for (int turns = 0; turns < 2; turns++) {
+            for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) {
+                frames = 0;
+                start = now_ns();
+                do {
+                    background_draw(fb, &kinds[k], turns, NULL, NULL);
+                    frames++;
+                    elapsed = now_ns() - start;
+                } while (elapsed < MIN_BENCH_NS);
+                printf("background kind=%s %ux%u-%u turns=%d ms_per_frame=%.3f\n", kind_names[k],
+                       fb->vinfo.xres, fb->vinfo.yres, fb->vinfo.bits_per_pixel, turns,
+                       elapsed / frames / 1e6);
+            }
+        }
+
+        fb_cleanup(fb);
+    }
+
+    return 0;
+}
+
+/* Status line atlas built once per size, and the cost of one string update
+ * Two strings alternate so every update clears and draws a new one.
+ */
+static int bench_text(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static const struct { uint32_t width, height, bpp; } modes[] = {
+        { 1920, 1080, 16 }, { 1920, 1080, 32 }, { 3840, 2160, 32 },
+    };
+    static const char *const strings[] = { "Mounting /home", "Starting network services" };
+    const Background gradient = { BACKGROUND_GRADIENT, 0x102040, 0x805020, NULL, 0, 0 };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false,
+                            modes[m].width, modes[m].height, modes[m].bpp, 0, 0 };
+        Framebuffer *fb = fb_init(&config);
+        if (!fb) {
+            fprintf(stderr, "Failed to set up a %ux%u screen\n", modes[m].width, modes[m].height);
+            return 1;
+        }
+
+        for (int turns = 0; turns < 2; turns++) {
+            DisplayInfo *display_info = calculate_display_info(fb, &logo_scene.view_box, turns * 90);
+            TextLine line;
+            double start = now_ns();
+            if (!display_info || text_line_init(&line, fb, display_info, turns * 90, &gradient) != 0) {
+                free(display_info);
+                fb_cleanup(fb);
+                return 1;
+            }
+            double atlas_ns = now_ns() - start;
+
+            uint64_t updates = 0;
+            double elapsed;
+            start = now_ns();
+            do {
+                text_line_draw(fb, &line, strings[updates & 1]);
+                updates++;
+                elapsed = now_ns() - start;
+            } while (elapsed < MIN_BENCH_NS);
+
+            printf("text %ux%u-%u turns=%d height=%u atlas_ms=%.3f us_per_update=%.3f\n",
+                   fb->vinfo.xres, fb->vinfo.yres, fb->vinfo.bits_per_pixel, turns, line.atlas.height,
+                   atlas_ns / 1e6, elapsed / updates / 1e3);
+
+            text_line_free(&line);
+            free(display_info);
+        }
+
+        fb_cleanup(fb);
+    }
+
+    return 0;
+}
+
+/* Device tree rotation lookup on a synthetic tree in a temporary directory */
+static int bench_dt(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    char base[] = "/tmp/splash-dt-XXXXXX";
+    if (!mkdtemp(base)) {
+        fprintf(stderr, "Failed to create a temporary directory: %m\n");
+        return 1;
+    }
+
+    char root[sizeof(base) + 8], blob[sizeof(base) + 8], cache[sizeof(base) + 8];
+    snprintf(root, sizeof(root), "%s/tree", base);
+    snprintf(blob, sizeof(blob), "%s/fdt", base);
+    snprintf(cache, sizeof(cache), "%s/cache", base);
+
+    int status = 0;
+    if (make_device_tree(base) == -1) {
+        fprintf(stderr, "Failed to build the device tree\n");
+        status = 1;
+    } else {
+        DtConfig uncached = { root, NULL, NULL };
+        DtConfig cached = { root, blob, cache };
+
+        // Without aliases the bounded walk has to find the panel
+        time_dt_lookup("walk", &uncached);
+        time_dt_lookup("walk_cached", &cached);
+
+        if (make_aliases(base) == -1) {
+            fprintf(stderr, "Failed to add aliases\n");
+            status = 1;
+        } else {
+            time_dt_lookup("aliases", &uncached);
+        }
+    }
+
+    nftw(base, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    return status;
+}
+
+/* Curve flattening at the tolerance of several resolutions */
+static int bench_flatten(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static const struct { uint32_t width, height; } modes[] = {
+        { 480, 272 }, { 800, 480 }, { 1920, 1080 }, { 3840, 2160 },
+    };
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false,
+                            modes[m].width, modes[m].height, 32, 0, 0 };
+        Framebuffer *fb = fb_init(&config);
+        DisplayInfo *display_info = fb ? calculate_display_info(fb, &logo_scene.view_box, 0) : NULL;
+        if (!display_info) {
+            fprintf(stderr, "Failed to set up a %ux%u screen\n", modes[m].width, modes[m].height);
+            fb_cleanup(fb);
+            return 1;
+        }
+        float tolerance = render_flatten_tolerance(display_info);
+
+        uint64_t parses = 0;
+        uint32_t points = 0;
+        double start = now_ns(), elapsed;
+        do {
+            SVGPath *svg = parse_svg_path(curve_path, "rgb(255,255,255)", tolerance);
+            if (!svg) {
+                fprintf(stderr, "Failed to parse the curve path\n");
+                free(display_info);
+                fb_cleanup(fb);
+                return 1;
+            }
+            points = 0;
+            for (uint32_t i = 0; i < svg->num_paths; i++) {
+                points += svg->paths[i].num_points;
+            }
+            free_svg_path(svg);
+            parses++;
+            elapsed = now_ns() - start;
+        } while (elapsed < MIN_BENCH_NS);
+
+        printf("flatten %ux%u tolerance=%.4f points=%u us_per_parse=%.3f\n",
+               modes[m].width, modes[m].height, tolerance, points, elapsed / parses / 1e3);
+        free(display_info);
+        fb_cleanup(fb);
+    }
+
+    return 0;
+}
+
+/* Write an SVG file of a grid of curved paths
+ * Returns: 0 on success, -1 on failure
+ */
+static int write_svg(const char *path, unsigned int num_paths) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        return -1;
+    }
+
+    unsigned int columns = 40;
+    fprintf(f, "<?xml version=\"1.0\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" "
+            "viewBox=\"0 0 %u %u\">\n", columns * 60, (num_paths + columns - 1) / columns * 60);
+    for (unsigned int i = 0; i < num_paths; i++) {
+        unsigned int x = i % columns * 60, y = i / columns * 60;
+        fprintf(f, "  <path style=\"fill:#%06x\" d=\"M %u %u c 10 -20 40 -20 50 0 s -10 40 -25 50 "
+                "q -20 -10 -25 -50 z m 15 10 a 10 10 0 1 0 20 0 a 10 10 0 1 0 -20 0 z\"/>\n",
+                (i * 2654435761u) & 0xffffff, x + 5, y + 15);
+    }
+    fprintf(f, "</svg>\n");
+    return fclose(f);
+}
+
+/* Open, lay out and load an SVG file as the splash does at boot
+ * Returns: Points of the scene, 0 on failure
+ */
+static uint64_t load_svg(const char *path, Framebuffer *fb) {
+    SvgFile *file = svg_open(path);
+    DisplayInfo *display_info = file ? calculate_display_info(fb, svg_view_box(file), 0) : NULL;
+    SVGScene *scene = display_info ? svg_load_scene(file, render_flatten_tolerance(display_info)) : NULL;
+    svg_close(file);
+    free(display_info);
+
+    uint64_t points = 0;
+    for (uint32_t i = 0; scene && i < scene->num_paths; i++) {
+        for (uint32_t j = 0; j < scene->paths[i].num_paths; j++) {
+            points += scene->paths[i].paths[j].num_points;
+        }
+    }
+    svg_free_scene(scene);
+    return points;
+}
+
+/* Heap allocations of one SVG load, -1 without the profiler built in */
+static int64_t count_load_allocations(const char *path, Framebuffer *fb) {
+#ifdef SPLASH_NO_PROFILE
+    (void)path;
+    (void)fb;
+    return -1;
+#else
+    bool was_enabled = prof_enabled;
+    prof_enabled = true;
+    uint64_t before = prof_count_get(PROF_ALLOCATIONS);
+    load_svg(path, fb);
+    int64_t allocations = (int64_t)(prof_count_get(PROF_ALLOCATIONS) - before);
+    prof_enabled = was_enabled;
+    return allocations;
+#endif
+}
+
+/* SVG file load time against the number of paths */
+static int bench_svg(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    char base[] = "/tmp/splash-svg-XXXXXX";
+    if (!mkdtemp(base)) {
+        fprintf(stderr, "Failed to create a temporary directory: %m\n");
+        return 1;
+    }
+    char path[sizeof(base) + 16];
+    snprintf(path, sizeof(path), "%s/logo.svg", base);
+
+    FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false, 1920, 1080, 32, 0, 0 };
+    Framebuffer *fb = fb_init(&config);
+    int status = fb ? 0 : 1;
+
+    static const unsigned int sizes[] = { 10, 100, 400, 1600 };
+    for (size_t i = 0; status == 0 && i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        struct stat st;
+        if (write_svg(path, sizes[i]) != 0 || stat(path, &st) != 0) {
+            fprintf(stderr, "Failed to write %s\n", path);
+            status = 1;
+            break;
+        }
+
+        uint64_t loads = 0, points = 0;
+        double start = now_ns(), elapsed;
+        do {
+            points = load_svg(path, fb);
+            if (points == 0) {
+                fprintf(stderr, "Failed to load %s\n", path);
+                status = 1;
+                break;
+            }
+            loads++;
+            elapsed = now_ns() - start;
+        } while (elapsed < MIN_BENCH_NS);
+
+        if (status == 0) {
+            printf("svg paths=%u bytes=%lld points=%llu allocations=%lld us_per_load=%.3f us_per_path=%.3f\n",
+                   sizes[i], (long long)st.st_size, (unsigned long long)points,
+                   (long long)count_load_allocations(path, fb),
+                   elapsed / loads / 1e3, elapsed / loads / 1e3 / sizes[i]);
+        }
+    }
+
+    unlink(path);
+    rmdir(base);
+    fb_cleanup(fb);
+    return status;
+}
+
+/* Pixel of the synthetic photograph, 0xAARRGGBB
+ * Smooth gradients with grain, so the encoder uses every kind of chunk.
+ * With alpha a disc fades out towards the corners.
+ */
+static uint32_t photo_pixel(uint32_t x, uint32_t y, uint32_t width, uint32_t height, bool alpha) {
+    uint32_t grain = ((x * 73856093u) ^ (y * 19349663u)) * 2654435761u >> 29;
+    uint32_t r = (x * 255 / width + grain) & 0xFF;
+    uint32_t g = (y * 255 / height + grain) & 0xFF;
+    uint32_t b = ((x + y) * 255 / (width + height)) ^ (((x / 64 + y / 64) & 1) ? 0x40 : 0);
+
+    uint32_t a = 255;
+    if (alpha) {
+        int64_t dx = (int64_t)x - width / 2, dy = (int64_t)y - height / 2;
+        int64_t d2 = dx * dx + dy * dy, r2 = (int64_t)height * height / 4;
+        a = (d2 < r2) ? 255 : (d2 < 2 * r2) ? (uint32_t)(255 * (2 * r2 - d2) / r2) : 0;
+    }
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+/* Encode the synthetic photograph as a QOI file, one pixel at a time */
+static int write_qoi(const char *path, uint32_t width, uint32_t height, bool alpha) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        return -1;
+    }
+
+    uint8_t header[14] = { 'q', 'o', 'i', 'f',
+                           width >> 24, width >> 16, width >> 8, width,
+                           height >> 24, height >> 16, height >> 8, height,
+                           alpha ? 4 : 3, 0 };
+    fwrite(header, 1, sizeof(header), fp);
+
+    uint32_t index[64] = { 0 }, prev = 0xFF000000, run = 0;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t px = photo_pixel(x, y, width, height, alpha);
+            bool last = y == height - 1 && x == width - 1;
+            if (px == prev) {
+                if (++run == 62 || last) {
+                    fputc(0xC0 | (run - 1), fp);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                fputc(0xC0 | (run - 1), fp);
+                run = 0;
+            }
+
+            uint32_t a = px >> 24, r = (px >> 16) & 0xFF, g = (px >> 8) & 0xFF, b = px & 0xFF;
+            uint32_t hash = (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+            if (index[hash] == px) {
+                fputc(hash, fp);
+            } else if (a != prev >> 24) {
+                fputc(0xFF, fp);
+                fputc(r, fp);
+                fputc(g, fp);
+                fputc(b, fp);
+                fputc(a, fp);
+            } else {
+                int dr = (int8_t)(r - ((prev >> 16) & 0xFF));
+                int dg = (int8_t)(g - ((prev >> 8) & 0xFF));
+                int db = (int8_t)(b - (prev & 0xFF));
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    fputc(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2), fp);
+                } else if (dg >= -32 && dg <= 31 && dr - dg >= -8 && dr - dg <= 7 &&
+                           db - dg >= -8 && db - dg <= 7) {
+                    fputc(0x80 | (dg + 32), fp);
+                    fputc((dr - dg + 8) << 4 | (db - dg + 8), fp);
+                } else {
+                    fputc(0xFE, fp);
+                    fputc(r, fp);
+                    fputc(g, fp);
+                    fputc(b, fp);
+                }
+            }
+            index[hash] = px;
+            prev = px;
+        }
+    }
+
+    static const uint8_t padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    fwrite(padding, 1, sizeof(padding), fp);
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+/* Decode a whole picture without drawing it
+ * errors: Receives the pixels that differ from the synthetic photograph, or NULL
+ * Returns: 0 on success, -1 if the data ends early
+ */
+static int decode_picture(const char *path, uint64_t *errors) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    uint8_t *data = malloc(size);
+    if (!data || fread(data, 1, size, fp) != (size_t)size) {
+        free(data);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    // Decoding from memory leaves page faults of the mapping out of the timing
+    QoiDecoder dec;
+    int status = qoi_decoder_init(&dec, data, size);
+    uint32_t *colors = malloc(dec.width * sizeof(uint32_t));
+    uint8_t *alpha = malloc(dec.width);
+    if (errors) *errors = 0;
+    for (uint32_t y = 0; status == 0 && y < dec.height; y++) {
+        status = (colors && alpha) ? qoi_decode_row(&dec, colors, alpha) : -1;
+        for (uint32_t x = 0; errors && status == 0 && x < dec.width; x++) {
+            uint32_t px = photo_pixel(x, y, dec.width, dec.height, dec.channels == 4);
+            uint32_t a = px >> 24;
+            *errors += colors[x] != composite_scale(px & 0xFFFFFF, a) || alpha[x] != a;
+        }
+    }
+
+    free(alpha);
+    free(colors);
+    free(data);
+    return status;
+}
+
+/* Time drawing a picture onto a screen of its own
+ * fit: Scale it to the logo area, otherwise it is drawn at its own size
+ *      or shrunk to the screen
+ */
+static int time_image_draw(const ImageFile *file, int channels, uint32_t width, uint32_t height, uint32_t bpp,
+                           int turns, bool fit) {
+    FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false, width, height, bpp, 0, 0 };
+    RenderOptions options = { RENDER_AA_DEFAULT, turns * 90, NULL, false, NULL, false };
+    Framebuffer *fb = fb_init(&config);
+    DisplayInfo *display_info = fb ? image_display_info(fb, file, turns * 90, fit) : NULL;
+    if (!display_info) {
+        fb_cleanup(fb);
+        return -1;
+    }
+
+    uint64_t frames = 0;
+    double start = now_ns(), elapsed;
+    int status = 0;
+    do {
+        status = image_draw(fb, file, display_info, &options);
+        frames++;
+        elapsed = now_ns() - start;
+    } while (status == 0 && elapsed < MIN_BENCH_NS);
+
+    uint64_t pixels = (uint64_t)display_info->svg_width * display_info->svg_height;
+    printf("image draw picture=%ux%u channels=%d screen=%ux%u-%u turns=%d output=%ux%u "
+           "ms_per_frame=%.3f ns_per_pixel=%.3f\n",
+           image_width(file), image_height(file), channels, width, height, bpp, turns,
+           display_info->svg_width, display_info->svg_height,
+           elapsed / frames / 1e6, elapsed / frames / pixels);
+
+    free(display_info);
+    fb_cleanup(fb);
+    return status;
+}
+
+/* QOI picture decode alone, then drawn at its own size, turned and scaled */
+static int bench_image(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    char base[] = "/tmp/splash-image-XXXXXX";
+    if (!mkdtemp(base)) {
+        fprintf(stderr, "Failed to create a temporary directory: %m\n");
+        return 1;
+    }
+    char path[sizeof(base) + 16];
+    snprintf(path, sizeof(path), "%s/splash.qoi", base);
+
+    static const struct { uint32_t width, height; } sizes[] = { { 1920, 1080 }, { 3840, 2160 } };
+    int status = 0;
+    for (size_t i = 0; status == 0 && i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t width = sizes[i].width, height = sizes[i].height;
+        for (int alpha = 0; status == 0 && alpha < 2; alpha++) {
+            struct stat st;
+            uint64_t errors;
+            if (write_qoi(path, width, height, alpha) != 0 || stat(path, &st) != 0 ||
+                decode_picture(path, &errors) != 0) {
+                fprintf(stderr, "Failed to write and decode %s\n", path);
+                status = 1;
+                break;
+            }
+
+            uint64_t frames = 0;
+            double start = now_ns(), elapsed;
+            do {
+                decode_picture(path, NULL);
+                frames++;
+                elapsed = now_ns() - start;
+            } while (elapsed < MIN_BENCH_NS);
+            printf("image decode picture=%ux%u channels=%d bytes=%lld ms_per_frame=%.3f ns_per_pixel=%.3f "
+                   "errors=%llu\n", width, height, alpha ? 4 : 3, (long long)st.st_size,
+                   elapsed / frames / 1e6, elapsed / frames / ((uint64_t)width * height),
+                   (unsigned long long)errors);
+
+            // Own size upright and turned, then shrunk onto the other size or fitted to its logo area
+            ImageFile *file = image_open(path);
+            uint32_t other = (i == 0) ? 1 : 0;
+            if (!file ||
+                time_image_draw(file, alpha ? 4 : 3, width, height, 32, 0, false) != 0 ||
+                time_image_draw(file, alpha ? 4 : 3, width, height, 16, 0, false) != 0 ||
+                time_image_draw(file, alpha ? 4 : 3, height, width, 32, 1, false) != 0 ||
+                time_image_draw(file, alpha ? 4 : 3, sizes[other].width, sizes[other].height, 32, 0, other == 1) != 0) {
+                fprintf(stderr, "Failed to draw %s\n", path);
+                status = 1;
+            }
+            image_close(file);
+        }
+    }
+
+    unlink(path);
+    rmdir(base);
+    return status;
+}
+
+/* Daemon thread of the latency benchmark */
+static void *run_daemon(void *daemon) {
+    splash_daemon_run(daemon);
+    return NULL;
+}
+
+/* Time one daemon command, from send until the reply after its flush
+ * The two commands alternate so every round trip changes the screen.
+ */
+static int time_daemon_command(const char *path, const char *name, const char *first, const char *second) {
+    char reply[SPLASH_DAEMON_MAX_MESSAGE];
+    uint64_t commands = 0;
+    double start = now_ns(), elapsed;
+    do {
+        if (splash_daemon_send(path, (commands & 1) ? second : first, reply, sizeof(reply)) != 0) {
+            fprintf(stderr, "Command failed: %s\n", reply);
+            return -1;
+        }
+        commands++;
+        elapsed = now_ns() - start;
+    } while (elapsed < MIN_BENCH_NS);
+
+    printf("daemon command=%s us_per_command=%.3f\n", name, elapsed / commands / 1e3);
+    return 0;
+}
+
+/* Command to pixel latency of the splash daemon on a flipped memory framebuffer */
+static int bench_daemon(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    char base[] = "/tmp/splash-daemon-XXXXXX";
+    if (!mkdtemp(base)) {
+        fprintf(stderr, "Failed to create a temporary directory: %m\n");
+        return 1;
+    }
+    char path[sizeof(base) + 8];
+    snprintf(path, sizeof(path), "%s/sock", base);
+
+    FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false, 1920, 1080, 32, 0, 2 };
+    RenderOptions options = { RENDER_AA_DEFAULT, 0, NULL, false, NULL, false };
+    Framebuffer *fb = fb_init(&config);
+    DisplayInfo *display_info = fb ? calculate_display_info(fb, &logo_scene.view_box, 0) : NULL;
+    SplashDaemon *daemon = NULL;
+    int status = 1;
+
+    if (display_info) {
+        render_scene(fb, &logo_scene, display_info, &options);
+        fb_flush(fb);
+        daemon = splash_daemon_create(path, fb, display_info, &logo_scene, &options, NULL);
+    }
+
+    pthread_t thread;
+    if (daemon && pthread_create(&thread, NULL, run_daemon, daemon) == 0) {
+        status = 0;
+        if (time_daemon_command(path, "progress", "progress 25", "progress 75") != 0 ||
+            time_daemon_command(path, "status", "status Mounting", "status Starting") != 0 ||
+            time_daemon_command(path, "logo", "logo shutdown", "logo boot") != 0) {
+            status = 1;
+        }
+        printf("daemon mode=%s %ux%u bpp=%u\n", fb->mode == FB_OUTPUT_FLIP ? "flip" : "mmap",
+               fb->vinfo.xres, fb->vinfo.yres, fb->vinfo.bits_per_pixel);
+
+        char reply[SPLASH_DAEMON_MAX_MESSAGE];
+        splash_daemon_send(path, "quit", reply, sizeof(reply));
+        pthread_join(thread, NULL);
+    } else {
+        fprintf(stderr, "Failed to start the daemon\n");
+    }
+
+    splash_daemon_destroy(daemon);
+    free(display_info);
+    fb_cleanup(fb);
+    rmdir(base);
+    return status;
+}
+
+static const BenchCommand commands[] = {
+    { "resolve", "Coverage resolve and RGB565 pack kernels", bench_resolve },
+    { "blend", "Edge blending per pixel, float calls against span kernels", bench_blend },
+    { "raster", "Logo render time per anti-aliasing engine against the reference", bench_raster },
+    { "matrix", "Parse and render per mode, depth and rotation against the reference", bench_matrix },
+    { "rotate", "Rotated logo, blitted raster against turned geometry", bench_rotate },
+    { "background", "Background layer per kind against a per-pixel clear", bench_background },
+    { "text", "Status line atlas build and update time", bench_text },
+    { "dt", "Device tree rotation lookup", bench_dt },
+    { "flatten", "Curve flattening points and time per resolution", bench_flatten },
+    { "svg", "SVG file load time against the number of paths", bench_svg },
+    { "image", "QOI picture decode and draw time at 1080p and 4K", bench_image },
+    { "daemon", "Daemon command to pixel latency", bench_daemon },
+};
+
+#define NUM_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+/* Print command line usage */
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [benchmark...]\n", prog);
+    for (size_t i = 0; i < NUM_COMMANDS; i++) {
+        fprintf(stderr, "  %-10s %s\n", commands[i].name, commands[i].help);
+    }
+    fprintf(stderr, "Without a benchmark name all of them run.\n");
+}
+
+/*
+ * Benchmark entry point, runs the named benchmark or all of them
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        int status = 0;
+        for (size_t i = 0; i < NUM_COMMANDS; i++) {
+            status |= commands[i].run(0, NULL);
+        }
+        return status;
+    }
+
+    for (size_t i = 0; i < NUM_COMMANDS; i++) {
+        if (strcmp(argv[1], commands[i].name) == 0) {
+            return commands[i].run(argc - 1, argv + 1);
+        }
+    }
+
+    usage(argv[0]);
+    return (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#include <math.h>
+#include <pthread.h>
+#include "composite.h"
+
+#define FULL_COVERAGE 0.98   // Coverage drawn with the plain fill color
+
+static CompositeTables tables;
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+/* sRGB transfer function, both ways, on values from 0 to 1 */
+static double srgb_to_linear(double v) {
+    return (v <= 0.04045) ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4);
+}
+
+static double linear_to_srgb(double v) {
+    return (v <= 0.0031308) ? v * 12.92 : 1.055 * pow(v, 1.0 / 2.4) - 0.055;
+}
+
+/* Fill in every table once */
+static void build_tables(void) {
+    for (int i = 0; i < 256; i++) {
+        double c = i / 255.0;
+        double t = (c < 0.5) ? 2 * c * c : 1 - 2 * (1 - c) * (1 - c);
+        tables.vibrancy[i] = (c > FULL_COVERAGE) ? 255 : (uint8_t)(t * 255 + 0.5);
+
+        tables.linear[i] = (uint16_t)(srgb_to_linear(c) * COMPOSITE_LINEAR_ONE + 0.5);
+        tables.unpremultiply[i] = i ? ((255u << 16) + i / 2) / i : 0;
+    }
+    for (int i = 0; i <= COMPOSITE_LINEAR_ONE; i++) {
+        tables.srgb[i] = (uint8_t)(linear_to_srgb((double)i / COMPOSITE_LINEAR_ONE) * 255 + 0.5);
+    }
+}
+
+/* Tables, built on the first call */
+const CompositeTables *composite_tables(void) {
+    pthread_once(&tables_once, build_tables);
+    return &tables;
+}
+
+/* Put a path over a premultiplied scene row
+ * Opaque pixels replace what is below, which covers the inside of shapes,
+ * so only edges pay for the blend.
+ */
+void composite_span(uint8_t *coverage, uint32_t *colors, uint8_t *alpha, uint32_t count,
+                    uint32_t fill_color) {
+    const uint8_t *vibrancy = composite_tables()->vibrancy;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t a = vibrancy[coverage[i]];
+        coverage[i] = 0;
+        if (a == 0) {
+            continue;
+        }
+        if (a == 255) {
+            colors[i] = fill_color;
+            alpha[i] = 255;
+            continue;
+        }
+
+        uint32_t ia = 255 - a;
+        uint32_t below = colors[i];
+        colors[i] = composite_scale(fill_color, a) + composite_scale(below, ia);
+        alpha[i] = (uint8_t)(a + composite_div255(alpha[i] * ia));
+    }
+}
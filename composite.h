@@ -0,0 +1,52 @@
+#ifndef COMPOSITE_H
+#define COMPOSITE_H
+
+#include <stdint.h>
+
+/* Premultiplied alpha compositing
+ * Scene rows hold 0xRRGGBB colors already scaled by their 8-bit alpha, so
+ * putting one layer over another is one multiply and add per channel:
+ *   result = source + destination * (255 - source alpha) / 255
+ * A pixel no layer has drawn is 0 with alpha 0. Coverage reaches alpha
+ * through the vibrancy curve, which is read from a table like everything
+ * else here, so no pixel needs floating point:
+ *   t = c < 0.5 ? 2c^2 : 1 - 2(1 - c)^2, above 0.98 the pixel is opaque
+ * Over black this gives the fill color scaled by t, the look of the splash
+ * before it had backgrounds. Layers are combined in sRGB values, only the
+ * final composite onto the screen can run in linear light.
+ */
+
+/* 1.0 in linear light */
+#define COMPOSITE_LINEAR_ONE 4095
+
+typedef struct {
+    uint8_t vibrancy[256];        // 8-bit coverage to alpha
+    uint16_t linear[256];         // sRGB channel to linear light
+    uint8_t srgb[COMPOSITE_LINEAR_ONE + 1];  // Linear light back to sRGB, rounded
+    uint32_t unpremultiply[256];  // 255 / alpha in 16.16 fixed point, 0 for alpha 0
+} CompositeTables;
+
+/* Tables, built on the first call from any thread */
+const CompositeTables *composite_tables(void);
+
+/* x / 255 rounded, for x up to 255 * 255 */
+static inline uint32_t composite_div255(uint32_t x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+/* Scale a 0xRRGGBB color by an 8-bit alpha, premultiplying it */
+static inline uint32_t composite_scale(uint32_t color, uint32_t a) {
+    return (composite_div255(((color >> 16) & 0xFF) * a) << 16) |
+           (composite_div255(((color >> 8) & 0xFF) * a) << 8) |
+           composite_div255((color & 0xFF) * a);
+}
+
+/* Put a path over a premultiplied scene row
+ * coverage: 8-bit coverage of the path from the resolve kernels, cleared
+ * colors, alpha: Scene row, updated where the path has coverage
+ */
+void composite_span(uint8_t *coverage, uint32_t *colors, uint8_t *alpha, uint32_t count,
+                    uint32_t fill_color);
+
+#endif
@@ -1,78 +1,361 @@
 #include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "dt_rotation.h"
+#include "hash.h"
 
-/* Path to device tree directory */
-#define DEVICE_TREE_PATH "/proc/device-tree"
 #define MAX_PATH_LEN 1024
+#define MAX_WALK_DEPTH 8        // Panels sit a few levels below the root
+#define MAX_WALK_NODES 4096     // Nodes the fallback walk visits at most
+#define MAX_COMPATIBLE 256      // Bytes of a compatible property that are checked
 
-/* Internal function to search directory recursively */
-static int search_rotation_in_dir(const char *dir_path) {
-    DIR *dir;
-    struct dirent *entry;
-    char full_path[MAX_PATH_LEN];
-    unsigned char rotation_bytes[4];
-    int rotation = 0;
-    FILE *fp;
+#define DT_CACHE_MAGIC 0x54445355   // "USDT"
+#define DT_CACHE_VERSION 2
+
+/* Cached lookup result */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t root_hash;      // Hash of the root path the lookup ran on
+    uint32_t blob_size;      // Size and checksum of the flattened tree
+    uint64_t blob_sum;
+    int32_t rotation;
+    uint32_t reserved;
+} DtCacheEntry;
+
+/* Alias name prefixes that can lead to a display
+ * The alias may name a DSI host or display controller rather than the
+ * panel itself, so its target is still checked with is_panel_node().
+ */
+static const char *const display_aliases[] = { "panel", "display", "lcd", "dsi", NULL };
+
+/* Bounded fallback walk state */
+typedef struct {
+    unsigned int nodes;      // Nodes visited so far
+    int fallback;            // First rotation outside a panel node, -1 if none
+} DtWalk;
+
+/* Normalize a rotation to 90-degree increments */
+static int normalize_rotation(int32_t rotation) {
+    rotation %= 360;
+    if (rotation < 0) {
+        rotation += 360;
+    }
+    return (rotation / 90) * 90;
+}
+
+/* Path of a property or child of a node
+ * Returns: false if it does not fit in MAX_PATH_LEN
+ */
+static bool node_path(char *buf, const char *node, const char *name) {
+    return snprintf(buf, MAX_PATH_LEN, "%s/%s", node, name) < MAX_PATH_LEN;
+}
+
+/* Read a property file
+ * Returns: Bytes read or -1 if it does not exist
+ */
+static ssize_t read_property(const char *path, void *buf, size_t size) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    ssize_t len = read(fd, buf, size);
+    close(fd);
+    return len;
+}
 
-    dir = opendir(dir_path);
+/* Read the rotation property of a node
+ * Returns: Normalized rotation or -1 if the node has none
+ */
+static int read_rotation(const char *node) {
+    char path[MAX_PATH_LEN];
+    unsigned char bytes[4];
+
+    if (!node_path(path, node, "rotation") || read_property(path, bytes, sizeof(bytes)) != 4) {
+        return -1;
+    }
+
+    // Properties are big-endian cells
+    int32_t rotation = (int32_t)(((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+                                 ((uint32_t)bytes[2] << 8) | bytes[3]);
+    return normalize_rotation(rotation);
+}
+
+/* Whether a node name is a panel, "panel" or "panel@unit" by convention */
+static bool is_panel_name(const char *name) {
+    return strncmp(name, "panel", 5) == 0 && (name[5] == '\0' || name[5] == '@');
+}
+
+/* Whether a compatible string names a panel
+ * "panel" has to be a word of it, as in panel-simple, simple-panel or
+ * vendor,model-panel. Hosts like vendor,dsi or vendor,display-subsystem
+ * carry a rotation of their own at times and do not match.
+ */
+static bool is_panel_compatible(const char *compatible) {
+    for (const char *p = compatible; (p = strstr(p, "panel")) != NULL; p += 5) {
+        bool starts = p == compatible || p[-1] == ',' || p[-1] == '-';
+        bool ends = p[5] == '\0' || p[5] == '-';
+        if (starts && ends) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Whether a node is a panel by name or compatible string */
+static bool is_panel_node(const char *node, const char *name) {
+    if (is_panel_name(name)) {
+        return true;
+    }
+
+    char path[MAX_PATH_LEN];
+    char compatible[MAX_COMPATIBLE + 1];
+    ssize_t len = node_path(path, node, "compatible") ?
+                  read_property(path, compatible, MAX_COMPATIBLE) : -1;
+    if (len <= 0) {
+        return false;
+    }
+    compatible[len] = '\0';
+
+    // The property is a list of NUL terminated strings
+    for (ssize_t i = 0; i < len; i += strlen(compatible + i) + 1) {
+        if (is_panel_compatible(compatible + i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Rotation of a panel node or of a panel directly below it
+ * A node that is not a panel itself, such as a DSI host, is only looked into.
+ * Returns: Rotation or -1 if neither has one
+ */
+static int node_or_child_rotation(const char *node) {
+    const char *name = strrchr(node, '/');
+    int rotation = is_panel_node(node, name ? name + 1 : node) ? read_rotation(node) : -1;
+    if (rotation >= 0) {
+        return rotation;
+    }
+
+    DIR *dir = opendir(node);
     if (!dir) {
-        return 0;
+        return -1;
     }
 
+    struct dirent *entry;
+    char child[MAX_PATH_LEN];
     while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_name[0] == '.') {
+        if (entry->d_name[0] == '.' || !node_path(child, node, entry->d_name) ||
+            !is_panel_node(child, entry->d_name)) {
+            continue;
+        }
+        rotation = read_rotation(child);
+        if (rotation >= 0) {
+            break;
+        }
+    }
+
+    closedir(dir);
+    return rotation;
+}
+
+/* Whether an alias name starts with one of the display prefixes */
+static bool is_display_alias(const char *name) {
+    for (int i = 0; display_aliases[i]; i++) {
+        if (strncmp(name, display_aliases[i], strlen(display_aliases[i])) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Check the display nodes named by /aliases
+ * Returns: Rotation or -1 if no alias leads to one
+ */
+static int search_aliases(const char *root) {
+    char path[MAX_PATH_LEN];
+    char aliases[MAX_PATH_LEN];
+    if (!node_path(aliases, root, "aliases")) {
+        return -1;
+    }
+
+    DIR *dir = opendir(aliases);
+    if (!dir) {
+        return -1;
+    }
+
+    int rotation = -1;
+    struct dirent *entry;
+    while (rotation < 0 && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.' || !is_display_alias(entry->d_name) ||
+            !node_path(path, aliases, entry->d_name)) {
+            continue;
+        }
+
+        // Alias values are absolute node paths
+        char target[MAX_PATH_LEN];
+        ssize_t len = read_property(path, target, sizeof(target) - 1);
+        if (len <= 0 || target[0] != '/') {
             continue;
         }
+        target[len] = '\0';
 
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
-
-        if (entry->d_type == DT_DIR) {
-            /* Recursively search subdirectory */
-            rotation = search_rotation_in_dir(full_path);
-            if (rotation != 0) {
-                closedir(dir);
-                return rotation;
-            }
-        } else if (strcmp(entry->d_name, "rotation") == 0) {
-            fp = fopen(full_path, "r");
-            if (fp) {
-                if (fread(rotation_bytes, 1, 4, fp) == 4) {
-                    /* Convert big-endian bytes to integer */
-                    rotation = (rotation_bytes[0] << 24) |
-                             (rotation_bytes[1] << 16) |
-                             (rotation_bytes[2] << 8) |
-                             (rotation_bytes[3]);
-
-                    /* Normalize rotation to 90-degree increments */
-                    rotation = rotation % 360;
-                    if (rotation < 0) {
-                        rotation += 360;
-                    }
-                    rotation = (rotation / 90) * 90;
-
-                    fclose(fp);
-                    closedir(dir);
-                    return rotation;
-                }
-                fclose(fp);
-            }
+        if (snprintf(path, sizeof(path), "%s%s", root, target) < (int)sizeof(path)) {
+            rotation = node_or_child_rotation(path);
         }
     }
 
     closedir(dir);
-    return 0;
+    return rotation;
 }
 
-/* Get display rotation from device tree
- * Returns: rotation angle in degrees (0, 90, 180, or 270)
- *
- * This function recursively traverses the device tree directory
- * structure looking for a file named "rotation". When found, it
- * reads a 4-byte big-endian integer value and normalizes it to
- * 0, 90, 180, or 270 degrees.
+/* Walk the tree depth first within the node budget
+ * Returns: Rotation of the first panel node found, or -1
  */
+static int walk_tree(const char *node, const char *name, int depth, DtWalk *walk) {
+    if (++walk->nodes > MAX_WALK_NODES) {
+        return -1;
+    }
+
+    int rotation = read_rotation(node);
+    if (rotation >= 0) {
+        if (is_panel_node(node, name)) {
+            return rotation;
+        }
+        if (walk->fallback < 0) {
+            walk->fallback = rotation;
+        }
+    }
+
+    if (depth == MAX_WALK_DEPTH) {
+        return -1;
+    }
+
+    DIR *dir = opendir(node);
+    if (!dir) {
+        return -1;
+    }
+
+    rotation = -1;
+    struct dirent *entry;
+    char child[MAX_PATH_LEN];
+    while (rotation < 0 && (entry = readdir(dir)) != NULL) {
+        // Overlay bookkeeping like __overrides__ holds parameter names, not hardware
+        if (entry->d_name[0] == '.' || strncmp(entry->d_name, "__", 2) == 0) {
+            continue;
+        }
+        if ((entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) ||
+            !node_path(child, node, entry->d_name)) {
+            continue;
+        }
+
+        rotation = walk_tree(child, entry->d_name, depth + 1, walk);
+        if (walk->nodes > MAX_WALK_NODES) {
+            break;
+        }
+    }
+
+    closedir(dir);
+    return rotation;
+}
+
+/* Walk the tree for the rotation */
+static int walk_rotation(const char *root) {
+    DtWalk walk = { 0, -1 };
+    int rotation = walk_tree(root, "", 0, &walk);
+    if (rotation >= 0) {
+        return rotation;
+    }
+    return walk.fallback >= 0 ? walk.fallback : 0;
+}
+
+/* Checksum the flattened tree
+ * FNV-1a steps over 64-bit words rather than bytes, the blob is read on
+ * every boot and only has to tell one tree from another.
+ * Returns: 0 on success, -1 if it cannot be read
+ */
+static int checksum_blob(const char *path, uint32_t *size, uint64_t *sum) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+
+    uint64_t buf[2048];
+    ssize_t len;
+    *size = 0;
+    *sum = 14695981039346656037ull;
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        size_t words = len / sizeof(uint64_t);
+        for (size_t i = 0; i < words; i++) {
+            *sum = (*sum ^ buf[i]) * 1099511628211ull;
+        }
+        for (size_t i = words * sizeof(uint64_t); i < (size_t)len; i++) {
+            *sum = (*sum ^ ((uint8_t *)buf)[i]) * 1099511628211ull;
+        }
+        *size += len;
+    }
+    close(fd);
+    return (len < 0 || *size == 0) ? -1 : 0;
+}
+
+/* Store a lookup result, written to a temporary file and renamed into place
+ * /run may not be writable this early, the cache is then just skipped.
+ */
+static void store_cache(const char *path, const DtCacheEntry *entry) {
+    char tmp[MAX_PATH_LEN];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        return;
+    }
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return;
+    }
+    bool ok = write(fd, entry, sizeof(*entry)) == (ssize_t)sizeof(*entry);
+    close(fd);
+
+    if (!ok || rename(tmp, path) == -1) {
+        unlink(tmp);
+    }
+}
+
+/* Get display rotation from a device tree
+ * Aliases are a handful of reads and need no cache, only the walk is cached.
+ */
+int dt_get_rotation(const DtConfig *config) {
+    int rotation = search_aliases(config->root);
+    if (rotation >= 0) {
+        return rotation;
+    }
+
+    DtCacheEntry key = { DT_CACHE_MAGIC, DT_CACHE_VERSION, 0, 0, 0, 0, 0 };
+    bool cacheable = config->cache && config->blob &&
+                     checksum_blob(config->blob, &key.blob_size, &key.blob_sum) == 0;
+    key.root_hash = hash_bytes(HASH_SEED, config->root, strlen(config->root));
+
+    if (cacheable) {
+        DtCacheEntry entry;
+        if (read_property(config->cache, &entry, sizeof(entry)) == (ssize_t)sizeof(entry) &&
+            entry.magic == key.magic && entry.version == key.version &&
+            entry.root_hash == key.root_hash && entry.blob_size == key.blob_size &&
+            entry.blob_sum == key.blob_sum) {
+            return normalize_rotation(entry.rotation);
+        }
+    }
+
+    key.rotation = walk_rotation(config->root);
+    if (cacheable) {
+        store_cache(config->cache, &key);
+    }
+    return key.rotation;
+}
+
+/* Get display rotation from the device tree of the running system */
 int get_display_rotation(void) {
-    return search_rotation_in_dir(DEVICE_TREE_PATH);
+    static const DtConfig config = { DT_DEFAULT_ROOT, DT_DEFAULT_BLOB, DT_DEFAULT_CACHE };
+    return dt_get_rotation(&config);
 }
@@ -1,8 +1,28 @@
 #ifndef DT_ROTATION_H
 #define DT_ROTATION_H
 
-/* Get display rotation from device tree
- * Recursively searches /proc/device-tree for rotation property
+/* Default device tree locations */
+#define DT_DEFAULT_ROOT "/proc/device-tree"
+#define DT_DEFAULT_BLOB "/sys/firmware/fdt"
+#define DT_DEFAULT_CACHE "/run/unofficialos-splash.dt"
+
+/* Where to look up the rotation */
+typedef struct {
+    const char *root;   // Device tree directory
+    const char *blob;   // Flattened tree the cache is keyed on, NULL disables the cache
+    const char *cache;  // Cache file, NULL disables the cache
+} DtConfig;
+
+/* Get display rotation from a device tree
+ * Panels named by /aliases, or directly below the display nodes they
+ * name, are checked first. Then a bounded walk prefers the rotation of a
+ * panel node, one named panel or with a panel compatible string.
+ * A walk result is cached, keyed by the checksum of the flattened tree.
+ * Returns: rotation angle in degrees (0, 90, 180, or 270), 0 if none is found
+ */
+int dt_get_rotation(const DtConfig *config);
+
+/* Get display rotation from the device tree of the running system
  * Returns: rotation angle in degrees (0, 90, 180, or 270)
  */
 int get_display_rotation(void);
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include "fbsplash.h"
+
+/* Default mode for backends without a real display */
+#define DEFAULT_WIDTH 1920
+#define DEFAULT_HEIGHT 1080
+#define DEFAULT_BPP 32
+
+/* Fill in screen information for a synthetic display
+ * Uses XRGB8888 for 32 bpp, RGB888 for 24 bpp, RGB565 for 16 bpp
+ * and an RGB332 palette for 8 bpp
+ */
+static int fake_screeninfo(Framebuffer *fb, const FbConfig *config, const char *id) {
+    uint32_t width = config->width ? config->width : DEFAULT_WIDTH;
+    uint32_t height = config->height ? config->height : DEFAULT_HEIGHT;
+    uint32_t bpp = config->bpp ? config->bpp : DEFAULT_BPP;
+
+    if (bpp != 8 && bpp != 16 && bpp != 24 && bpp != 32) {
+        fprintf(stderr, "Unsupported bits per pixel: %u\n", bpp);
+        return -1;
+    }
+
+    uint32_t pages = config->pages > 1 ? config->pages : 1;
+    uint32_t stride = config->stride ? config->stride : width * (bpp / 8);
+    if (stride < width * (bpp / 8)) {
+        fprintf(stderr, "Line stride %u too small for %u pixels at %u bpp\n", stride, width, bpp);
+        return -1;
+    }
+
+    struct fb_var_screeninfo *v = &fb->vinfo;
+    v->xres = v->xres_virtual = width;
+    v->yres = height;
+    v->yres_virtual = height * pages;
+    v->bits_per_pixel = bpp;
+
+    if (bpp >= 24) {
+        v->red.offset = 16;    v->red.length = 8;
+        v->green.offset = 8;   v->green.length = 8;
+        v->blue.offset = 0;    v->blue.length = 8;
+        if (bpp == 32) {
+            v->transp.offset = 24; v->transp.length = 8;
+        }
+    } else if (bpp == 16) {
+        v->red.offset = 11;    v->red.length = 5;
+        v->green.offset = 5;   v->green.length = 6;
+        v->blue.offset = 0;    v->blue.length = 5;
+    }
+
+    struct fb_fix_screeninfo *f = &fb->finfo;
+    strncpy(f->id, id, sizeof(f->id) - 1);
+    f->type = FB_TYPE_PACKED_PIXELS;
+    f->visual = (bpp == 8) ? FB_VISUAL_PSEUDOCOLOR : FB_VISUAL_TRUECOLOR;
+    f->line_length = stride;
+    f->smem_len = stride * height * pages;
+
+    return 0;
+}
+
+/* Load an RGB332 palette so 8-bit pixels can be packed like true color */
+static void fbdev_load_palette(Framebuffer *fb) {
+    uint16_t red[256], green[256], blue[256];
+    for (int i = 0; i < 256; i++) {
+        red[i] = ((i >> 5) & 0x7) * 0xFFFF / 7;
+        green[i] = ((i >> 2) & 0x7) * 0xFFFF / 7;
+        blue[i] = (i & 0x3) * 0xFFFF / 3;
+    }
+
+    struct fb_cmap cmap = { 0, 256, red, green, blue, NULL };
+    if (ioctl(fb->fd, FBIOPUTCMAP, &cmap) == -1) {
+        fprintf(stderr, "Failed to set palette: %m\n");
+    }
+}
+
+/* Open a Linux fbdev device, optionally switching to the requested mode */
+static int fbdev_open(Framebuffer *fb, const FbConfig *config) {
+    const char *device = config->path ? config->path : "/dev/fb0";
+
+    // Open the framebuffer device
+    fb->fd = open(device, O_RDWR);
+    if (fb->fd == -1) {
+        fprintf(stderr, "Failed to open framebuffer device %s: %m\n", device);
+        return -1;
+    }
+
+    // Get variable screen information
+    if (ioctl(fb->fd, FBIOGET_VSCREENINFO, &fb->vinfo) == -1) {
+        fprintf(stderr, "Failed to get variable screen info: %m\n");
+        close(fb->fd);
+        return -1;
+    }
+
+    // Switch mode if one was requested, the driver may adjust it
+    uint32_t pages = config->pages > 1 ? config->pages : 1;
+    uint32_t yres = config->height ? config->height : fb->vinfo.yres;
+    if (config->width || config->height || config->bpp || fb->vinfo.yres_virtual < yres * pages) {
+        struct fb_var_screeninfo want = fb->vinfo;
+        if (config->width) {
+            want.xres = want.xres_virtual = config->width;
+        }
+        if (config->height) {
+            want.yres = config->height;
+            if (want.yres_virtual < want.yres) {
+                want.yres_virtual = want.yres;
+            }
+        }
+        if (config->bpp) {
+            want.bits_per_pixel = config->bpp;
+        }
+        if (want.yres_virtual < yres * pages) {
+            want.yres_virtual = yres * pages;
+        }
+        want.activate = FB_ACTIVATE_NOW;
+
+        if (ioctl(fb->fd, FBIOPUT_VSCREENINFO, &want) == -1 ||
+            ioctl(fb->fd, FBIOGET_VSCREENINFO, &fb->vinfo) == -1) {
+            fprintf(stderr, "Failed to set requested mode, keeping current: %m\n");
+        }
+    }
+
+    // Get fixed screen information
+    if (ioctl(fb->fd, FBIOGET_FSCREENINFO, &fb->finfo) == -1) {
+        fprintf(stderr, "Failed to get fixed screen info: %m\n");
+        close(fb->fd);
+        return -1;
+    }
+
+    if (fb->vinfo.bits_per_pixel == 8 && fb->finfo.visual != FB_VISUAL_TRUECOLOR) {
+        fbdev_load_palette(fb);
+    }
+
+    if (config->stride && config->stride != fb->finfo.line_length) {
+        fprintf(stderr, "Driver line stride is %u, ignoring requested %u\n",
+                fb->finfo.line_length, config->stride);
+    }
+
+    // Map the device memory, used as drawing target or as flush destination
+    size_t size = fb->vinfo.yres_virtual * fb->finfo.line_length;
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+    fb->screen = (map == MAP_FAILED) ? NULL : map;
+
+    return 0;
+}
+
+/* Show the virtual screen from row yoffset on */
+static int fbdev_pan(Framebuffer *fb, uint32_t yoffset) {
+    struct fb_var_screeninfo v = fb->vinfo;
+    v.yoffset = yoffset;
+    if (ioctl(fb->fd, FBIOPAN_DISPLAY, &v) == -1) {
+        return -1;
+    }
+    fb->vinfo.yoffset = yoffset;
+    return 0;
+}
+
+/* Unmap and close the fbdev device */
+static void fbdev_close(Framebuffer *fb) {
+    if (fb->screen) {
+        munmap(fb->screen, fb->screensize);
+    }
+    if (fb->fd >= 0) {
+        close(fb->fd);
+    }
+}
+
+/* Use anonymous memory as the screen */
+static int memory_open(Framebuffer *fb, const FbConfig *config) {
+    if (fake_screeninfo(fb, config, "memory") != 0) {
+        return -1;
+    }
+
+    fb->screen = calloc(1, fb->finfo.smem_len);
+    if (!fb->screen) {
+        fprintf(stderr, "Failed to allocate memory screen\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Memory screens pan by just moving the visible origin */
+static int memory_pan(Framebuffer *fb, uint32_t yoffset) {
+    fb->vinfo.yoffset = yoffset;
+    return 0;
+}
+
+/* Release the memory screen */
+static void memory_close(Framebuffer *fb) {
+    free(fb->screen);
+}
+
+/* Map a regular file as the screen, it holds raw pixels in screen layout */
+static int raw_open(Framebuffer *fb, const FbConfig *config) {
+    if (!config->path) {
+        fprintf(stderr, "Raw backend needs an output file\n");
+        return -1;
+    }
+
+    if (fake_screeninfo(fb, config, "raw") != 0) {
+        return -1;
+    }
+
+    fb->fd = open(config->path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fb->fd == -1) {
+        fprintf(stderr, "Failed to open %s: %m\n", config->path);
+        return -1;
+    }
+
+    if (ftruncate(fb->fd, fb->finfo.smem_len) == -1) {
+        fprintf(stderr, "Failed to size %s: %m\n", config->path);
+        close(fb->fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, fb->finfo.smem_len, PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+    fb->screen = (map == MAP_FAILED) ? NULL : map;
+
+    return 0;
+}
+
+/* Write the visible screen as a binary PPM image */
+static void ppm_present(Framebuffer *fb) {
+    const char *path = (const char *)fb->priv;
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open %s: %m\n", path);
+        return;
+    }
+
+    uint32_t width = fb->vinfo.xres;
+    uint32_t height = fb->vinfo.yres;
+    const PixelFormat *fmt = &fb->format;
+    uint8_t *row = malloc(width * 3);
+    if (!row) {
+        fclose(fp);
+        return;
+    }
+
+    fprintf(fp, "P6\n%u %u\n255\n", width, height);
+    for (uint32_t y = 0; y < height; y++) {
+        const uint8_t *src = fb->screen + (fb->vinfo.yoffset + y) * fb->finfo.line_length;
+        for (uint32_t x = 0; x < width; x++, src += fmt->bytes_per_pixel) {
+            uint32_t color = pixel_unpack(fmt, pixel_load(fmt, src));
+            row[x * 3 + 0] = (color >> 16) & 0xFF;
+            row[x * 3 + 1] = (color >> 8) & 0xFF;
+            row[x * 3 + 2] = color & 0xFF;
+        }
+        fwrite(row, 3, width, fp);
+    }
+
+    free(row);
+    fclose(fp);
+}
+
+/* Use a memory screen and remember where to write the image */
+static int ppm_open(Framebuffer *fb, const FbConfig *config) {
+    if (!config->path) {
+        fprintf(stderr, "PPM backend needs an output file\n");
+        return -1;
+    }
+
+    if (memory_open(fb, config) != 0) {
+        return -1;
+    }
+    fb->priv = strdup(config->path);
+    if (!fb->priv) {
+        memory_close(fb);
+        return -1;
+    }
+    return 0;
+}
+
+/* Release the memory screen and output path */
+static void ppm_close(Framebuffer *fb) {
+    free(fb->priv);
+    memory_close(fb);
+}
+
+const FbBackend fb_backend_fbdev = { "fbdev", fbdev_open, NULL, fbdev_close, fbdev_pan };
+const FbBackend fb_backend_memory = { "memory", memory_open, NULL, memory_close, memory_pan };
+const FbBackend fb_backend_raw = { "raw", raw_open, NULL, fbdev_close, NULL };
+const FbBackend fb_backend_ppm = { "ppm", ppm_open, ppm_present, ppm_close, memory_pan };
+
+/* Look up an output backend by name */
+const FbBackend* fb_backend_find(const char *name) {
+    static const FbBackend *const backends[] = {
+        &fb_backend_fbdev, &fb_backend_memory, &fb_backend_raw, &fb_backend_ppm
+    };
+
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        if (strcmp(backends[i]->name, name) == 0) {
+            return backends[i];
+        }
+    }
+    return NULL;
+}
@@ -1,15 +1,48 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <fcntl.h>
 #include <unistd.h>
-#include <sys/ioctl.h>
 #include "fbsplash.h"
+#include "rotate.h"
+#include "prof.h"
 
-/* Initialize the framebuffer device
- * Opens the device, gets screen information, and creates a buffer
+/* Read the current screen contents into the shadow buffer */
+static void fb_readback(Framebuffer *fb) {
+    if (fb->screen) {
+        memcpy(fb->buffer, fb->screen, fb->screensize);
+        return;
+    }
+
+    size_t done = 0;
+    while (done < fb->screensize) {
+        ssize_t n = pread(fb->fd, fb->buffer + done, fb->screensize - done, done);
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+}
+
+/* Address of the visible origin of the page starting at row yoffset */
+static uint8_t *fb_page_origin(const Framebuffer *fb, uint32_t yoffset) {
+    return fb->buffer + yoffset * fb->finfo.line_length +
+           fb->vinfo.xoffset * fb->format.bytes_per_pixel;
+}
+
+/* Point pixels at the visible origin inside the drawing buffer */
+static void fb_set_origin(Framebuffer *fb) {
+    fb->pixels = fb_page_origin(fb, fb->vinfo.yoffset);
+}
+
+/* Initialize the framebuffer through the configured backend
+ * Opens the output, gets screen information and sets up the drawing target
  */
-Framebuffer* fb_init(const char *fb_device) {
+Framebuffer* fb_init(const FbConfig *config) {
+    FbConfig defaults = { &fb_backend_fbdev, "/dev/fb0", FB_OUTPUT_MMAP, false, 0, 0, 0, 0, 0 };
+    if (!config) {
+        config = &defaults;
+    }
+
     // Allocate and initialize framebuffer structure
     Framebuffer *fb = calloc(1, sizeof(Framebuffer));
     if (!fb) {
@@ -17,162 +50,347 @@ Framebuffer* fb_init(const char *fb_device) {
         return NULL;
     }
 
-    // Open the framebuffer device
-    fb->fd = open(fb_device, O_RDWR);
-    if (fb->fd == -1) {
-        fprintf(stderr, "Failed to open framebuffer device: %m\n");
+    fb->backend = config->backend ? config->backend : &fb_backend_fbdev;
+    fb->fd = -1;
+
+    // Open the output, the backend fills in the screen information
+    if (fb->backend->open(fb, config) != 0) {
         free(fb);
         return NULL;
     }
 
-    // Get variable screen information
-    if (ioctl(fb->fd, FBIOGET_VSCREENINFO, &fb->vinfo) == -1) {
-        fprintf(stderr, "Failed to get variable screen info: %m\n");
-        close(fb->fd);
+    // Calculate total screen size in bytes
+    fb->screensize = fb->vinfo.yres_virtual * fb->finfo.line_length;
+
+    // Resolve the pixel format once, drawing never looks at vinfo again
+    if (pixel_format_resolve(&fb->format, &fb->vinfo, &fb->finfo) != 0) {
+        fprintf(stderr, "Unsupported bits per pixel: %u\n", fb->vinfo.bits_per_pixel);
+        fb->backend->close(fb);
         free(fb);
         return NULL;
     }
 
-    // Get fixed screen information
-    if (ioctl(fb->fd, FBIOGET_FSCREENINFO, &fb->finfo) == -1) {
-        fprintf(stderr, "Failed to get fixed screen info: %m\n");
-        close(fb->fd);
-        free(fb);
-        return NULL;
+    fb->mode = config->mode;
+    if (fb->mode == FB_OUTPUT_MMAP && !fb->screen) {
+        fprintf(stderr, "Failed to map framebuffer, using shadow buffer\n");
+        fb->mode = FB_OUTPUT_SHADOW;
     }
 
-    // Calculate total screen size in bytes
-    fb->screensize = fb->vinfo.yres_virtual * fb->finfo.line_length;
+    if (fb->mode == FB_OUTPUT_MMAP) {
+        fb->buffer = fb->screen;
+        fb_set_origin(fb);
+        return fb;
+    }
 
-    // Allocate a software buffer for double buffering and anti-aliasing
-    fb->buffer = malloc(fb->screensize);
+    // Allocate a shadow buffer, zeroed unless it is seeded from the screen
+    fb->buffer = config->readback ? malloc(fb->screensize) : calloc(1, fb->screensize);
     if (!fb->buffer) {
         fprintf(stderr, "Failed to allocate memory buffer\n");
-        close(fb->fd);
+        fb->backend->close(fb);
         free(fb);
         return NULL;
     }
 
-    // Initialize buffer to black
-    memset(fb->buffer, 0, fb->screensize);
-
-    // Read current framebuffer content for proper blending
-    lseek(fb->fd, 0, SEEK_SET);
-    read(fb->fd, fb->buffer, fb->screensize);
+    if (config->readback) {
+        fb_readback(fb);
+    }
 
+    fb_set_origin(fb);
     return fb;
 }
 
-/* Set a pixel in the framebuffer with alpha blending
+/* Grow the damage rectangle to include the given area */
+void fb_add_damage(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    if (fb->mode == FB_OUTPUT_MMAP || width == 0 || height == 0) {
+        return;
+    }
+
+    FbRect *d = &fb->damage;
+    if (d->x1 <= d->x0 || d->y1 <= d->y0) {
+        d->x0 = x;
+        d->y0 = y;
+        d->x1 = x + width;
+        d->y1 = y + height;
+        return;
+    }
+
+    if (x < d->x0) d->x0 = x;
+    if (y < d->y0) d->y0 = y;
+    if (x + width > d->x1) d->x1 = x + width;
+    if (y + height > d->y1) d->y1 = y + height;
+}
+
+/* Clip a span to the screen
+ * Returns: Number of pixels left to draw, 0 if the span is off screen
+ */
+static inline uint32_t fb_clip_span(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t count) {
+    if (y >= fb->vinfo.yres || x >= fb->vinfo.xres) {
+        return 0;
+    }
+    if (count > fb->vinfo.xres - x) {
+        count = fb->vinfo.xres - x;
+    }
+    return count;
+}
+
+/* Set a single pixel in the framebuffer
  * Handles bounds checking and pixel format
  */
 void set_pixel(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t color) {
-    // Check if pixel is within screen bounds
-    if (x >= fb->vinfo.xres || y >= fb->vinfo.yres) {
+    fb_fill_span(fb, x, y, 1, color);
+}
+
+/* Blend two pixels according to alpha value
+ * alpha: 0.0 (fully transparent) to 1.0 (fully opaque)
+ */
+void blend_pixel(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t color, float alpha) {
+    if (alpha <= 0.0f) {
         return;
     }
 
-    // Calculate pixel offset in buffer
-    size_t location = (x + fb->vinfo.xoffset) * (fb->vinfo.bits_per_pixel / 8) +
-                      (y + fb->vinfo.yoffset) * fb->finfo.line_length;
+    uint8_t a = (alpha >= 1.0f) ? 255 : (uint8_t)(alpha * 255.0f + 0.5f);
+    fb_blend_span(fb, x, y, 1, color, &a);
+}
 
-    if (location >= fb->screensize) {
+/* Fill a span with one color, packed once for the whole span */
+void fb_fill_span(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t count, uint32_t color) {
+    count = fb_clip_span(fb, x, y, count);
+    if (count == 0) {
         return;
     }
 
-    // Handle different bit depths
-    if (fb->vinfo.bits_per_pixel == 32) {
-        // Direct write for 32-bit color depth
-        *((uint32_t*)(fb->buffer + location)) = color;
+    fb_add_damage(fb, x, y, count, 1);
+    PROF_COUNT(PROF_PIXELS, count);
+    fb->format.fill(fb_pixel_address(fb, x, y), pixel_pack(&fb->format, color), count);
+}
+
+/* Store a span of colors */
+void fb_store_span(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t count, const uint32_t *colors) {
+    count = fb_clip_span(fb, x, y, count);
+    if (count == 0) {
+        return;
     }
-    else if (fb->vinfo.bits_per_pixel == 16) {
-        // Convert 32-bit RGBA to 16-bit RGB (5-6-5 format)
-        uint8_t r = (color >> 16) & 0xFF;
-        uint8_t g = (color >> 8) & 0xFF;
-        uint8_t b = color & 0xFF;
 
-        // Convert to 5-6-5 format
-        uint16_t color16 = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
-        *((uint16_t*)(fb->buffer + location)) = color16;
+    fb_add_damage(fb, x, y, count, 1);
+    PROF_COUNT(PROF_PIXELS, count);
+    fb->format.store(&fb->format, fb_pixel_address(fb, x, y), colors, count);
+}
+
+/* Blend one color over a span with per-pixel alpha */
+void fb_blend_span(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t count,
+                   uint32_t color, const uint8_t *alpha) {
+    count = fb_clip_span(fb, x, y, count);
+    if (count == 0) {
+        return;
     }
+
+    fb_add_damage(fb, x, y, count, 1);
+    PROF_COUNT(PROF_PIXELS, count);
+    fb->format.blend(&fb->format, fb_pixel_address(fb, x, y), color, alpha, count);
 }
 
-/* Blend two pixels according to alpha value
- * alpha: 0.0 (fully transparent) to 1.0 (fully opaque)
- */
-void blend_pixel(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t color, float alpha) {
-    // Check bounds
-    if (x >= fb->vinfo.xres || y >= fb->vinfo.yres || alpha <= 0.0f) {
+/* Copy an off-screen framebuffer rotated, through the tiled rotate kernels */
+void fb_blit_rotated(Framebuffer *fb, uint32_t x, uint32_t y, const Framebuffer *src, int turns) {
+    uint32_t width = src->vinfo.xres, height = src->vinfo.yres;
+    if (turns & 1) {
+        uint32_t t = width;
+        width = height;
+        height = t;
+    }
+    if (x >= fb->vinfo.xres || y >= fb->vinfo.yres ||
+        width > fb->vinfo.xres - x || height > fb->vinfo.yres - y ||
+        src->format.bytes_per_pixel != fb->format.bytes_per_pixel) {
         return;
     }
 
-    // Full opacity, just set the pixel directly
-    if (alpha >= 1.0f) {
-        set_pixel(fb, x, y, color);
+    fb_add_damage(fb, x, y, width, height);
+    PROF_COUNT(PROF_PIXELS, (uint64_t)width * height);
+    rotate_blit(fb_pixel_address(fb, x, y), fb->finfo.line_length, src->pixels,
+                src->finfo.line_length, src->vinfo.xres, src->vinfo.yres,
+                fb->format.bytes_per_pixel, turns);
+}
+
+/* Fill a rectangle row by row */
+void fb_fill_rect(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                  uint32_t color) {
+    if (y >= fb->vinfo.yres) {
         return;
     }
+    if (height > fb->vinfo.yres - y) {
+        height = fb->vinfo.yres - y;
+    }
+
+    width = fb_clip_span(fb, x, y, width);
+    if (width == 0) {
+        return;
+    }
+
+    fb_add_damage(fb, x, y, width, height);
+    PROF_COUNT(PROF_PIXELS, (uint64_t)width * height);
+
+    uint32_t pixel = pixel_pack(&fb->format, color);
+    for (uint32_t row = 0; row < height; row++) {
+        fb->format.fill(fb_pixel_address(fb, x, y + row), pixel, width);
+    }
+}
 
-    // Calculate pixel location
-    size_t location = (x + fb->vinfo.xoffset) * (fb->vinfo.bits_per_pixel / 8) +
-                     (y + fb->vinfo.yoffset) * fb->finfo.line_length;
+/* Copy the damaged rectangle of the shadow buffer to the screen */
+static void fb_flush_damage(Framebuffer *fb) {
+    FbRect d = fb->damage;
+    memset(&fb->damage, 0, sizeof(fb->damage));
 
-    if (location >= fb->screensize) {
+    // Clip to the visible area
+    if (d.x1 > fb->vinfo.xres) d.x1 = fb->vinfo.xres;
+    if (d.y1 > fb->vinfo.yres) d.y1 = fb->vinfo.yres;
+    if (d.x1 <= d.x0 || d.y1 <= d.y0) {
         return;
     }
 
-    // Extract foreground color components
-    uint8_t fg_r = (color >> 16) & 0xFF;
-    uint8_t fg_g = (color >> 8) & 0xFF;
-    uint8_t fg_b = color & 0xFF;
+    uint32_t bpp = fb->format.bytes_per_pixel;
+    size_t stride = fb->finfo.line_length;
+    size_t first = (d.y0 + fb->vinfo.yoffset) * stride + (d.x0 + fb->vinfo.xoffset) * bpp;
+    size_t span = (d.x1 - d.x0) * bpp;
+    uint32_t rows = d.y1 - d.y0;
+
+    // Full-width damage is one contiguous block
+    if (span == stride) {
+        span *= rows;
+        rows = 1;
+    }
+
+    for (uint32_t i = 0; i < rows; i++) {
+        size_t offset = first + i * stride;
+        if (offset + span > fb->screensize) {
+            break;
+        }
+
+        if (fb->screen) {
+            memcpy(fb->screen + offset, fb->buffer + offset, span);
+        } else if (pwrite(fb->fd, fb->buffer + offset, span, offset) != (ssize_t)span) {
+            fprintf(stderr, "Failed to write framebuffer: %m\n");
+            return;
+        }
+        PROF_COUNT(PROF_FLUSH_BYTES, span);
+    }
+}
+
+/* First row of the page that is not shown */
+static uint32_t fb_hidden_page(const Framebuffer *fb) {
+    return (fb->vinfo.yoffset >= fb->vinfo.yres) ? 0 : fb->vinfo.yres;
+}
+
+/* Copy the damaged rows of one page to the other */
+static void fb_copy_damage(Framebuffer *fb, uint32_t dst_page, uint32_t src_page, const FbRect *d) {
+    size_t stride = fb->finfo.line_length;
+    size_t span = (d->x1 - d->x0) * fb->format.bytes_per_pixel;
+    size_t x = d->x0 * fb->format.bytes_per_pixel;
+    uint8_t *dst = fb_page_origin(fb, dst_page) + d->y0 * stride + x;
+    const uint8_t *src = fb_page_origin(fb, src_page) + d->y0 * stride + x;
+
+    for (uint32_t y = d->y0; y < d->y1; y++, dst += stride, src += stride) {
+        memcpy(dst, src, span);
+    }
+    PROF_COUNT(PROF_FLUSH_BYTES, span * (d->y1 - d->y0));
+}
 
-    // Get current background color
-    uint32_t bg_color = 0;
-    if (fb->vinfo.bits_per_pixel == 32) {
-        bg_color = *((uint32_t*)(fb->buffer + location));
+/* Switch an mmap framebuffer to page flipping */
+int fb_flip_init(Framebuffer *fb) {
+    if (fb->mode != FB_OUTPUT_MMAP || !fb->backend->pan ||
+        fb->vinfo.yres_virtual < 2 * fb->vinfo.yres) {
+        return -1;
     }
-    else if (fb->vinfo.bits_per_pixel == 16) {
-        uint16_t color16 = *((uint16_t*)(fb->buffer + location));
-        // Convert 16-bit 5-6-5 format to 24-bit
-        uint8_t r = ((color16 >> 11) & 0x1F) << 3;
-        uint8_t g = ((color16 >> 5) & 0x3F) << 2;
-        uint8_t b = (color16 & 0x1F) << 3;
-        bg_color = (r << 16) | (g << 8) | b;
+
+    // Panning to the page already shown tells whether the driver can pan at all
+    if (fb->backend->pan(fb, fb->vinfo.yoffset) != 0) {
+        return -1;
     }
 
-    // Extract background color components
-    uint8_t bg_r = (bg_color >> 16) & 0xFF;
-    uint8_t bg_g = (bg_color >> 8) & 0xFF;
-    uint8_t bg_b = bg_color & 0xFF;
+    FbRect all = { 0, 0, fb->vinfo.xres, fb->vinfo.yres };
+    uint32_t hidden = fb_hidden_page(fb);
+    fb_copy_damage(fb, hidden, fb->vinfo.yoffset, &all);
 
-    // Blend colors
-    uint8_t r = (uint8_t)(fg_r * alpha + bg_r * (1.0f - alpha));
-    uint8_t g = (uint8_t)(fg_g * alpha + bg_g * (1.0f - alpha));
-    uint8_t b = (uint8_t)(fg_b * alpha + bg_b * (1.0f - alpha));
+    fb->mode = FB_OUTPUT_FLIP;
+    fb->pixels = fb_page_origin(fb, hidden);
+    memset(&fb->damage, 0, sizeof(fb->damage));
+    return 0;
+}
 
-    // Create blended color
-    uint32_t blended = (r << 16) | (g << 8) | b;
+/* Show the hidden page and make the other one the drawing target
+ * Only the damaged rows are copied over, the pages are equal afterwards.
+ * Without panning the rows are copied to the shown page instead.
+ */
+static void fb_flip_pages(Framebuffer *fb) {
+    FbRect d = fb->damage;
+    memset(&fb->damage, 0, sizeof(fb->damage));
+
+    if (d.x1 > fb->vinfo.xres) d.x1 = fb->vinfo.xres;
+    if (d.y1 > fb->vinfo.yres) d.y1 = fb->vinfo.yres;
+    if (d.x1 <= d.x0 || d.y1 <= d.y0) {
+        return;
+    }
 
-    // Write blended pixel
-    set_pixel(fb, x, y, blended);
+    uint32_t shown = fb->vinfo.yoffset;
+    uint32_t hidden = fb_hidden_page(fb);
+    if (fb->backend->pan(fb, hidden) != 0) {
+        fprintf(stderr, "Failed to pan display, drawing to the visible page: %m\n");
+        fb_copy_damage(fb, shown, hidden, &d);
+        fb->mode = FB_OUTPUT_MMAP;
+        fb_set_origin(fb);
+        return;
+    }
+
+    fb_copy_damage(fb, shown, hidden, &d);
+    fb->pixels = fb_page_origin(fb, shown);
 }
 
-/* Write the buffer to the framebuffer device */
+/* Present everything drawn since the last flush */
 void fb_flush(Framebuffer *fb) {
-    if (fb && fb->buffer) {
-        lseek(fb->fd, 0, SEEK_SET);
-        write(fb->fd, fb->buffer, fb->screensize);
+    if (!fb) {
+        return;
+    }
+
+    if (fb->mode == FB_OUTPUT_SHADOW) {
+        fb_flush_damage(fb);
+    } else if (fb->mode == FB_OUTPUT_FLIP) {
+        fb_flip_pages(fb);
+    }
+
+    if (fb->backend->present) {
+        fb->backend->present(fb);
     }
 }
 
+/* Turn a rectangle of an upright picture onto the panel */
+FbRect fb_rect_rotate(const FbRect *r, int turns, uint32_t width, uint32_t height) {
+    switch (turns) {
+        case 1: return (FbRect){ height - r->y1, r->x0, height - r->y0, r->x1 };
+        case 2: return (FbRect){ width - r->x1, height - r->y1, width - r->x0, height - r->y0 };
+        case 3: return (FbRect){ r->y0, width - r->x1, r->y1, width - r->x0 };
+        default: return *r;
+    }
+}
+
+/* Create an off-screen framebuffer on the memory backend
+ * The memory screen has the same depth, the pixel format is copied so the
+ * pixels can be blitted to the screen as they are.
+ */
+Framebuffer* fb_create_offscreen(const Framebuffer *like, uint32_t width, uint32_t height) {
+    FbConfig config = { &fb_backend_memory, NULL, FB_OUTPUT_MMAP, false,
+                        width, height, like->vinfo.bits_per_pixel, 0, 0 };
+    Framebuffer *fb = fb_init(&config);
+    if (fb) {
+        fb->format = like->format;
+    }
+    return fb;
+}
+
 /* Clean up framebuffer resources */
 void fb_cleanup(Framebuffer *fb) {
     if (fb) {
-        if (fb->buffer) {
+        if (fb->buffer && fb->buffer != fb->screen) {
             free(fb->buffer);
         }
-        if (fb->fd >= 0) {
-            close(fb->fd);
-        }
+        fb->backend->close(fb);
         free(fb);
     }
 }
@@ -180,23 +398,28 @@ void fb_cleanup(Framebuffer *fb) {
 /* Calculate display information for SVG rendering
  * Determines optimal SVG size and position while maintaining aspect ratio
  */
-DisplayInfo* calculate_display_info(Framebuffer *fb) {
+DisplayInfo* calculate_display_info(Framebuffer *fb, const ViewBox *view_box, int rotation) {
     DisplayInfo *info = calloc(1, sizeof(DisplayInfo));
     if (!info) {
         return NULL;
     }
 
-    info->screen_width = fb->vinfo.xres;
-    info->screen_height = fb->vinfo.yres;
+    // Lay the logo out on the upright picture, a portrait panel shown
+    // rotated gets a landscape layout sized for its long side
+    bool swap = (rotation / 90) % 2 != 0;
+    info->screen_width = swap ? fb->vinfo.yres : fb->vinfo.xres;
+    info->screen_height = swap ? fb->vinfo.xres : fb->vinfo.yres;
 
     // Calculate SVG dimensions to fit in screen while maintaining aspect ratio
+    info->view_box = *view_box;
+    float aspect = view_box->height / view_box->width;
     float target_width = info->screen_width * 0.6f;  // Use 60% of screen width
-    float target_height = target_width * (274.0f / 2326.0f);  // Maintain SVG aspect ratio
+    float target_height = target_width * aspect;     // Maintain SVG aspect ratio
 
     // Adjust if height is too large
     if (target_height > info->screen_height * 0.6f) {
         target_height = info->screen_height * 0.6f;
-        target_width = target_height * (2326.0f / 274.0f);
+        target_width = target_height / aspect;
     }
 
     // Set final dimensions and calculate centering offsets
@@ -1,40 +1,136 @@
 #ifndef FBSPLASH_H
 #define FBSPLASH_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <linux/fb.h>
+#include "pixel_format.h"
+#include "svg_types.h"
+
+/* How drawing reaches the display
+ * FB_OUTPUT_MMAP draws straight into the mapped device memory, so there is
+ * nothing to copy on flush. FB_OUTPUT_SHADOW draws into a private buffer and
+ * fb_flush() copies only the damaged rectangle to the device.
+ * FB_OUTPUT_FLIP draws into the hidden page of a double height virtual
+ * screen and fb_flush() pans the display to it, set up by fb_flip_init().
+ */
+typedef enum {
+    FB_OUTPUT_MMAP,
+    FB_OUTPUT_SHADOW,
+    FB_OUTPUT_FLIP,
+} FbOutputMode;
+
+/* Rectangle in screen pixels, x1/y1 are exclusive */
+typedef struct {
+    uint32_t x0, y0;
+    uint32_t x1, y1;
+} FbRect;
+
+typedef struct Framebuffer Framebuffer;
+typedef struct FbBackend FbBackend;
+
+/* Framebuffer initialization options
+ * backend: Output backend, NULL selects the fbdev backend
+ * path: Device node for fbdev, output file for raw and ppm backends
+ * mode: Output mode, falls back to FB_OUTPUT_SHADOW if mmap() fails
+ * readback: Seed the shadow buffer with the current screen contents.
+ *           Only needed when blending against what is already displayed.
+ * width, height, bpp, stride: Requested mode, 0 keeps the backend default
+ * pages: Screens of virtual height to ask for, 2 allows page flipping
+ */
+typedef struct {
+    const FbBackend *backend;
+    const char *path;
+    FbOutputMode mode;
+    bool readback;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bpp;
+    uint32_t stride;
+    uint32_t pages;
+} FbConfig;
+
+/* Output backend operations
+ * open: Fill in vinfo/finfo and provide fd and/or mapped screen memory
+ * present: Optional hook run after damaged pixels reached the screen
+ * close: Release what open acquired
+ * pan: Optional, show the virtual screen from row yoffset on and update vinfo
+ */
+struct FbBackend {
+    const char *name;
+    int (*open)(Framebuffer *fb, const FbConfig *config);
+    void (*present)(Framebuffer *fb);
+    void (*close)(Framebuffer *fb);
+    int (*pan)(Framebuffer *fb, uint32_t yoffset);
+};
+
+/* Available output backends */
+extern const FbBackend fb_backend_fbdev;   // Linux fbdev device, e.g. /dev/fb0
+extern const FbBackend fb_backend_memory;  // Anonymous memory, nothing is shown
+extern const FbBackend fb_backend_raw;     // Raw pixels in a file mapped as the screen
+extern const FbBackend fb_backend_ppm;     // Memory screen written as PPM on every flush
+
+/* Look up an output backend by name
+ * Returns: Backend or NULL if the name is unknown
+ */
+const FbBackend* fb_backend_find(const char *name);
 
 /* Framebuffer structure holding device information and buffer
- * fd: File descriptor for the framebuffer device
- * buffer: Software buffer for drawing operations
+ * backend: Output backend driving this framebuffer
+ * fd: File descriptor for the device or output file, -1 if none
+ * buffer: Drawing target, either the shadow buffer or the mapped screen
+ * pixels: Address of the visible pixel (0, 0) inside buffer
+ * format: Pixel format resolved at initialization
+ * screen: Mapped screen memory or NULL if mmap() is unavailable
+ * priv: Backend private data
+ * mode: Output mode in effect after initialization
+ * damage: Area drawn since the last flush (shadow mode only)
  * vinfo: Variable screen information (resolution, bit depth, etc.)
  * finfo: Fixed screen information (memory length, line length, etc.)
  * screensize: Total size of the framebuffer in bytes
  */
-typedef struct {
+struct Framebuffer {
+    const FbBackend *backend;
     int fd;
     uint8_t *buffer;
+    uint8_t *pixels;
+    PixelFormat format;
+    uint8_t *screen;
+    void *priv;
+    FbOutputMode mode;
+    FbRect damage;
     struct fb_var_screeninfo vinfo;
     struct fb_fix_screeninfo finfo;
     size_t screensize;
-} Framebuffer;
+};
 
 /* Display information structure for SVG rendering
- * Contains screen and SVG dimensions and offsets for centering
+ * Contains screen and SVG dimensions and offsets for centering, all in
+ * logical coordinates: for 90 and 270 degree panels width and height are
+ * those of the upright picture, not of the scanout.
  */
 typedef struct {
-    uint32_t screen_width;   // Width of the screen in pixels
-    uint32_t screen_height;  // Height of the screen in pixels
+    uint32_t screen_width;   // Logical width of the screen in pixels
+    uint32_t screen_height;  // Logical height of the screen in pixels
     uint32_t svg_width;      // Width of the scaled SVG
     uint32_t svg_height;     // Height of the scaled SVG
     uint32_t x_offset;       // X offset for centering SVG
     uint32_t y_offset;       // Y offset for centering SVG
+    ViewBox view_box;        // SVG area the scaled rectangle shows
 } DisplayInfo;
 
-/* Initialize the framebuffer device
+/* Initialize the framebuffer through the configured backend
+ * config: Output options, NULL selects /dev/fb0 with mmap output
  * Returns: Pointer to initialized Framebuffer structure or NULL on failure
  */
-Framebuffer* fb_init(const char *fb_device);
+Framebuffer* fb_init(const FbConfig *config);
+
+/* Create an off-screen framebuffer in the pixel format of another
+ * It starts out black and is released with fb_cleanup().
+ * Returns: Framebuffer or NULL on failure
+ */
+Framebuffer* fb_create_offscreen(const Framebuffer *like, uint32_t width, uint32_t height);
 
 /* Clean up and free framebuffer resources */
 void fb_cleanup(Framebuffer *fb);
@@ -49,12 +145,64 @@ void set_pixel(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t color);
  */
 void blend_pixel(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t color, float alpha);
 
-/* Write the internal buffer to the framebuffer device */
+/* Fill count pixels of row y starting at x with one color
+ * Spans are clipped to the screen, colors are 0xRRGGBB
+ */
+void fb_fill_span(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t count, uint32_t color);
+
+/* Store count colors into row y starting at x */
+void fb_store_span(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t count, const uint32_t *colors);
+
+/* Blend one color over count pixels of row y with per-pixel 8-bit alpha */
+void fb_blend_span(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t count,
+                   uint32_t color, const uint8_t *alpha);
+
+/* Copy an off-screen framebuffer to (x, y) rotated clockwise by quarter turns
+ * The rotated picture must fit on the screen, its damage is tracked.
+ */
+void fb_blit_rotated(Framebuffer *fb, uint32_t x, uint32_t y, const Framebuffer *src, int turns);
+
+/* Fill a rectangle with one color */
+void fb_fill_rect(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                  uint32_t color);
+
+/* Address of pixel (x, y) in the drawing buffer, which must be on screen
+ * For callers that write through fb->format directly, e.g. from several
+ * threads at once, and report the damage themselves afterwards.
+ */
+static inline uint8_t *fb_pixel_address(const Framebuffer *fb, uint32_t x, uint32_t y) {
+    return fb->pixels + y * fb->finfo.line_length + x * fb->format.bytes_per_pixel;
+}
+
+/* Mark a rectangle as modified so the next fb_flush() presents it
+ * Drawing through set_pixel() and blend_pixel() tracks damage already.
+ */
+void fb_add_damage(Framebuffer *fb, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+/* Present everything drawn since the last flush
+ * Copies only the damaged rows in shadow mode, no-op in mmap mode
+ */
 void fb_flush(Framebuffer *fb);
 
+/* Switch an mmap framebuffer to page flipping
+ * Needs a backend that pans and room for two pages in the virtual screen.
+ * The visible page is copied to the hidden one, which becomes the drawing
+ * target. From then on fb_flush() pans to what was drawn and brings the
+ * new hidden page up to date, so the screen never shows a partial frame.
+ * Returns: 0 on success, -1 if the framebuffer keeps its output mode
+ */
+int fb_flip_init(Framebuffer *fb);
+
+/* Turn a rectangle of an upright width x height picture clockwise onto the panel
+ * turns: Quarter turns, 0 to 3
+ */
+FbRect fb_rect_rotate(const FbRect *r, int turns, uint32_t width, uint32_t height);
+
 /* Calculate display information for SVG rendering
+ * view_box: Area of the image to lay out, its aspect ratio is kept
+ * rotation: Display rotation in degrees, 90 and 270 swap the logical size
  * Returns: Pointer to DisplayInfo structure with calculated values
  */
-DisplayInfo* calculate_display_info(Framebuffer *fb);
+DisplayInfo* calculate_display_info(Framebuffer *fb, const ViewBox *view_box, int rotation);
 
 #endif
@@ -0,0 +1,50 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+/* Alignment of every block taken from an arena */
+#define GEOMETRY_ARENA_ALIGN 16
+
+/* Bump allocator over one heap block sized up front
+ * Parsed geometry is counted first, so a path or a whole scene lives in
+ * one allocation. The first block taken starts the heap block, freeing
+ * that pointer frees everything.
+ */
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+} GeometryArena;
+
+/* Size of a block rounded up to the arena alignment */
+static inline size_t geometry_arena_round(size_t size) {
+    return (size + GEOMETRY_ARENA_ALIGN - 1) & ~(size_t)(GEOMETRY_ARENA_ALIGN - 1);
+}
+
+/* Allocate the heap block of an arena
+ * size: Sum of the rounded sizes of every block that will be taken
+ * Returns: 0 on success, -1 on allocation failure
+ */
+static inline int geometry_arena_init(GeometryArena *arena, size_t size) {
+    arena->base = malloc(size ? size : GEOMETRY_ARENA_ALIGN);
+    arena->size = size;
+    arena->used = 0;
+    return arena->base ? 0 : -1;
+}
+
+/* Take a block of size bytes, NULL if the arena was sized too small */
+static inline void *geometry_arena_alloc(GeometryArena *arena, size_t size) {
+    size = geometry_arena_round(size);
+    if (size > arena->size - arena->used) {
+        return NULL;
+    }
+
+    void *block = arena->base + arena->used;
+    arena->used += size;
+    return block;
+}
+
+#endif
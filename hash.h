@@ -0,0 +1,22 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Starting value of a hash, the FNV-1a offset basis */
+#define HASH_SEED 2166136261u
+
+/* FNV-1a hash over a block of memory
+ * Chain calls by passing the previous result as hash, starting at HASH_SEED.
+ */
+static inline uint32_t hash_bytes(uint32_t hash, const void *data, size_t len) {
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#endif
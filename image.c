@@ -0,0 +1,381 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "image.h"
+#include "qoi.h"
+#include "rotate.h"
+#include "prof.h"
+
+#define IMAGE_BAND_ROWS 32       // Rows composited or turned at a time
+
+struct ImageFile {
+    const uint8_t *data;
+    size_t size;
+    QoiDecoder start;        // Decoder before the first row
+};
+
+/* Fixed-point area averaging scaler, fed one source row at a time
+ * Edges of output pixels are kept in 16.16 source pixels and weights in
+ * 1/256 pixel, so every screen pixel is the average of the picture area
+ * under it: shrinking does not alias, enlarging gives sharp pixels with
+ * blended seams.
+ */
+typedef struct {
+    QoiDecoder *dec;
+    uint32_t width, height;  // Output size
+    uint32_t *columns;       // Source x of the left edge of each output column, width + 1
+    uint64_t *column_scale;  // 2^40 over the total weight of each output column
+    uint32_t *src_colors;    // Source row as decoded
+    uint8_t *src_alpha;
+    uint16_t *row;           // Source row averaged to the output width, 4 channels in 8.8
+    uint64_t *sums;          // Weighted rows of the output row, 4 channels
+    uint32_t src_y;          // Source row held in row
+} Scaler;
+
+/* Map a QOI picture and read its header */
+ImageFile* image_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        fprintf(stderr, "Failed to open %s: %m\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %m\n", path);
+        return NULL;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    ImageFile *file = calloc(1, sizeof(ImageFile));
+    if (!file) {
+        munmap(data, st.st_size);
+        return NULL;
+    }
+    file->data = data;
+    file->size = st.st_size;
+
+    if (qoi_decoder_init(&file->start, file->data, file->size) != 0) {
+        fprintf(stderr, "%s is not a QOI picture\n", path);
+        image_close(file);
+        return NULL;
+    }
+    if (file->start.width > IMAGE_MAX_SIZE || file->start.height > IMAGE_MAX_SIZE) {
+        fprintf(stderr, "%s is larger than %ux%u\n", path, IMAGE_MAX_SIZE, IMAGE_MAX_SIZE);
+        image_close(file);
+        return NULL;
+    }
+    return file;
+}
+
+/* Size of the picture in pixels */
+uint32_t image_width(const ImageFile *file) {
+    return file->start.width;
+}
+
+uint32_t image_height(const ImageFile *file) {
+    return file->start.height;
+}
+
+/* Unmap the file */
+void image_close(ImageFile *file) {
+    if (!file) {
+        return;
+    }
+    munmap((void *)file->data, file->size);
+    free(file);
+}
+
+/* Lay the picture out on the screen */
+DisplayInfo* image_display_info(Framebuffer *fb, const ImageFile *file, int rotation, bool fit) {
+    ViewBox box = { 0, 0, (float)file->start.width, (float)file->start.height };
+    DisplayInfo *info = calculate_display_info(fb, &box, rotation);
+    if (!info) {
+        return NULL;
+    }
+
+    // Fitted or own size, shrunk by the direction that overflows most
+    uint64_t width = fit ? info->svg_width : file->start.width;
+    uint64_t height = fit ? info->svg_height : file->start.height;
+    if (width > info->screen_width) {
+        height = height * info->screen_width / width;
+        width = info->screen_width;
+    }
+    if (height > info->screen_height) {
+        width = width * info->screen_height / height;
+        height = info->screen_height;
+    }
+
+    // A very thin picture still gets a line of pixels rather than nothing
+    info->svg_width = width ? (uint32_t)width : 1;
+    info->svg_height = height ? (uint32_t)height : 1;
+    info->x_offset = (info->screen_width - info->svg_width) / 2;
+    info->y_offset = (info->screen_height - info->svg_height) / 2;
+    return info;
+}
+
+/* Upright rectangle of the picture */
+static FbRect upright_area(const DisplayInfo *display_info) {
+    return (FbRect){ display_info->x_offset, display_info->y_offset,
+                     display_info->x_offset + display_info->svg_width,
+                     display_info->y_offset + display_info->svg_height };
+}
+
+/* Screen rectangle of the picture */
+void image_area(const Framebuffer *fb, const DisplayInfo *display_info, const RenderOptions *options,
+                FbRect *rect) {
+    int turns = options ? options->rotation / 90 % 4 : 0;
+    uint32_t width = (turns & 1) ? fb->vinfo.yres : fb->vinfo.xres;
+    uint32_t height = (turns & 1) ? fb->vinfo.xres : fb->vinfo.yres;
+    FbRect upright = upright_area(display_info);
+    *rect = fb_rect_rotate(&upright, turns, width, height);
+}
+
+/* Set up a scaler from the decoder size to width x height
+ * Returns: 0 on success, -1 if the buffers cannot be allocated
+ */
+static int scaler_init(Scaler *s, QoiDecoder *dec, uint32_t width, uint32_t height) {
+    memset(s, 0, sizeof(*s));
+    s->dec = dec;
+    s->width = width;
+    s->height = height;
+    s->columns = malloc((width + 1) * sizeof(uint32_t));
+    s->column_scale = malloc(width * sizeof(uint64_t));
+    s->src_colors = malloc(dec->width * sizeof(uint32_t));
+    s->src_alpha = malloc(dec->width);
+    s->row = malloc(width * 4 * sizeof(uint16_t));
+    s->sums = malloc(width * 4 * sizeof(uint64_t));
+    if (!s->columns || !s->column_scale || !s->src_colors || !s->src_alpha || !s->row || !s->sums) {
+        return -1;
+    }
+
+    for (uint32_t x = 0; x <= width; x++) {
+        s->columns[x] = (uint32_t)(((uint64_t)x * dec->width << 16) / width);
+    }
+
+    // Weights of a column are the same on every row, so its division becomes a multiply
+    for (uint32_t x = 0; x < width; x++) {
+        uint32_t left = s->columns[x], right = s->columns[x + 1], total = 0;
+        for (uint32_t j = left >> 16; (j << 16) < right; j++) {
+            uint32_t lo = (left > (j << 16)) ? left : j << 16;
+            uint32_t hi = (right < ((j + 1) << 16)) ? right : (j + 1) << 16;
+            total += (hi - lo + 255) >> 8;
+        }
+        s->column_scale[x] = ((1ull << 40) + total / 2) / total;
+    }
+    return 0;
+}
+
+static void scaler_free(Scaler *s) {
+    free(s->sums);
+    free(s->row);
+    free(s->src_alpha);
+    free(s->src_colors);
+    free(s->column_scale);
+    free(s->columns);
+}
+
+/* Decode the next source row and average it to the output width
+ * Returns: 0 on success, -1 if the data ends early
+ */
+static int scaler_next_row(Scaler *s) {
+    if (qoi_decode_row(s->dec, s->src_colors, s->src_alpha) != 0) {
+        return -1;
+    }
+
+    for (uint32_t x = 0; x < s->width; x++) {
+        uint32_t left = s->columns[x], right = s->columns[x + 1];
+        uint32_t sum[4] = { 0, 0, 0, 0 };
+        for (uint32_t j = left >> 16; (j << 16) < right; j++) {
+            uint32_t lo = (left > (j << 16)) ? left : j << 16;
+            uint32_t hi = (right < ((j + 1) << 16)) ? right : (j + 1) << 16;
+            uint32_t w = (hi - lo + 255) >> 8;
+            uint32_t c = s->src_colors[j];
+            sum[0] += ((c >> 16) & 0xFF) * w;
+            sum[1] += ((c >> 8) & 0xFF) * w;
+            sum[2] += (c & 0xFF) * w;
+            sum[3] += s->src_alpha[j] * w;
+        }
+        uint64_t scale = s->column_scale[x];
+        for (int k = 0; k < 4; k++) {
+            s->row[4 * x + k] = (uint16_t)(((uint64_t)sum[k] * scale + (1ull << 31)) >> 32);
+        }
+    }
+    s->src_y++;
+    return 0;
+}
+
+/* Produce output row y, rows must be asked for in order
+ * Returns: 0 on success, -1 if the data ends early
+ */
+static int scaler_row(Scaler *s, uint32_t y, uint32_t *colors, uint8_t *alpha) {
+    uint32_t src_height = s->dec->height;
+    uint32_t top = (uint32_t)(((uint64_t)y * src_height << 16) / s->height);
+    uint32_t bottom = (uint32_t)(((uint64_t)(y + 1) * src_height << 16) / s->height);
+
+    if (y == 0 && scaler_next_row(s) != 0) {
+        return -1;
+    }
+
+    memset(s->sums, 0, s->width * 4 * sizeof(uint64_t));
+    uint64_t total = 0;
+    for (;;) {
+        // The row held is src_y - 1, weighted by how much of it lies in the output row
+        uint32_t row_top = (s->src_y - 1) << 16, row_bottom = s->src_y << 16;
+        uint32_t lo = (top > row_top) ? top : row_top;
+        uint32_t hi = (bottom < row_bottom) ? bottom : row_bottom;
+        uint32_t w = (hi - lo + 255) >> 8;
+        for (uint32_t i = 0; i < s->width * 4; i++) {
+            s->sums[i] += (uint64_t)s->row[i] * w;
+        }
+        total += w;
+
+        // A row reaching into the next output row stays for it
+        if (row_bottom > bottom || s->src_y == src_height) {
+            break;
+        }
+        if (scaler_next_row(s) != 0) {
+            return -1;
+        }
+        if (row_bottom == bottom) {
+            break;
+        }
+    }
+
+    // One reciprocal for the row, sums stay below 2^28 times the divisor
+    uint64_t divisor = total << 8;
+    uint64_t scale = ((1ull << 32) + divisor / 2) / divisor;
+    for (uint32_t x = 0; x < s->width; x++) {
+        const uint64_t *sum = s->sums + 4 * x;
+        colors[x] = (uint32_t)((sum[0] * scale + (1ull << 31)) >> 32) << 16 |
+                    (uint32_t)((sum[1] * scale + (1ull << 31)) >> 32) << 8 |
+                    (uint32_t)((sum[2] * scale + (1ull << 31)) >> 32);
+        alpha[x] = (uint8_t)((sum[3] * scale + (1ull << 31)) >> 32);
+    }
+    return 0;
+}
+
+/* Copy rows of the band turned onto the screen
+ * upright: Rectangle of the upright picture the rows show
+ */
+static void blit_band(Framebuffer *fb, const Framebuffer *band, const FbRect *upright, int turns) {
+    uint32_t width = (turns & 1) ? fb->vinfo.yres : fb->vinfo.xres;
+    uint32_t height = (turns & 1) ? fb->vinfo.xres : fb->vinfo.yres;
+    FbRect r = fb_rect_rotate(upright, turns, width, height);
+
+    fb_add_damage(fb, r.x0, r.y0, r.x1 - r.x0, r.y1 - r.y0);
+    PROF_COUNT(PROF_PIXELS, (uint64_t)(r.x1 - r.x0) * (r.y1 - r.y0));
+    rotate_blit(fb_pixel_address(fb, r.x0, r.y0), fb->finfo.line_length, band->pixels,
+                band->finfo.line_length, upright->x1 - upright->x0, upright->y1 - upright->y0,
+                fb->format.bytes_per_pixel, turns);
+}
+
+/* Decode the picture onto the screen
+ * Opaque pictures on an upright panel are stored straight into the
+ * screen rows. Otherwise rows collect in a band, over the background for
+ * pictures with alpha, which is turned onto the screen when full.
+ */
+int image_draw(Framebuffer *fb, const ImageFile *file, const DisplayInfo *display_info,
+               const RenderOptions *options) {
+    int turns = options ? options->rotation / 90 % 4 : 0;
+    const Background *background = options ? options->background : NULL;
+    bool linear_blend = options && options->linear_blend;
+    uint32_t width = display_info->svg_width, height = display_info->svg_height;
+    FbRect area = upright_area(display_info);
+    if (width == 0 || height == 0) {
+        return 0;
+    }
+
+    QoiDecoder dec = file->start;
+    bool scaled = width != dec.width || height != dec.height;
+    bool opaque = dec.channels == 3;
+    bool direct = opaque && turns == 0;
+
+    Scaler scaler = { 0 };
+    uint32_t *colors = malloc(width * sizeof(uint32_t));
+    uint8_t *alpha = malloc(width);
+    Framebuffer *band = direct ? NULL : fb_create_offscreen(fb, width, IMAGE_BAND_ROWS);
+    int status = -1;
+    if (!colors || !alpha || (!direct && !band) ||
+        (scaled && scaler_init(&scaler, &dec, width, height) != 0)) {
+        fprintf(stderr, "Failed to allocate picture rows\n");
+        goto out;
+    }
+
+    const PixelFormat *fmt = &fb->format;
+    if (direct) {
+        fb_add_damage(fb, area.x0, area.y0, width, height);
+        PROF_COUNT(PROF_PIXELS, (uint64_t)width * height);
+    }
+
+    uint32_t logical_width = (turns & 1) ? fb->vinfo.yres : fb->vinfo.xres;
+    uint32_t logical_height = (turns & 1) ? fb->vinfo.xres : fb->vinfo.yres;
+    uint32_t band_start = 0;
+    uint32_t y;
+    for (y = 0; y < height; y++) {
+        if ((scaled ? scaler_row(&scaler, y, colors, alpha) : qoi_decode_row(&dec, colors, alpha)) != 0) {
+            fprintf(stderr, "Picture data ends after %u of %u rows\n", y, height);
+            break;
+        }
+
+        if (direct) {
+            fmt->store(fmt, fb_pixel_address(fb, area.x0, area.y0 + y), colors, width);
+            continue;
+        }
+
+        // The band starts as the background under its rows
+        uint32_t band_y = y - band_start;
+        if (band_y == 0 && !opaque) {
+            background_draw_upright(band, background, area.x0, area.y0 + y, logical_width, logical_height);
+        }
+
+        uint8_t *dst = fb_pixel_address(band, 0, band_y);
+        if (opaque) {
+            fmt->store(fmt, dst, colors, width);
+        } else if (linear_blend) {
+            fmt->over_linear(fmt, dst, colors, alpha, width);
+        } else {
+            fmt->over(fmt, dst, colors, alpha, width);
+        }
+
+        if (band_y == IMAGE_BAND_ROWS - 1) {
+            FbRect rows = { area.x0, area.y0 + band_start, area.x1, area.y0 + y + 1 };
+            blit_band(fb, band, &rows, turns);
+            band_start = y + 1;
+        }
+    }
+
+    // Rows of a band cut short by the end of the picture
+    if (!direct && y > band_start) {
+        FbRect rows = { area.x0, area.y0 + band_start, area.x1, area.y0 + y };
+        blit_band(fb, band, &rows, turns);
+    }
+
+    // Rows the data did not reach show the background rather than what was there
+    if (y < height) {
+        FbRect rest = { area.x0, area.y0 + y, area.x1, area.y1 };
+        FbRect screen = fb_rect_rotate(&rest, turns, logical_width, logical_height);
+        background_draw(fb, background, turns, &screen, NULL);
+    } else {
+        status = 0;
+    }
+
+out:
+    if (scaled) scaler_free(&scaler);
+    fb_cleanup(band);
+    free(alpha);
+    free(colors);
+    return status;
+}
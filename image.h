@@ -0,0 +1,51 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdbool.h>
+#include "fbsplash.h"
+#include "svg_renderer.h"
+
+/* Raster picture shown instead of the logo
+ * The file is a QOI picture, mapped and decoded one row at a time while
+ * it is drawn, so no decoded copy of the picture is ever held. Rows go
+ * straight to the screen in its pixel format, through a band of a few
+ * rows when the panel is rotated or the picture has alpha.
+ */
+typedef struct ImageFile ImageFile;
+
+/* Largest picture edge in pixels */
+#define IMAGE_MAX_SIZE 16384
+
+/* Map a QOI picture and read its header
+ * Returns: File or NULL on failure
+ */
+ImageFile* image_open(const char *path);
+
+/* Size of the picture in pixels */
+uint32_t image_width(const ImageFile *file);
+uint32_t image_height(const ImageFile *file);
+
+/* Unmap the file */
+void image_close(ImageFile *file);
+
+/* Lay the picture out on the screen
+ * Centered at its own size, or shrunk to fit a screen smaller than it.
+ * fit: Scale it to the area a logo gets instead, see calculate_display_info()
+ * Returns: Layout to free, or NULL on failure
+ */
+DisplayInfo* image_display_info(Framebuffer *fb, const ImageFile *file, int rotation, bool fit);
+
+/* Screen rectangle of the picture, which image_draw() covers completely */
+void image_area(const Framebuffer *fb, const DisplayInfo *display_info, const RenderOptions *options,
+                FbRect *rect);
+
+/* Decode the picture onto the screen
+ * A layout of another size scales it in fixed point, every screen pixel
+ * averaging the part of the picture it covers. Pictures with alpha are
+ * composited over the background of the options.
+ * Returns: 0 on success, -1 if the data is cut short or memory runs out
+ */
+int image_draw(Framebuffer *fb, const ImageFile *file, const DisplayInfo *display_info,
+               const RenderOptions *options);
+
+#endif
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <string.h>
+#include "logo_paths.h"
+#include "svg_parser.h"
+
+/* Curve tolerance in path units, a quarter pixel or less up to 8K where
+ * the logo is drawn at about twice its path size
+ */
+#define LOGO_FLATTEN_TOLERANCE 0.1f
+
+/*
+ * Build-time generator for the logo geometry table
+ *
+ * Parses the logo path data once on the build host and prints C source
+ * with the flattened subpaths, fill colors and bounds as const data. The
+ * splash links the result, so boot does no parsing and no heap allocation
+ * for the logo geometry.
+ */
+
+/* Print a float so that it reads back as the same value */
+static void print_float(float value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", value);
+    if (!strpbrk(buf, ".en")) {
+        strcat(buf, ".0");
+    }
+    printf("%sf", buf);
+}
+
+int main(void) {
+    float min_x = 1e6f, min_y = 1e6f;
+    float max_x = -1e6f, max_y = -1e6f;
+
+    printf("/* Generated by logo_gen from logo_paths.c, do not edit */\n\n");
+    printf("#include \"logo_table.h\"\n\n");
+
+    // Points of every subpath
+    for (unsigned int i = 0; i < logo_num_paths; i++) {
+        SVGPath *svg = parse_svg_path(logo_path_data[i], logo_path_colors[i], LOGO_FLATTEN_TOLERANCE);
+        if (!svg) {
+            fprintf(stderr, "Failed to parse logo path %u\n", i);
+            return 1;
+        }
+
+        for (uint32_t j = 0; j < svg->num_paths; j++) {
+            Path *path = &svg->paths[j];
+            printf("static const Point logo_points_%u_%u[] = {\n", i, j);
+            for (uint32_t k = 0; k < path->num_points; k++) {
+                Point p = path->points[k];
+                printf("    { ");
+                print_float(p.x);
+                printf(", ");
+                print_float(p.y);
+                printf(" },\n");
+
+                if (p.x < min_x) min_x = p.x;
+                if (p.x > max_x) max_x = p.x;
+                if (p.y < min_y) min_y = p.y;
+                if (p.y > max_y) max_y = p.y;
+            }
+            printf("};\n\n");
+        }
+
+        // The renderer never writes through these pointers
+        printf("static const Path logo_subpaths_%u[] = {\n", i);
+        for (uint32_t j = 0; j < svg->num_paths; j++) {
+            Path *path = &svg->paths[j];
+            printf("    { (Point *)logo_points_%u_%u, %u, %u },\n",
+                   i, j, path->num_points, path->num_points);
+        }
+        printf("};\n\n");
+
+        free_svg_path(svg);
+    }
+
+    // Paths with their fill colors, the built-in logo uses the SVG default fill rule
+    printf("static const SVGPath logo_paths[] = {\n");
+    for (unsigned int i = 0; i < logo_num_paths; i++) {
+        Color c = parse_color(logo_path_colors[i]);
+        printf("    { (Path *)logo_subpaths_%u, sizeof(logo_subpaths_%u) / sizeof(Path), "
+               "sizeof(logo_subpaths_%u) / sizeof(Path), { %u, %u, %u, %u }, FILL_NONZERO },\n",
+               i, i, i, c.r, c.g, c.b, c.a);
+    }
+    printf("};\n\n");
+
+    printf("const SVGScene logo_scene = {\n");
+    printf("    logo_paths, %u,\n    ", logo_num_paths);
+    print_float(min_x);
+    printf(", ");
+    print_float(min_y);
+    printf(",\n    ");
+    print_float(max_x);
+    printf(", ");
+    print_float(max_y);
+    printf(",\n    { ");
+    print_float(logo_view_box.x);
+    printf(", ");
+    print_float(logo_view_box.y);
+    printf(", ");
+    print_float(logo_view_box.width);
+    printf(", ");
+    print_float(logo_view_box.height);
+    printf(" }\n};\n");
+
+    return 0;
+}
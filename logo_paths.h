@@ -0,0 +1,17 @@
+#ifndef LOGO_PATHS_H
+#define LOGO_PATHS_H
+
+#include "svg_types.h"
+
+/* SVG source of the logo
+ * logo_path_data: Path data of each component
+ * logo_path_colors: Fill color of each component
+ * logo_view_box: Area of user space the logo is laid out in
+ * Only logo_gen reads these, the splash links the generated logo table.
+ */
+extern const char *const logo_path_data[];
+extern const char *const logo_path_colors[];
+extern const unsigned int logo_num_paths;
+extern const ViewBox logo_view_box;
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef LOGO_TABLE_H
+#define LOGO_TABLE_H
+
+#include "svg_types.h"
+
+/* Logo geometry flattened at build time by logo_gen
+ * All points, subpaths and paths are read-only data
+ */
+extern const SVGScene logo_scene;
+
+#endif
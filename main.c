@@ -1,125 +1,630 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
+#include <ctype.h>
 #include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <getopt.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 #include "fbsplash.h"
-#include "svg_parser.h"
 #include "svg_renderer.h"
 #include "dt_rotation.h"
+#include "logo_table.h"
+#include "raster_cache.h"
+#include "resolve.h"
+#include "prof.h"
+#include "progress.h"
+#include "text.h"
+#include "splash_daemon.h"
+#include "svg_loader.h"
+#include "image.h"
+#include "background.h"
 
-/*
- * SVG path data for rendering the logo
- * Contains the path data for each component of the logo
- * Index meaning:
- * 0: "U" in logo
- * 1: "N" in logo
- * 2: "O" in logo
- * 2: "F" in logo
- * 3: "F" in logo
- * 4: "I" in logo
- * 5: "C" in logo
- * 6: "I" in logo
- * 7: "A" in logo
- * 8: "L" in logo
- * 9: "O" in logo
- *10: "S" in logo
+/* Time the process entered its first constructor, as close to exec as we get */
+static struct timespec exec_time;
+
+__attribute__((constructor))
+static void record_exec_time(void) {
+    clock_gettime(CLOCK_MONOTONIC, &exec_time);
+}
+
+/* Milliseconds elapsed between two timestamps */
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/* Parse a decimal option value, all of it
+ * Returns: false on a sign, trailing characters or a value above max
  */
-const char *svg_paths[] = {
-    "M 99.00 274.08 L 99.00 235.26 L 123.06 235.26 L 123.06 79.68 L 187.80 79.68 L 187.80 235.26 L 148.98 274.08 L 99.00 274.08 M 38.94 274.08 L 0 235.26 L 0 79.68 L 64.92 79.68 L 64.92 235.26 L 88.74 235.26 L 88.74 274.08 L 38.94 274.08 Z",
-    "M 338.22 274.08 L 220.44 79.68 L 288.84 79.68 L 407.10 274.08 L 338.22 274.08 M 407.10 255.60 L 350.70 162.72 L 350.70 79.68 L 407.10 79.68 L 407.10 255.60 M 220.44 274.08 L 220.44 98.16 L 276.84 190.56 L 276.84 274.08 L 220.44 274.08 Z",
-    "M 536.28 274.08 L 536.28 234.54 L 561.06 234.54 L 561.06 119.10 L 536.28 119.10 L 536.28 79.68 L 586.50 79.68 L 625.80 118.50 L 625.80 235.26 L 586.50 274.08 L 536.28 274.08 M 476.22 274.08 L 436.80 235.26 L 436.80 118.50 L 476.22 79.68 L 526.02 79.68 L 526.02 119.10 L 501.72 119.10 L 501.72 234.54 L 526.02 234.54 L 526.02 274.08 L 476.22 274.08 Z",
-    "M 655.68 274.08 L 655.68 79.68 L 720.42 79.68 L 720.42 166.56 L 780.18 166.56 L 780.18 204.78 L 720.42 204.78 L 720.42 274.08 L 655.68 274.08 M 764.64 144.12 L 764.64 118.50 L 730.68 118.50 L 730.68 79.68 L 829.38 79.68 L 829.38 144.12 L 764.64 144.12 Z",
-    "M 850.32 274.08 L 850.32 79.68 L 915.06 79.68 L 915.06 166.56 L 974.88 166.56 L 974.88 204.78 L 915.06 204.78 L 915.06 274.08 L 850.32 274.08 M 959.34 144.12 L 959.34 118.50 L 925.32 118.50 L 925.32 79.68 L 1024.08 79.68 L 1024.08 144.12 L 959.34 144.12 Z",
-    "M 1042.08 274.08 L 1042.08 232.62 L 1045.58 232.62 L 1045.58 121.02 L 1042.08 121.02 L 1042.08 79.68 L 1145.82 79.68 L 1145.82 121.02 L 1142.40 121.02 L 1142.40 232.62 L 1145.82 232.62 L 1145.82 274.08 L 1042.08 274.08 Z",
-    "M 1213.20 274.08 L 1174.20 235.26 L 1174.20 118.50 L 1213.20 79.68 L 1238.94 79.68 L 1238.94 274.08 L 1213.20 274.08 M 1292.28 157.62 L 1292.28 118.50 L 1249.20 118.50 L 1249.20 79.68 L 1318.20 79.68 L 1357.02 118.50 L 1357.02 157.62 L 1292.28 157.62 M 1249.20 274.08 L 1249.20 235.26 L 1292.28 235.26 L 1292.28 206.82 L 1357.02 206.82 L 1357.02 235.26 L 1318.20 274.08 L 1249.20 274.08 Z",
-    "M 1385.16 274.08 L 1385.16 232.62 L 1404.66 232.62 L 1404.66 121.02 L 1385.16 121.02 L 1385.16 79.68 L 1488.84 79.68 L 1488.84 121.02 L 1469.40 121.02 L 1469.40 232.62 L 1488.84 232.62 L 1488.84 274.08 L 1385.16 274.08 Z",
-    "M 1656.00 274.08 L 1647.78 252.84 L 1584.24 252.84 L 1597.68 214.32 L 1632.84 214.32 L 1580.88 79.68 L 1644.00 79.68 L 1721.46 274.08 L 1656.00 274.08 M 1504.38 274.08 L 1573.80 88.50 L 1602.54 165.66 L 1566.96 274.08 L 1504.38 274.08 Z",
-    "M 1739.94 274.08 L 1739.94 79.68 L 1804.68 79.68 L 1804.68 274.08 L 1739.94 274.08 M 1814.94 274.08 L 1814.94 235.26 L 1847.04 235.26 L 1847.04 210.66 L 1905.78 210.66 L 1905.78 274.08 L 1814.94 274.08 Z",
-    "M 2021.34 274.08 L 2021.34 234.54 L 2046.12 234.54 L 2046.12 119.10 L 2021.34 119.10 L 2021.34 79.68 L 2071.56 79.68 L 2110.86 118.50 L 2110.86 235.26 L 2071.56 274.08 L 2021.34 274.08 M 1961.28 274.08 L 1921.86 235.26 L 1921.86 118.50 L 1961.28 79.68 L 2011.08 79.68 L 2011.08 119.10 L 1986.78 119.10 L 1986.78 234.54 L 2011.08 234.54 L 2011.08 274.08 L 1961.28 274.08 Z",
-    "M 2260.86 274.08 L 2260.86 201.24 L 2176.74 201.24 L 2137.80 162.30 L 2137.80 118.50 L 2176.74 79.68 L 2199.76 79.68 L 2199.76 148.68 L 2288.10 148.68 L 2325.72 187.62 L 2325.72 235.26 L 2286.90 274.08 L 2260.86 274.08 M 2260.86 134.16 L 2260.86 114.72 L 2208.96 114.72 L 2208.96 79.68 L 2286.78 79.68 L 2320.44 113.52 L 2320.44 134.16 L 2260.86 134.16 M 2170.44 274.08 L 2137.80 235.26 L 2137.80 215.76 L 2202.54 215.76 L 2202.54 238.92 L 2250.60 238.92 L 2250.60 274.08 L 2170.44 274.08 Z"
-};
-
-/* Color definitions for each path component
- * First 4 paths are red (brand color)
- * Last 3 paths are gray (secondary color)
+static bool parse_option_uint(const char *arg, unsigned long max, uint32_t *value) {
+    // strtoul would take leading blanks and a minus sign
+    if (!isdigit((unsigned char)*arg)) {
+        return false;
+    }
+
+    char *end;
+    errno = 0;
+    unsigned long v = strtoul(arg, &end, 10);
+    if (errno != 0 || *end != '\0' || v > max) {
+        return false;
+    }
+    *value = (uint32_t)v;
+    return true;
+}
+
+/* Anti-aliasing engines for the help text, the default depends on the build */
+#ifdef SPLASH_FIXED_POINT
+#define AA_ENGINES "supersample, analytic, fixed (default) or reference"
+#else
+#define AA_ENGINES "supersample (default), analytic, fixed or reference"
+#endif
+
+/* Most render threads -j takes, well past the cores of any target board */
+#define MAX_THREADS 256
+
+/* Name of an output mode for reports */
+static const char *fb_output_mode_name(FbOutputMode mode) {
+    switch (mode) {
+        case FB_OUTPUT_SHADOW: return "shadow";
+        case FB_OUTPUT_FLIP: return "flip";
+        default: return "mmap";
+    }
+}
+
+/* Device tree rotation lookup run beside the framebuffer setup */
+typedef struct {
+    const DtConfig *config;
+    int rotation;
+} RotationJob;
+
+static void *lookup_rotation(void *arg) {
+    RotationJob *job = arg;
+
+    PROF_PHASE_BEGIN(rotation_start);
+    job->rotation = dt_get_rotation(job->config);
+    PROF_PHASE_END(rotation_start, "dt_rotation");
+    return NULL;
+}
+
+/* Parsing and flattening of an SVG file run beside the clear */
+typedef struct {
+    const SvgFile *file;
+    float tolerance;
+    SVGScene *scene;
+} LoadJob;
+
+static void *load_geometry(void *arg) {
+    LoadJob *job = arg;
+
+    PROF_PHASE_BEGIN(load_svg_start);
+    job->scene = svg_load_scene(job->file, job->tolerance);
+    PROF_PHASE_END(load_svg_start, "svg_load");
+    return NULL;
+}
+
+/* Run a startup job on a thread of its own, or right here
+ * Jobs run inline in sequential mode and when no thread can be started.
+ * Returns: true if the job runs on a thread and finish_job() must join it
+ */
+static bool start_job(pthread_t *thread, void *(*job)(void *), void *arg, bool pipelined) {
+    if (pipelined && pthread_create(thread, NULL, job, arg) == 0) {
+        return true;
+    }
+    job(arg);
+    return false;
+}
+
+/* Wait for a job from start_job() to finish */
+static void finish_job(pthread_t thread, bool started) {
+    if (started) {
+        pthread_join(thread, NULL);
+    }
+}
+
+/* Update the progress bar from percentages on stdin, one per line
+ * Page flipping keeps every update tear-free. Drivers that cannot pan
+ * get the bar rows written in place, or flushed from the shadow buffer.
  */
-const char *svg_colors[] = {
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(40,40,180)",  // Blue
-    "rgb(85,85,85)",   // Gray
-    "rgb(85,85,85)",   // Gray
-};
-
-#define NUM_PATHS (sizeof(svg_paths) / sizeof(svg_paths[0]))
+static void run_progress(Framebuffer *fb, ProgressBar *bar) {
+    fb_flip_init(fb);
+
+    char line[64];
+    while (fgets(line, sizeof(line), stdin)) {
+        char *end;
+        long percent = strtol(line, &end, 10);
+        if (end == line) {
+            continue;
+        }
+
+        progress_bar_draw(fb, bar, (int)percent);
+        fb_flush(fb);
+    }
+}
+
+/* Print command line usage */
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -b, --backend NAME     Output backend: fbdev (default), memory, raw or ppm\n"
+            "  -o, --output PATH      Device for fbdev, output file for raw and ppm\n"
+            "  -g, --geometry WxH     Resolution, default is the current or 1920x1080\n"
+            "  -d, --depth BPP        Bits per pixel\n"
+            "  -s, --stride BYTES     Line stride in bytes\n"
+            "  -m, --mode MODE        Output mode: mmap (default) or shadow\n"
+            "  -r, --readback         Seed the shadow buffer with the current screen\n"
+            "  -a, --aa ENGINE        Anti-aliasing: " AA_ENGINES "\n"
+            "  -R, --rotation DEG     Override the device tree rotation\n"
+            "  -D, --dt-root PATH     Device tree to read the rotation from, uncached.\n"
+            "                         Also set by SPLASH_DT_ROOT\n"
+            "  -j, --threads N        Render threads, default is the online CPU count\n"
+            "  -c, --cache PATH       Reuse or store the rendered logo in a raster cache\n"
+            "  -B, --background SPEC  Background: COLOR, a TOP:BOTTOM gradient or tile:FILE\n"
+            "                         for a binary PPM tile. Default is black. Colors are\n"
+            "                         #rrggbb, #rgb, rgb(r,g,b), black or white\n"
+            "  -L, --linear-blend     Blend logo edges with the background in linear light\n"
+            "  -S, --svg FILE         Show the paths of an SVG file instead of the built-in\n"
+            "                         logo, laid out by its viewBox\n"
+            "  -I, --image FILE       Show a QOI picture instead of the logo, centered at\n"
+            "                         its own size or shrunk to fit the screen\n"
+            "  -F, --fit              Scale the picture to the area of the logo\n"
+            "  -P, --progress         Show a progress bar, updated with percentages\n"
+            "                         read from stdin until it is closed\n"
+            "  -T, --text TEXT        Show a status line, e.g. a boot stage or version,\n"
+            "                         under the logo\n"
+            "  -l, --listen PATH      Keep running and take commands on a control socket\n"
+            "  -x, --send COMMAND     Send a command to a running splash and exit, to the\n"
+            "                         --listen socket or " SPLASH_DAEMON_SOCKET "\n"
+            "  -q, --sequential       Run the startup steps one after another instead of\n"
+            "                         overlapping the rotation lookup, framebuffer setup,\n"
+            "                         clear and parsing\n"
+            "  -t, --timing           Report startup and render times on stderr\n"
+            "  -p, --profile[=FILE]   Profile boot phases and render counters, to stderr\n"
+            "                         or as JSON to FILE. Also set by SPLASH_PROFILE\n"
+            "  -h, --help             Show this help\n",
+            prog);
+}
 
 /*
  * Main program entry point
  */
-int main(void) {
-    const char *fb_device = "/dev/fb0";
+int main(int argc, char **argv) {
+    FbConfig fb_config = { &fb_backend_fbdev, "/dev/fb0", FB_OUTPUT_MMAP, false, 0, 0, 0, 0, 0 };
+    RenderOptions render_options = { RENDER_AA_DEFAULT, 0, NULL, false, NULL, false };
+    int rotation_override = -1;
+    DtConfig dt_config = { DT_DEFAULT_ROOT, DT_DEFAULT_BLOB, DT_DEFAULT_CACHE };
+    const char *dt_root = getenv("SPLASH_DT_ROOT");
+    uint32_t threads = 0;
+    const char *cache_path = NULL;
+    const char *svg_path = NULL;
+    const char *image_path = NULL;
+    bool image_fit = false;
+    const char *background_spec = NULL;
+    bool timing = false;
+    bool pipelined = true;
+    bool progress = false;
+    const char *status_text = NULL;
+    const char *listen_path = NULL;
+    const char *send_command = NULL;
+    const char *profile = getenv("SPLASH_PROFILE");
+
+    static const struct option options[] = {
+        { "backend",  required_argument, NULL, 'b' },
+        { "output",   required_argument, NULL, 'o' },
+        { "geometry", required_argument, NULL, 'g' },
+        { "depth",    required_argument, NULL, 'd' },
+        { "stride",   required_argument, NULL, 's' },
+        { "mode",     required_argument, NULL, 'm' },
+        { "readback", no_argument,       NULL, 'r' },
+        { "aa",       required_argument, NULL, 'a' },
+        { "rotation", required_argument, NULL, 'R' },
+        { "dt-root",  required_argument, NULL, 'D' },
+        { "threads",  required_argument, NULL, 'j' },
+        { "cache",    required_argument, NULL, 'c' },
+        { "background", required_argument, NULL, 'B' },
+        { "linear-blend", no_argument,   NULL, 'L' },
+        { "svg",      required_argument, NULL, 'S' },
+        { "image",    required_argument, NULL, 'I' },
+        { "fit",      no_argument,       NULL, 'F' },
+        { "progress", no_argument,       NULL, 'P' },
+        { "text",     required_argument, NULL, 'T' },
+        { "listen",   required_argument, NULL, 'l' },
+        { "send",     required_argument, NULL, 'x' },
+        { "sequential", no_argument,     NULL, 'q' },
+        { "timing",   no_argument,       NULL, 't' },
+        { "profile",  optional_argument, NULL, 'p' },
+        { "help",     no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
 
-    // Get rotation from device tree
-    int rotation = get_display_rotation();
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:o:g:d:s:m:ra:R:D:j:c:B:LS:I:FPT:l:x:qtp::h", options, NULL)) != -1) {
+        switch (opt) {
+            case 'b':
+                fb_config.backend = fb_backend_find(optarg);
+                if (!fb_config.backend) {
+                    fprintf(stderr, "Unknown backend: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'o':
+                fb_config.path = optarg;
+                break;
+            case 'g':
+                if (sscanf(optarg, "%ux%u", &fb_config.width, &fb_config.height) != 2) {
+                    fprintf(stderr, "Invalid geometry: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'd':
+                if (!parse_option_uint(optarg, 32, &fb_config.bpp)) {
+                    fprintf(stderr, "Invalid depth: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 's':
+                if (!parse_option_uint(optarg, UINT32_MAX, &fb_config.stride)) {
+                    fprintf(stderr, "Invalid stride: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'm':
+                if (strcmp(optarg, "mmap") == 0) {
+                    fb_config.mode = FB_OUTPUT_MMAP;
+                } else if (strcmp(optarg, "shadow") == 0) {
+                    fb_config.mode = FB_OUTPUT_SHADOW;
+                } else {
+                    fprintf(stderr, "Unknown output mode: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'r':
+                fb_config.readback = true;
+                break;
+            case 'a':
+                if (strcmp(optarg, "supersample") == 0) {
+                    render_options.aa = RENDER_AA_SUPERSAMPLE;
+                } else if (strcmp(optarg, "analytic") == 0) {
+                    render_options.aa = RENDER_AA_ANALYTIC;
+                } else if (strcmp(optarg, "fixed") == 0) {
+                    render_options.aa = RENDER_AA_FIXED;
+                } else if (strcmp(optarg, "reference") == 0) {
+                    render_options.aa = RENDER_AA_REFERENCE;
+                } else {
+                    fprintf(stderr, "Unknown anti-aliasing engine: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'R':
+                rotation_override = (atoi(optarg) % 360 + 360) % 360 / 90 * 90;
+                break;
+            case 'D':
+                dt_root = optarg;
+                break;
+            case 'j':
+                if (!parse_option_uint(optarg, MAX_THREADS, &threads) || threads == 0) {
+                    fprintf(stderr, "Invalid thread count: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'c':
+                cache_path = optarg;
+                break;
+            case 'B':
+                background_spec = optarg;
+                break;
+            case 'L':
+                render_options.linear_blend = true;
+                break;
+            case 'S':
+                svg_path = optarg;
+                break;
+            case 'I':
+                image_path = optarg;
+                break;
+            case 'F':
+                image_fit = true;
+                break;
+            case 'P':
+                progress = true;
+                fb_config.pages = 2;
+                break;
+            case 'T':
+                status_text = optarg;
+                break;
+            case 'l':
+                listen_path = optarg;
+                fb_config.pages = 2;
+                break;
+            case 'x':
+                send_command = optarg;
+                break;
+            case 'q':
+                pipelined = false;
+                break;
+            case 't':
+                timing = true;
+                break;
+            case 'p':
+                profile = optarg ? optarg : "-";
+                break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    // A client only talks to the splash that owns the screen
+    if (send_command) {
+        char reply[SPLASH_DAEMON_MAX_MESSAGE];
+        int ret = splash_daemon_send(listen_path ? listen_path : SPLASH_DAEMON_SOCKET,
+                                     send_command, reply, sizeof(reply));
+        if (ret < 0) {
+            fprintf(stderr, "%s\n", reply);
+        }
+        return ret < 0 ? 1 : 0;
+    }
 
-    // Check framebuffer device accessibility
-    if (access(fb_device, R_OK | W_OK) != 0) {
-        fprintf(stderr, "Cannot access %s: %s\n", fb_device, strerror(errno));
+    // The daemon switches between vector logos, which a picture has no place in
+    if (image_path && listen_path) {
+        fprintf(stderr, "--image cannot be combined with --listen\n");
         return 1;
     }
 
+    // The default device only makes sense for fbdev
+    if (fb_config.backend != &fb_backend_fbdev && strcmp(fb_config.path, "/dev/fb0") == 0) {
+        fb_config.path = NULL;
+    }
+
+    // SPLASH_PROFILE=1 is the same as a bare --profile
+    if (profile && (*profile == '\0' || strcmp(profile, "1") == 0)) {
+        profile = "-";
+    }
+    if (prof_init(&exec_time, profile) < 0) {
+        return 1;
+    }
+
+    // Without a background the screen is plain black
+    Background background;
+    if (background_spec) {
+        if (background_parse(&background, background_spec) < 0) {
+            return 1;
+        }
+        render_options.background = &background;
+    }
+
+    // Another tree has no flattened blob to key the cache on
+    if (dt_root && *dt_root) {
+        dt_config.root = dt_root;
+        dt_config.blob = NULL;
+    }
+
+    // The device tree walk runs while the file is mapped and the framebuffer set up
+    RotationJob rotation_job = { &dt_config, rotation_override };
+    pthread_t rotation_thread;
+    bool rotation_threaded = false;
+    if (rotation_override < 0) {
+        rotation_threaded = start_job(&rotation_thread, lookup_rotation, &rotation_job, pipelined);
+    }
+
+    // A picture replaces any logo, and there is no rendered logo to cache
+    ImageFile *image = NULL;
+    if (image_path) {
+        image = image_open(image_path);
+        if (image) {
+            cache_path = NULL;
+        } else {
+            fprintf(stderr, "Falling back to the logo\n");
+        }
+    }
+
+    // An SVG file replaces the built-in logo, its viewBox drives the layout
+    const SVGScene *scene = &logo_scene;
+    SVGScene *loaded_scene = NULL;
+    SvgFile *svg_file = NULL;
+    if (svg_path && !image) {
+        svg_file = svg_open(svg_path);
+        if (!svg_file) {
+            fprintf(stderr, "Falling back to the built-in logo\n");
+        }
+    }
+
     // Initialize framebuffer
-    Framebuffer *fb = fb_init(fb_device);
+    PROF_PHASE_BEGIN(fb_start);
+    Framebuffer *fb = fb_init(&fb_config);
+    PROF_PHASE_END(fb_start, "fb_init");
+    finish_job(rotation_thread, rotation_threaded);
+    render_options.rotation = rotation_job.rotation;
     if (!fb) {
         fprintf(stderr, "Failed to initialize framebuffer\n");
+        svg_close(svg_file);
+        image_close(image);
+        if (background_spec) background_free(&background);
         return 1;
     }
 
     // Calculate display parameters
-    DisplayInfo *display_info = calculate_display_info(fb);
+    const ViewBox *view_box = svg_file ? svg_view_box(svg_file) : &logo_scene.view_box;
+    DisplayInfo *display_info = image ? image_display_info(fb, image, render_options.rotation, image_fit) :
+                                calculate_display_info(fb, view_box, render_options.rotation);
     if (!display_info) {
         fprintf(stderr, "Failed to calculate display information\n");
+        svg_close(svg_file);
+        image_close(image);
         fb_cleanup(fb);
+        if (background_spec) background_free(&background);
         return 1;
     }
 
-    // Clear screen to black
-    for (uint32_t y = 0; y < fb->vinfo.yres; y++) {
-        for (uint32_t x = 0; x < fb->vinfo.xres; x++) {
-            set_pixel(fb, x, y, 0x00000000);
+    // Curves of the file are flattened for the final scale, while the screen clears
+    LoadJob load_job = { svg_file, 0, NULL };
+    pthread_t load_thread;
+    bool load_threaded = false;
+    if (svg_file) {
+        load_job.tolerance = render_flatten_tolerance(display_info);
+        load_threaded = start_job(&load_thread, load_geometry, &load_job, pipelined);
+    }
+
+    struct timespec render_start, render_end, flush_end;
+    clock_gettime(CLOCK_MONOTONIC, &render_start);
+
+    // The background goes around the logo area, which rendering, the cache or
+    // the picture fills
+    int turns = render_options.rotation / 90 % 4;
+    FbRect logo_rect;
+    if (image) {
+        image_area(fb, display_info, &render_options, &logo_rect);
+    } else {
+        render_logo_area(fb, display_info, &render_options, &logo_rect);
+    }
+    PROF_PHASE_BEGIN(background_start);
+    background_draw(fb, render_options.background, turns, NULL, &logo_rect);
+    PROF_PHASE_END(background_start, "background");
+
+    // Rendering waits for the geometry
+    if (svg_file) {
+        finish_job(load_thread, load_threaded);
+        svg_close(svg_file);
+
+        if (load_job.scene) {
+            loaded_scene = load_job.scene;
+            scene = loaded_scene;
+        } else {
+            fprintf(stderr, "Falling back to the built-in logo\n");
+            free(display_info);
+            display_info = calculate_display_info(fb, &logo_scene.view_box, render_options.rotation);
+            if (!display_info) {
+                fprintf(stderr, "Failed to calculate display information\n");
+                fb_cleanup(fb);
+                if (background_spec) background_free(&background);
+                return 1;
+            }
+
+            // The built-in logo has an area of its own
+            FbRect file_rect = logo_rect;
+            render_logo_area(fb, display_info, &render_options, &logo_rect);
+            background_draw(fb, render_options.background, turns, &file_rect, &logo_rect);
         }
     }
 
-    // Process and render each path component
-    for (size_t i = 0; i < NUM_PATHS; i++) {
-        SVGPath *svg = parse_svg_path(svg_paths[i], svg_colors[i]);
-        if (!svg) {
-            fprintf(stderr, "Failed to parse SVG path %zu\n", i);
-            continue;
+    // A cached raster for this display mode replaces rendering entirely
+    RasterCacheKey cache_key;
+    bool cache_hit = false;
+    if (cache_path) {
+        PROF_PHASE_BEGIN(load_start);
+        raster_cache_key(&cache_key, fb, scene, &render_options);
+        cache_hit = raster_cache_load(cache_path, fb, &cache_key) == 0;
+        PROF_PHASE_END(load_start, "cache_load");
+    }
+
+    // A picture is decoded onto the screen row by row
+    if (image) {
+        PROF_PHASE_BEGIN(image_start);
+        int drawn = image_draw(fb, image, display_info, &render_options);
+        PROF_PHASE_END(image_start, "image");
+
+        // A picture that breaks off gives way to the logo like one that does not open
+        if (drawn != 0) {
+            fprintf(stderr, "Failed to draw %s, falling back to the logo\n", image_path);
+            image_close(image);
+            image = NULL;
+            free(display_info);
+            display_info = calculate_display_info(fb, &logo_scene.view_box, render_options.rotation);
+            if (!display_info) {
+                fprintf(stderr, "Failed to calculate display information\n");
+                fb_cleanup(fb);
+                if (background_spec) background_free(&background);
+                return 1;
+            }
+
+            FbRect picture_rect = logo_rect;
+            render_logo_area(fb, display_info, &render_options, &logo_rect);
+            background_draw(fb, render_options.background, turns, &picture_rect, &logo_rect);
         }
+    }
 
-        // Apply rotation from device tree if specified
-        if (rotation)
-            rotate_svg_path(svg, rotation);
+    // Render all paths of the logo in one sweep
+    if (!cache_hit && !image) {
+        // Without a pool everything still renders on this thread
+        PROF_PHASE_BEGIN(pool_start);
+        render_options.pool = thread_pool_create(threads);
+        PROF_PHASE_END(pool_start, "thread_pool");
 
-        // Render the path
-        render_svg_path(fb, svg, display_info);
-        free_svg_path(svg);
+        PROF_PHASE_BEGIN(scene_start);
+        render_scene(fb, scene, display_info, &render_options);
+        PROF_PHASE_END(scene_start, "render");
     }
 
+    // The bar starts out empty in the first frame
+    ProgressBar bar;
+    if (progress) {
+        progress_bar_init(&bar, fb, display_info, render_options.rotation);
+        progress_bar_draw(fb, &bar, 0);
+    }
+
+    // Status line in the first frame, a daemon takes it over with its atlas
+    TextLine status_line;
+    bool status_shown = status_text &&
+                        text_line_init(&status_line, fb, display_info, render_options.rotation,
+                                       render_options.background) == 0;
+    if (status_shown) {
+        text_line_draw(fb, &status_line, status_text);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &render_end);
+
     // Flush changes to the framebuffer
+    PROF_PHASE_BEGIN(flush_start);
     fb_flush(fb);
+    PROF_PHASE_END(flush_start, "flush");
+
+    clock_gettime(CLOCK_MONOTONIC, &flush_end);
+
+    // Store the fresh render once the splash is already visible
+    if (cache_path && !cache_hit) {
+        PROF_PHASE_BEGIN(store_start);
+        raster_cache_store(cache_path, fb, &cache_key, &logo_rect);
+        PROF_PHASE_END(store_start, "cache_store");
+    }
+
+    if (timing) {
+        fprintf(stderr, "backend=%s mode=%s %ux%u bpp=%u stride=%u cache=%s threads=%u resolve=%s pipeline=%s "
+                "exec_to_flush_ms=%.3f render_ms=%.3f flush_ms=%.3f\n",
+                fb->backend->name, fb_output_mode_name(fb->mode),
+                fb->vinfo.xres, fb->vinfo.yres, fb->vinfo.bits_per_pixel, fb->finfo.line_length,
+                cache_path ? (cache_hit ? "hit" : "miss") : "off",
+                thread_pool_size(render_options.pool), resolve_kernel()->name,
+                pipelined ? "on" : "off", elapsed_ms(&exec_time, &flush_end),
+                elapsed_ms(&render_start, &render_end),
+                elapsed_ms(&render_end, &flush_end));
+    }
+
+    prof_report();
+
+    // The daemon takes over updates from stdin
+    if (listen_path) {
+        SplashDaemon *daemon = splash_daemon_create(listen_path, fb, display_info, scene, &render_options,
+                                                    status_shown ? &status_line : NULL);
+        if (daemon) {
+            status_shown = false;
+            splash_daemon_run(daemon);
+            splash_daemon_destroy(daemon);
+        }
+    } else if (progress) {
+        run_progress(fb, &bar);
+    }
 
     // Clean up
+    thread_pool_destroy(render_options.pool);
+    if (status_shown) text_line_free(&status_line);
+    svg_free_scene(loaded_scene);
+    image_close(image);
     free(display_info);
+    if (background_spec) background_free(&background);
     fb_cleanup(fb);
 
     return 0;
@@ -0,0 +1,348 @@
+#include <string.h>
+#include "pixel_format.h"
+#include "resolve.h"
+#include "composite.h"
+
+/* Store a packed pixel of the given size */
+static inline void put_pixel(uint8_t *dst, uint32_t pixel, const uint32_t bytes) {
+    switch (bytes) {
+        case 4: *(uint32_t *)dst = pixel; break;
+        case 3:
+            dst[0] = pixel & 0xFF;
+            dst[1] = (pixel >> 8) & 0xFF;
+            dst[2] = (pixel >> 16) & 0xFF;
+            break;
+        case 2: *(uint16_t *)dst = (uint16_t)pixel; break;
+        default: *dst = (uint8_t)pixel; break;
+    }
+}
+
+/* Fill kernels, one per depth */
+static void fill8(uint8_t *dst, uint32_t pixel, uint32_t count) {
+    memset(dst, pixel & 0xFF, count);
+}
+
+static void fill16(uint8_t *dst, uint32_t pixel, uint32_t count) {
+    uint16_t *p = (uint16_t *)dst;
+    for (uint32_t i = 0; i < count; i++) {
+        p[i] = (uint16_t)pixel;
+    }
+}
+
+static void fill24(uint8_t *dst, uint32_t pixel, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++, dst += 3) {
+        put_pixel(dst, pixel, 3);
+    }
+}
+
+static void fill32(uint8_t *dst, uint32_t pixel, uint32_t count) {
+    uint32_t *p = (uint32_t *)dst;
+    for (uint32_t i = 0; i < count; i++) {
+        p[i] = pixel;
+    }
+}
+
+/* Generic store kernel, the depth is a constant after inlining */
+static inline void store_common(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors,
+                                uint32_t count, const uint32_t bytes) {
+    for (uint32_t i = 0; i < count; i++, dst += bytes) {
+        put_pixel(dst, pixel_pack(fmt, colors[i]), bytes);
+    }
+}
+
+static void store8(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, uint32_t count) {
+    store_common(fmt, dst, colors, count, 1);
+}
+
+static void store16(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, uint32_t count) {
+    store_common(fmt, dst, colors, count, 2);
+}
+
+static void store24(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, uint32_t count) {
+    store_common(fmt, dst, colors, count, 3);
+}
+
+static void store32(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, uint32_t count) {
+    store_common(fmt, dst, colors, count, 4);
+}
+
+/* RGB565 with fixed shifts */
+static void store_rgb565(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, uint32_t count) {
+    (void)fmt;
+    resolve_kernel()->pack_rgb565((uint16_t *)dst, colors, count);
+}
+
+/* XRGB8888 matches the color layout, a plain copy */
+static void store_xrgb8888(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, uint32_t count) {
+    (void)fmt;
+    memcpy(dst, colors, count * sizeof(uint32_t));
+}
+
+/* Generic blend kernel, the depth is a constant after inlining */
+static inline void blend_common(const PixelFormat *fmt, uint8_t *dst, uint32_t color,
+                                const uint8_t *alpha, uint32_t count, const uint32_t bytes) {
+    uint32_t packed = pixel_pack(fmt, color);
+    uint32_t fg_r = (color >> 16) & 0xFF;
+    uint32_t fg_g = (color >> 8) & 0xFF;
+    uint32_t fg_b = color & 0xFF;
+
+    for (uint32_t i = 0; i < count; i++, dst += bytes) {
+        uint32_t a = alpha[i];
+        if (a == 0) {
+            continue;
+        }
+        if (a == 255) {
+            put_pixel(dst, packed, bytes);
+            continue;
+        }
+
+        uint32_t bg = pixel_unpack(fmt, pixel_load(fmt, dst));
+        uint32_t ia = 255 - a;
+        uint32_t r = composite_div255(fg_r * a + ((bg >> 16) & 0xFF) * ia);
+        uint32_t g = composite_div255(fg_g * a + ((bg >> 8) & 0xFF) * ia);
+        uint32_t b = composite_div255(fg_b * a + (bg & 0xFF) * ia);
+
+        put_pixel(dst, pixel_pack(fmt, (r << 16) | (g << 8) | b), bytes);
+    }
+}
+
+static void blend8(const PixelFormat *fmt, uint8_t *dst, uint32_t color, const uint8_t *alpha, uint32_t count) {
+    blend_common(fmt, dst, color, alpha, count, 1);
+}
+
+static void blend16(const PixelFormat *fmt, uint8_t *dst, uint32_t color, const uint8_t *alpha, uint32_t count) {
+    blend_common(fmt, dst, color, alpha, count, 2);
+}
+
+static void blend24(const PixelFormat *fmt, uint8_t *dst, uint32_t color, const uint8_t *alpha, uint32_t count) {
+    blend_common(fmt, dst, color, alpha, count, 3);
+}
+
+static void blend32(const PixelFormat *fmt, uint8_t *dst, uint32_t color, const uint8_t *alpha, uint32_t count) {
+    blend_common(fmt, dst, color, alpha, count, 4);
+}
+
+/* Generic source-over kernel for premultiplied colors
+ * Opaque pixels are stored without reading the screen, partly covered ones
+ * keep what shows through of the pixel below.
+ */
+static inline void over_common(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors,
+                               const uint8_t *alpha, uint32_t count, const uint32_t bytes) {
+    for (uint32_t i = 0; i < count; i++, dst += bytes) {
+        uint32_t a = alpha[i];
+        if (a == 0) {
+            continue;
+        }
+        uint32_t color = colors[i];
+        if (a != 255) {
+            color += composite_scale(pixel_unpack(fmt, pixel_load(fmt, dst)), 255 - a);
+        }
+        put_pixel(dst, pixel_pack(fmt, color), bytes);
+    }
+}
+
+/* Generic source-over kernel in linear light
+ * The premultiplied sRGB color is divided by its alpha again, then both
+ * colors go through the tables into linear light and the sum back to sRGB.
+ */
+static inline void over_linear_common(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors,
+                                      const uint8_t *alpha, uint32_t count, const uint32_t bytes) {
+    const CompositeTables *t = composite_tables();
+
+    for (uint32_t i = 0; i < count; i++, dst += bytes) {
+        uint32_t a = alpha[i];
+        if (a == 0) {
+            continue;
+        }
+        uint32_t color = colors[i];
+        if (a != 255) {
+            uint32_t bg = pixel_unpack(fmt, pixel_load(fmt, dst));
+            uint32_t scale = t->unpremultiply[a], ia = 255 - a;
+            uint32_t blended = 0;
+            for (int shift = 0; shift <= 16; shift += 8) {
+                uint32_t fg = (((color >> shift) & 0xFF) * scale + 0x8000) >> 16;
+                if (fg > 255) fg = 255;
+                uint32_t sum = t->linear[fg] * a + t->linear[(bg >> shift) & 0xFF] * ia;
+                blended |= (uint32_t)t->srgb[(sum + 127) / 255] << shift;
+            }
+            color = blended;
+        }
+        put_pixel(dst, pixel_pack(fmt, color), bytes);
+    }
+}
+
+static void over8(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, const uint8_t *alpha,
+                   uint32_t count) {
+    over_common(fmt, dst, colors, alpha, count, 1);
+}
+
+static void over16(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, const uint8_t *alpha,
+                   uint32_t count) {
+    over_common(fmt, dst, colors, alpha, count, 2);
+}
+
+static void over24(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, const uint8_t *alpha,
+                   uint32_t count) {
+    over_common(fmt, dst, colors, alpha, count, 3);
+}
+
+static void over32(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, const uint8_t *alpha,
+                   uint32_t count) {
+    over_common(fmt, dst, colors, alpha, count, 4);
+}
+
+static void over_linear8(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors,
+                          const uint8_t *alpha, uint32_t count) {
+    over_linear_common(fmt, dst, colors, alpha, count, 1);
+}
+
+static void over_linear16(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors,
+                          const uint8_t *alpha, uint32_t count) {
+    over_linear_common(fmt, dst, colors, alpha, count, 2);
+}
+
+static void over_linear24(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors,
+                          const uint8_t *alpha, uint32_t count) {
+    over_linear_common(fmt, dst, colors, alpha, count, 3);
+}
+
+static void over_linear32(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors,
+                          const uint8_t *alpha, uint32_t count) {
+    over_linear_common(fmt, dst, colors, alpha, count, 4);
+}
+
+/* XRGB8888 source-over, red and blue scaled together in one multiply */
+static void over_xrgb8888(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, const uint8_t *alpha,
+                          uint32_t count) {
+    (void)fmt;
+    uint32_t *p = (uint32_t *)dst;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t a = alpha[i];
+        if (a == 0) {
+            continue;
+        }
+        if (a == 255) {
+            p[i] = colors[i];
+            continue;
+        }
+
+        // Both 16-bit lanes divided by 255 with rounding, like composite_div255()
+        uint32_t ia = 255 - a;
+        uint32_t rb = (p[i] & 0xFF00FF) * ia + 0x800080;
+        uint32_t g = (p[i] & 0x00FF00) * ia + 0x008000;
+        rb = ((rb + ((rb >> 8) & 0xFF00FF)) >> 8) & 0xFF00FF;
+        g = ((g + ((g >> 8) & 0x00FF00)) >> 8) & 0x00FF00;
+        p[i] = colors[i] + rb + g;
+    }
+}
+
+/* RGB565 source-over with fixed shifts */
+static void over_rgb565(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, const uint8_t *alpha,
+                        uint32_t count) {
+    (void)fmt;
+    uint16_t *p = (uint16_t *)dst;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t a = alpha[i];
+        if (a == 0) {
+            continue;
+        }
+
+        uint32_t c = colors[i];
+        if (a != 255) {
+            uint32_t ia = 255 - a;
+            uint32_t r = (p[i] >> 11) & 0x1F, g = (p[i] >> 5) & 0x3F, b = p[i] & 0x1F;
+            r = (r << 3) | (r >> 2);
+            g = (g << 2) | (g >> 4);
+            b = (b << 3) | (b >> 2);
+            c += (composite_div255(r * ia) << 16) | (composite_div255(g * ia) << 8) | composite_div255(b * ia);
+        }
+        p[i] = (uint16_t)(((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F));
+    }
+}
+
+/* Take a channel from the screen information, keeping at most 8 bits */
+static PixelChannel channel_from(const struct fb_bitfield *field) {
+    PixelChannel ch = { (uint8_t)field->offset, (uint8_t)field->length };
+    if (ch.bits > 8) {
+        ch.shift += ch.bits - 8;
+        ch.bits = 8;
+    }
+    return ch;
+}
+
+/* Resolve the pixel format for a screen mode */
+int pixel_format_resolve(PixelFormat *fmt, const struct fb_var_screeninfo *vinfo,
+                         const struct fb_fix_screeninfo *finfo) {
+    memset(fmt, 0, sizeof(*fmt));
+    fmt->bytes_per_pixel = vinfo->bits_per_pixel / 8;
+    fmt->red = channel_from(&vinfo->red);
+    fmt->green = channel_from(&vinfo->green);
+    fmt->blue = channel_from(&vinfo->blue);
+
+    bool has_layout = fmt->red.bits && fmt->green.bits && fmt->blue.bits;
+
+    switch (vinfo->bits_per_pixel) {
+        case 8:
+            // Without a true color layout, use an RGB332 palette
+            if (finfo->visual != FB_VISUAL_TRUECOLOR || !has_layout) {
+                fmt->red = (PixelChannel){ 5, 3 };
+                fmt->green = (PixelChannel){ 2, 3 };
+                fmt->blue = (PixelChannel){ 0, 2 };
+                fmt->palettized = true;
+            }
+            fmt->fill = fill8;
+            fmt->store = store8;
+            fmt->blend = blend8;
+            fmt->over = over8;
+            fmt->over_linear = over_linear8;
+            break;
+
+        case 16:
+            if (!has_layout) {
+                fmt->red = (PixelChannel){ 11, 5 };
+                fmt->green = (PixelChannel){ 5, 6 };
+                fmt->blue = (PixelChannel){ 0, 5 };
+            }
+            fmt->fill = fill16;
+            fmt->store = store16;
+            fmt->blend = blend16;
+            fmt->over = over16;
+            fmt->over_linear = over_linear16;
+            if (fmt->red.shift == 11 && fmt->red.bits == 5 &&
+                fmt->green.shift == 5 && fmt->green.bits == 6 &&
+                fmt->blue.shift == 0 && fmt->blue.bits == 5) {
+                fmt->store = store_rgb565;
+                fmt->over = over_rgb565;
+                resolve_kernel();  // Pick the vector kernel before any thread draws
+            }
+            break;
+
+        case 24:
+        case 32:
+            if (!has_layout) {
+                fmt->red = (PixelChannel){ 16, 8 };
+                fmt->green = (PixelChannel){ 8, 8 };
+                fmt->blue = (PixelChannel){ 0, 8 };
+            }
+            fmt->fill = (fmt->bytes_per_pixel == 4) ? fill32 : fill24;
+            fmt->store = (fmt->bytes_per_pixel == 4) ? store32 : store24;
+            fmt->blend = (fmt->bytes_per_pixel == 4) ? blend32 : blend24;
+            fmt->over = (fmt->bytes_per_pixel == 4) ? over32 : over24;
+            fmt->over_linear = (fmt->bytes_per_pixel == 4) ? over_linear32 : over_linear24;
+            if (fmt->bytes_per_pixel == 4 &&
+                fmt->red.shift == 16 && fmt->red.bits == 8 &&
+                fmt->green.shift == 8 && fmt->green.bits == 8 &&
+                fmt->blue.shift == 0 && fmt->blue.bits == 8) {
+                fmt->store = store_xrgb8888;
+                fmt->over = over_xrgb8888;
+            }
+            break;
+
+        default:
+            return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <linux/fb.h>
+
+/* Position of one color channel inside a packed pixel */
+typedef struct {
+    uint8_t shift;          // Bit offset of the channel
+    uint8_t bits;           // Channel width in bits (at most 8)
+} PixelChannel;
+
+typedef struct PixelFormat PixelFormat;
+
+/* Framebuffer pixel format, resolved once from the screen information
+ * Colors passed to the span functions are 0xRRGGBB, pixels are the packed
+ * native values. The span functions are picked per depth and layout so the
+ * inner loops never branch on the format.
+ */
+struct PixelFormat {
+    uint32_t bytes_per_pixel;
+    PixelChannel red;
+    PixelChannel green;
+    PixelChannel blue;
+    bool palettized;        // 8-bit pseudocolor with an RGB332 palette
+
+    // Store one packed pixel count times
+    void (*fill)(uint8_t *dst, uint32_t pixel, uint32_t count);
+    // Convert and store count 0xRRGGBB colors
+    void (*store)(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, uint32_t count);
+    // Blend one color over count pixels with 8-bit alpha per pixel
+    void (*blend)(const PixelFormat *fmt, uint8_t *dst, uint32_t color, const uint8_t *alpha, uint32_t count);
+    // Put count premultiplied colors with 8-bit alpha over the pixels, see composite.h
+    void (*over)(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors, const uint8_t *alpha,
+                 uint32_t count);
+    // The same blended in linear light, gamma-correct on sRGB screens
+    void (*over_linear)(const PixelFormat *fmt, uint8_t *dst, const uint32_t *colors,
+                        const uint8_t *alpha, uint32_t count);
+};
+
+/* Resolve the pixel format for a screen mode
+ * Returns: 0 on success, -1 if the depth is not supported
+ */
+int pixel_format_resolve(PixelFormat *fmt, const struct fb_var_screeninfo *vinfo,
+                         const struct fb_fix_screeninfo *finfo);
+
+/* Pack a 0xRRGGBB color into a native pixel value */
+static inline uint32_t pixel_pack(const PixelFormat *fmt, uint32_t color) {
+    uint32_t r = (color >> 16) & 0xFF;
+    uint32_t g = (color >> 8) & 0xFF;
+    uint32_t b = color & 0xFF;
+
+    return ((r >> (8 - fmt->red.bits)) << fmt->red.shift) |
+           ((g >> (8 - fmt->green.bits)) << fmt->green.shift) |
+           ((b >> (8 - fmt->blue.bits)) << fmt->blue.shift);
+}
+
+/* Expand one channel of a native pixel to 8 bits by bit replication */
+static inline uint32_t pixel_channel_expand(uint32_t pixel, PixelChannel ch) {
+    uint32_t max = (1u << ch.bits) - 1;
+    uint32_t v = (pixel >> ch.shift) & max;
+    if (ch.bits < 4) {
+        return v * 255 / max;
+    }
+    v <<= 8 - ch.bits;
+    return v | (v >> ch.bits);
+}
+
+/* Unpack a native pixel value into a 0xRRGGBB color */
+static inline uint32_t pixel_unpack(const PixelFormat *fmt, uint32_t pixel) {
+    return (pixel_channel_expand(pixel, fmt->red) << 16) |
+           (pixel_channel_expand(pixel, fmt->green) << 8) |
+           pixel_channel_expand(pixel, fmt->blue);
+}
+
+/* Load one native pixel from memory */
+static inline uint32_t pixel_load(const PixelFormat *fmt, const uint8_t *src) {
+    switch (fmt->bytes_per_pixel) {
+        case 4: return *(const uint32_t *)src;
+        case 3: return src[0] | (src[1] << 8) | (src[2] << 16);
+        case 2: return *(const uint16_t *)src;
+        default: return *src;
+    }
+}
+
+#endif
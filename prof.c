@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "prof.h"
+
+#define MAX_PHASES 64
+
+/* Timed phase, times in nanoseconds since the origin */
+typedef struct {
+    const char *name;
+    uint64_t start;
+    uint64_t end;
+} ProfPhase;
+
+/* Statistics of one scene path */
+typedef struct {
+    uint64_t edges;
+    uint64_t rows;           // Rows rasterized
+    uint64_t ns;             // Time rasterizing those rows, summed over threads
+} ProfPath;
+
+#ifndef SPLASH_NO_PROFILE
+bool prof_enabled = false;
+#endif
+
+static uint64_t origin_ns;
+static const char *report_path;       // NULL reports to stderr
+static ProfPhase phases[MAX_PHASES];
+static uint32_t num_phases;
+static ProfPath *paths;
+static uint32_t num_paths;
+static uint64_t counters[PROF_NUM_COUNTERS];
+
+static const char *const counter_names[PROF_NUM_COUNTERS] = {
+    "edges", "intersections", "pixels", "flush_bytes", "allocations",
+};
+
+/* Current CLOCK_MONOTONIC time in nanoseconds */
+uint64_t prof_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/* Start profiling to stderr or a JSON file */
+int prof_init(const struct timespec *origin, const char *output) {
+#ifdef SPLASH_NO_PROFILE
+    (void)origin;
+    if (output) {
+        fprintf(stderr, "Profiling is not built in\n");
+        return -1;
+    }
+    return 0;
+#else
+    if (!output) {
+        return 0;
+    }
+
+    origin_ns = (uint64_t)origin->tv_sec * 1000000000u + origin->tv_nsec;
+    report_path = (strcmp(output, "-") == 0 || strcmp(output, "stderr") == 0) ? NULL : output;
+    prof_enabled = true;
+    return 0;
+#endif
+}
+
+/* Record a phase that ran from start to now
+ * Startup jobs record from their own threads, each takes a slot of its own.
+ */
+void prof_phase_record(const char *name, uint64_t start) {
+    uint64_t end = prof_now();
+    uint32_t slot = __atomic_fetch_add(&num_phases, 1, __ATOMIC_RELAXED);
+    if (slot >= MAX_PHASES) {
+        return;
+    }
+
+    ProfPhase *p = &phases[slot];
+    p->name = name;
+    p->start = start - origin_ns;
+    p->end = end - origin_ns;
+}
+
+/* Size the per-path table for a scene */
+void prof_paths_reserve(uint32_t count) {
+    if (count <= num_paths) {
+        return;
+    }
+
+    ProfPath *grown = realloc(paths, count * sizeof(ProfPath));
+    if (!grown) {
+        return;
+    }
+    memset(grown + num_paths, 0, (count - num_paths) * sizeof(ProfPath));
+    paths = grown;
+    num_paths = count;
+}
+
+/* Add to the statistics of one path */
+void prof_path_add(uint32_t path, uint64_t edges, uint64_t rows, uint64_t ns) {
+    if (path >= num_paths) {
+        return;
+    }
+    __atomic_fetch_add(&paths[path].edges, edges, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&paths[path].rows, rows, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&paths[path].ns, ns, __ATOMIC_RELAXED);
+}
+
+/* Add to a counter */
+void prof_count_add(ProfCounter counter, uint64_t n) {
+    __atomic_fetch_add(&counters[counter], n, __ATOMIC_RELAXED);
+}
+
+/* Current value of a counter */
+uint64_t prof_count_get(ProfCounter counter) {
+    return __atomic_load_n(&counters[counter], __ATOMIC_RELAXED);
+}
+
+/* Phases that fit the table, later ones were dropped */
+static uint32_t recorded_phases(void) {
+    return num_phases < MAX_PHASES ? num_phases : MAX_PHASES;
+}
+
+/* Text report, one line per record */
+static void report_text(FILE *fp) {
+    for (uint32_t i = 0; i < recorded_phases(); i++) {
+        fprintf(fp, "profile phase=%s start_ms=%.3f duration_ms=%.3f\n", phases[i].name,
+                phases[i].start / 1e6, (phases[i].end - phases[i].start) / 1e6);
+    }
+    for (uint32_t i = 0; i < num_paths; i++) {
+        fprintf(fp, "profile path=%u edges=%llu rows=%llu raster_ms=%.3f\n", i,
+                (unsigned long long)paths[i].edges, (unsigned long long)paths[i].rows,
+                paths[i].ns / 1e6);
+    }
+    fprintf(fp, "profile counters");
+    for (int i = 0; i < PROF_NUM_COUNTERS; i++) {
+        fprintf(fp, " %s=%llu", counter_names[i], (unsigned long long)counters[i]);
+    }
+    fprintf(fp, "\n");
+}
+
+/* JSON report */
+static void report_json(FILE *fp) {
+    fprintf(fp, "{\n  \"phases\": [");
+    for (uint32_t i = 0; i < recorded_phases(); i++) {
+        fprintf(fp, "%s\n    { \"name\": \"%s\", \"start_ms\": %.3f, \"duration_ms\": %.3f }",
+                i ? "," : "", phases[i].name, phases[i].start / 1e6,
+                (phases[i].end - phases[i].start) / 1e6);
+    }
+    fprintf(fp, "\n  ],\n  \"paths\": [");
+    for (uint32_t i = 0; i < num_paths; i++) {
+        fprintf(fp, "%s\n    { \"path\": %u, \"edges\": %llu, \"rows\": %llu, \"raster_ms\": %.3f }",
+                i ? "," : "", i, (unsigned long long)paths[i].edges,
+                (unsigned long long)paths[i].rows, paths[i].ns / 1e6);
+    }
+    fprintf(fp, "\n  ],\n  \"counters\": {");
+    for (int i = 0; i < PROF_NUM_COUNTERS; i++) {
+        fprintf(fp, "%s\n    \"%s\": %llu", i ? "," : "", counter_names[i],
+                (unsigned long long)counters[i]);
+    }
+    fprintf(fp, "\n  }\n}\n");
+}
+
+/* Write the report and stop profiling */
+void prof_report(void) {
+    if (!prof_enabled) {
+        return;
+    }
+
+    if (!report_path) {
+        report_text(stderr);
+    } else {
+        FILE *fp = fopen(report_path, "w");
+        if (fp) {
+            report_json(fp);
+            fclose(fp);
+        } else {
+            fprintf(stderr, "Failed to open %s: %m\n", report_path);
+        }
+    }
+
+#ifndef SPLASH_NO_PROFILE
+    prof_enabled = false;
+#endif
+    free(paths);
+    paths = NULL;
+    num_paths = 0;
+}
+
+#ifndef SPLASH_NO_PROFILE
+/* Count heap allocations of the splash code
+ * The link maps malloc, calloc and realloc of our objects to these wrappers
+ * with -Wl,--wrap, allocations inside the C library are not seen.
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    PROF_COUNT(PROF_ALLOCATIONS, 1);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    PROF_COUNT(PROF_ALLOCATIONS, 1);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    PROF_COUNT(PROF_ALLOCATIONS, 1);
+    return __real_realloc(ptr, size);
+}
+#endif
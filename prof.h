@@ -0,0 +1,73 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/* Boot phase profiler and render counters
+ * Off unless prof_init() is called with an output, then every phase,
+ * path and counter below is recorded and prof_report() writes them out.
+ * While off, each probe is one predictable branch on prof_enabled. Building
+ * with SPLASH_NO_PROFILE removes the probes entirely.
+ */
+
+/* Event counters */
+typedef enum {
+    PROF_EDGES,              // Edges built into edge tables
+    PROF_INTERSECTIONS,      // Edge intersections sorted on sample lines
+    PROF_PIXELS,             // Pixels written to the drawing buffer
+    PROF_FLUSH_BYTES,        // Bytes copied or written to the screen on flush
+    PROF_ALLOCATIONS,        // Heap allocations made by the splash code
+    PROF_NUM_COUNTERS
+} ProfCounter;
+
+#ifdef SPLASH_NO_PROFILE
+#define prof_enabled false
+#else
+extern bool prof_enabled;
+#endif
+
+/* Start profiling
+ * origin: Time reported as 0, normally the process start
+ * output: "-" or "stderr" for a text report on stderr, otherwise a path for
+ *         a JSON report. NULL leaves profiling off.
+ * Returns: 0 on success, -1 if the output cannot be used
+ */
+int prof_init(const struct timespec *origin, const char *output);
+
+/* Current CLOCK_MONOTONIC time in nanoseconds */
+uint64_t prof_now(void);
+
+/* Record a phase that ran from start to now, both from prof_now()
+ * Safe from any thread, phases appear in the order they ended.
+ */
+void prof_phase_record(const char *name, uint64_t start);
+
+/* Size the per-path table for a scene, keeps earlier entries */
+void prof_paths_reserve(uint32_t num_paths);
+
+/* Add to the statistics of one path, safe from any thread */
+void prof_path_add(uint32_t path, uint64_t edges, uint64_t rows, uint64_t ns);
+
+/* Add to a counter, safe from any thread */
+void prof_count_add(ProfCounter counter, uint64_t n);
+
+/* Current value of a counter */
+uint64_t prof_count_get(ProfCounter counter);
+
+/* Write the report to the configured output and stop profiling */
+void prof_report(void);
+
+/* Time a phase, PROF_PHASE_END must follow in the same scope */
+#define PROF_PHASE_BEGIN(var) \
+    uint64_t var = prof_enabled ? prof_now() : 0
+
+#define PROF_PHASE_END(var, name) \
+    do { if (prof_enabled) prof_phase_record(name, var); } while (0)
+
+/* Count n events */
+#define PROF_COUNT(counter, n) \
+    do { if (prof_enabled) prof_count_add(counter, n); } while (0)
+
+#endif
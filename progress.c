@@ -0,0 +1,64 @@
+#include "progress.h"
+
+#define PROGRESS_FILL_COLOR 0xE0E0E0
+#define PROGRESS_TRACK_COLOR 0x303030
+#define PROGRESS_MIN_HEIGHT 4    // Thinnest bar in pixels
+
+/* Place a progress bar below the logo */
+void progress_bar_init(ProgressBar *bar, const Framebuffer *fb, const DisplayInfo *display_info,
+                       int rotation) {
+    bar->turns = (rotation / 90) % 4;
+    bar->logical_width = (bar->turns & 1) ? fb->vinfo.yres : fb->vinfo.xres;
+    bar->logical_height = (bar->turns & 1) ? fb->vinfo.xres : fb->vinfo.yres;
+    bar->fill_color = PROGRESS_FILL_COLOR;
+    bar->track_color = PROGRESS_TRACK_COLOR;
+    bar->percent = -1;
+
+    // Half the logo wide, centered below it by half the logo height
+    uint32_t width = display_info->svg_width / 2;
+    uint32_t height = display_info->svg_height / 10;
+    if (height < PROGRESS_MIN_HEIGHT) height = PROGRESS_MIN_HEIGHT;
+
+    uint32_t x = display_info->x_offset + (display_info->svg_width - width) / 2;
+    uint32_t y = display_info->y_offset + display_info->svg_height + display_info->svg_height / 2;
+
+    // Keep the bar on screen on very flat displays
+    if (y + height > bar->logical_height) {
+        y = (bar->logical_height > height) ? bar->logical_height - height : 0;
+    }
+
+    bar->rect.x0 = x;
+    bar->rect.y0 = y;
+    bar->rect.x1 = x + width;
+    bar->rect.y1 = y + height;
+    if (bar->rect.x1 > bar->logical_width) bar->rect.x1 = bar->logical_width;
+    if (bar->rect.y1 > bar->logical_height) bar->rect.y1 = bar->logical_height;
+}
+
+/* Fill a rectangle of the upright picture on the panel */
+static void fill_logical(Framebuffer *fb, const ProgressBar *bar, const FbRect *r, uint32_t color) {
+    if (r->x1 <= r->x0 || r->y1 <= r->y0) {
+        return;
+    }
+
+    FbRect out = fb_rect_rotate(r, bar->turns, bar->logical_width, bar->logical_height);
+    fb_fill_rect(fb, out.x0, out.y0, out.x1 - out.x0, out.y1 - out.y0, color);
+}
+
+/* Draw the bar at percent */
+void progress_bar_draw(Framebuffer *fb, ProgressBar *bar, int percent) {
+    if (percent < 0) percent = 0;
+    if (percent > 100) percent = 100;
+    if (percent == bar->percent) {
+        return;
+    }
+
+    // Done and remaining parts together cover the whole bar every time
+    uint32_t split = bar->rect.x0 + (bar->rect.x1 - bar->rect.x0) * (uint32_t)percent / 100;
+    FbRect done = { bar->rect.x0, bar->rect.y0, split, bar->rect.y1 };
+    FbRect rest = { split, bar->rect.y0, bar->rect.x1, bar->rect.y1 };
+    fill_logical(fb, bar, &done, bar->fill_color);
+    fill_logical(fb, bar, &rest, bar->track_color);
+
+    bar->percent = percent;
+}
@@ -0,0 +1,31 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include "fbsplash.h"
+
+/* Progress bar under the logo
+ * The bar is laid out in logical coordinates like the logo and turned
+ * onto the panel, so it follows the display rotation.
+ */
+typedef struct {
+    FbRect rect;             // Bar in the upright picture
+    int turns;               // Quarter turns onto the panel
+    uint32_t logical_width;  // Size of the upright picture
+    uint32_t logical_height;
+    uint32_t fill_color;     // Done part of the bar
+    uint32_t track_color;    // Remaining part of the bar
+    int percent;             // Value on screen, -1 before the first draw
+} ProgressBar;
+
+/* Place a progress bar below the logo
+ * rotation: Display rotation in degrees, as used for the logo
+ */
+void progress_bar_init(ProgressBar *bar, const Framebuffer *fb, const DisplayInfo *display_info,
+                       int rotation);
+
+/* Draw the bar at percent, clamped to 0..100
+ * Only the bar rectangle is redrawn, and nothing if the value is unchanged.
+ */
+void progress_bar_draw(Framebuffer *fb, ProgressBar *bar, int percent);
+
+#endif
@@ -0,0 +1,115 @@
+#include <stdbool.h>
+#include <string.h>
+#include "qoi.h"
+#include "composite.h"
+
+#define QOI_OP_INDEX 0x00        // 00iiiiii
+#define QOI_OP_DIFF 0x40         // 01rrggbb
+#define QOI_OP_LUMA 0x80         // 10gggggg rrrrbbbb
+#define QOI_OP_RUN 0xC0          // 11llllll
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+#define QOI_MASK 0xC0
+
+/* Largest picture the format allows, in pixels */
+#define QOI_MAX_PIXELS 400000000u
+
+/* Big endian 32-bit value */
+static uint32_t read_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/* Slot of a pixel in the index */
+static inline uint32_t color_hash(uint32_t px) {
+    return (((px >> 16) & 0xFF) * 3 + ((px >> 8) & 0xFF) * 5 + (px & 0xFF) * 7 + (px >> 24) * 11) & 63;
+}
+
+/* Pack channels, each taken modulo 256 as the format wraps them */
+static inline uint32_t pack(uint32_t a, uint32_t r, uint32_t g, uint32_t b) {
+    return (a << 24) | ((r & 0xFF) << 16) | ((g & 0xFF) << 8) | (b & 0xFF);
+}
+
+/* Read the header of an encoded picture */
+int qoi_decoder_init(QoiDecoder *dec, const uint8_t *data, size_t size) {
+    if (size < QOI_HEADER_SIZE + QOI_PADDING || memcmp(data, "qoif", 4) != 0) {
+        return -1;
+    }
+
+    memset(dec, 0, sizeof(*dec));
+    dec->data = data;
+    dec->size = size;
+    dec->pos = QOI_HEADER_SIZE;
+    dec->width = read_be32(data + 4);
+    dec->height = read_be32(data + 8);
+    dec->channels = data[12];
+    dec->colorspace = data[13];
+    dec->px = 0xFF000000;
+
+    if (dec->width == 0 || dec->height == 0 || dec->height > QOI_MAX_PIXELS / dec->width ||
+        dec->channels < 3 || dec->channels > 4 || dec->colorspace > 1) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Decode the next row */
+int qoi_decode_row(QoiDecoder *dec, uint32_t *colors, uint8_t *alpha) {
+    const uint8_t *data = dec->data;
+    size_t pos = dec->pos;
+    size_t end = dec->size - QOI_PADDING;
+    uint32_t px = dec->px;
+    uint32_t run = dec->run;
+    bool opaque = dec->channels == 3;
+
+    for (uint32_t x = 0; x < dec->width; x++) {
+        if (run > 0) {
+            run--;
+        } else {
+            if (pos >= end) {
+                return -1;
+            }
+
+            uint32_t b1 = data[pos++];
+            uint32_t a = px >> 24, r = (px >> 16) & 0xFF, g = (px >> 8) & 0xFF, b = px & 0xFF;
+            if (b1 == QOI_OP_RGB) {
+                if (end - pos < 3) return -1;
+                px = pack(a, data[pos], data[pos + 1], data[pos + 2]);
+                pos += 3;
+            } else if (b1 == QOI_OP_RGBA) {
+                if (end - pos < 4) return -1;
+                px = pack(data[pos + 3], data[pos], data[pos + 1], data[pos + 2]);
+                pos += 4;
+            } else {
+                switch (b1 & QOI_MASK) {
+                    case QOI_OP_INDEX:
+                        px = dec->index[b1];
+                        break;
+                    case QOI_OP_DIFF:
+                        px = pack(a, r + ((b1 >> 4) & 3) - 2, g + ((b1 >> 2) & 3) - 2, b + (b1 & 3) - 2);
+                        break;
+                    case QOI_OP_LUMA: {
+                        if (pos >= end) return -1;
+                        uint32_t b2 = data[pos++];
+                        uint32_t vg = (b1 & 0x3F) - 32;
+                        px = pack(a, r + vg - 8 + (b2 >> 4), g + vg, b + vg - 8 + (b2 & 0x0F));
+                        break;
+                    }
+                    default:
+                        run = b1 & 0x3F;
+                        break;
+                }
+            }
+            dec->index[color_hash(px)] = px;
+        }
+
+        // Premultiply, which most pixels of a photograph skip as opaque
+        uint32_t a = opaque ? 255 : px >> 24;
+        colors[x] = (a == 255) ? px & 0xFFFFFF : composite_scale(px & 0xFFFFFF, a);
+        alpha[x] = (uint8_t)a;
+    }
+
+    dec->pos = pos;
+    dec->px = px;
+    dec->run = run;
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef QOI_H
+#define QOI_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Streaming decoder for the Quite OK Image format
+ * The stream is decoded one row at a time in file order, so a picture of
+ * any size needs no more memory than a row. Pixels come out as they are
+ * composited elsewhere: premultiplied 0xRRGGBB colors with 8-bit alpha,
+ * see composite.h. Pictures with three channels are opaque.
+ */
+
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING 8            // End marker after the last chunk
+
+typedef struct {
+    const uint8_t *data;     // Whole encoded file
+    size_t size;
+    size_t pos;              // Next chunk
+    uint32_t width;
+    uint32_t height;
+    uint8_t channels;        // 3 for RGB, 4 for RGBA
+    uint8_t colorspace;      // 0 for sRGB with linear alpha, 1 for all linear
+    uint32_t px;             // Previous pixel, 0xAARRGGBB
+    uint32_t run;            // Repeats of the previous pixel still to come
+    uint32_t index[64];      // Pixels seen before, by hash
+} QoiDecoder;
+
+/* Read the header of an encoded picture
+ * Returns: 0 on success, -1 if the data is no QOI picture
+ */
+int qoi_decoder_init(QoiDecoder *dec, const uint8_t *data, size_t size);
+
+/* Decode the next row
+ * colors: Receives width premultiplied 0xRRGGBB colors
+ * alpha: Receives width alpha values
+ * Returns: 0 on success, -1 if the data ends early
+ */
+int qoi_decode_row(QoiDecoder *dec, uint32_t *colors, uint8_t *alpha);
+
+#endif
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "raster_cache.h"
+#include "hash.h"
+
+#define RASTER_CACHE_MAGIC 0x43505355   // "USPC"
+#define RASTER_CACHE_VERSION 1
+
+/* On-disk layout: header followed by height rows of row_bytes each
+ * Rows hold native pixels, so a hit is a plain copy per row.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    RasterCacheKey key;
+    uint32_t x, y;           // Screen position of the stored rectangle
+    uint32_t width, height;  // Size of the stored rectangle in pixels
+    uint32_t row_bytes;      // Bytes per stored row
+} RasterCacheHeader;
+
+/* Fill in the cache key for a framebuffer, scene and render options */
+void raster_cache_key(RasterCacheKey *key, const Framebuffer *fb, const SVGScene *scene,
+                      const RenderOptions *options) {
+    memset(key, 0, sizeof(*key));
+    key->xres = fb->vinfo.xres;
+    key->yres = fb->vinfo.yres;
+    key->bits_per_pixel = fb->vinfo.bits_per_pixel;
+    key->line_length = fb->finfo.line_length;
+    key->rotation = options->rotation;
+
+    const PixelFormat *fmt = &fb->format;
+    key->pixel_layout = (fmt->red.shift << 24) | (fmt->green.shift << 16) | (fmt->blue.shift << 8) |
+                        (fmt->red.bits << 6) | (fmt->green.bits << 3) | fmt->blue.bits;
+
+    // Geometry, its view box, colors, the AA engine, how rotation is applied, the
+    // background under the logo and how edges blend with it decide what the pixels look like
+    uint32_t hash = HASH_SEED;
+    hash = hash_bytes(hash, &options->aa, sizeof(options->aa));
+    hash = hash_bytes(hash, &options->linear_blend, sizeof(options->linear_blend));
+    hash = hash_bytes(hash, &options->rotate_geometry, sizeof(options->rotate_geometry));
+    const Background *bg = options->background ? options->background : &background_black;
+    hash = hash_bytes(hash, &bg->kind, sizeof(bg->kind));
+    hash = hash_bytes(hash, &bg->color, sizeof(bg->color));
+    hash = hash_bytes(hash, &bg->bottom, sizeof(bg->bottom));
+    if (bg->tile) {
+        hash = hash_bytes(hash, &bg->tile_width, sizeof(bg->tile_width));
+        hash = hash_bytes(hash, bg->tile, (size_t)bg->tile_width * bg->tile_height * sizeof(uint32_t));
+    }
+    hash = hash_bytes(hash, &scene->view_box, sizeof(scene->view_box));
+    for (uint32_t i = 0; i < scene->num_paths; i++) {
+        const SVGPath *svg = &scene->paths[i];
+        hash = hash_bytes(hash, &svg->fill_color, sizeof(svg->fill_color));
+        hash = hash_bytes(hash, &svg->fill_rule, sizeof(svg->fill_rule));
+        for (uint32_t j = 0; j < svg->num_paths; j++) {
+            const Path *path = &svg->paths[j];
+            hash = hash_bytes(hash, &path->num_points, sizeof(path->num_points));
+            hash = hash_bytes(hash, path->points, path->num_points * sizeof(Point));
+        }
+    }
+    key->content = hash;
+}
+
+/* Blit a cached raster into the framebuffer if its key matches */
+int raster_cache_load(const char *path, Framebuffer *fb, const RasterCacheKey *key) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(RasterCacheHeader)) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    int ret = -1;
+    const RasterCacheHeader *hdr = map;
+    uint32_t bpp = fb->format.bytes_per_pixel;
+
+    // Validate the header before trusting any of its sizes, without sums that can wrap
+    if (hdr->magic != RASTER_CACHE_MAGIC || hdr->version != RASTER_CACHE_VERSION ||
+        memcmp(&hdr->key, key, sizeof(*key)) != 0 ||
+        hdr->x > fb->vinfo.xres || hdr->width > fb->vinfo.xres - hdr->x ||
+        hdr->y > fb->vinfo.yres || hdr->height > fb->vinfo.yres - hdr->y ||
+        hdr->row_bytes != hdr->width * bpp ||
+        (size_t)st.st_size != sizeof(*hdr) + (size_t)hdr->row_bytes * hdr->height) {
+        goto out;
+    }
+
+    const uint8_t *src = (const uint8_t *)(hdr + 1);
+    for (uint32_t row = 0; row < hdr->height; row++) {
+        uint8_t *dst = fb->pixels + (hdr->y + row) * fb->finfo.line_length + hdr->x * bpp;
+        memcpy(dst, src, hdr->row_bytes);
+        src += hdr->row_bytes;
+    }
+    fb_add_damage(fb, hdr->x, hdr->y, hdr->width, hdr->height);
+    ret = 0;
+
+out:
+    munmap(map, st.st_size);
+    return ret;
+}
+
+/* Store the pixels inside rect so later boots can skip rendering */
+int raster_cache_store(const char *path, const Framebuffer *fb, const RasterCacheKey *key,
+                       const FbRect *rect) {
+    RasterCacheHeader hdr = {0};
+    hdr.magic = RASTER_CACHE_MAGIC;
+    hdr.version = RASTER_CACHE_VERSION;
+    hdr.key = *key;
+    hdr.x = rect->x0;
+    hdr.y = rect->y0;
+    hdr.width = rect->x1 - rect->x0;
+    hdr.height = rect->y1 - rect->y0;
+    hdr.row_bytes = hdr.width * fb->format.bytes_per_pixel;
+
+    // Write next to the target and rename, readers never see a partial file
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Failed to create raster cache %s: %m\n", tmp_path);
+        return -1;
+    }
+
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    for (uint32_t row = 0; ok && row < hdr.height; row++) {
+        const uint8_t *src = fb->pixels + (hdr.y + row) * fb->finfo.line_length +
+                             hdr.x * fb->format.bytes_per_pixel;
+        ok = fwrite(src, 1, hdr.row_bytes, fp) == hdr.row_bytes;
+    }
+
+    if (fclose(fp) != 0 || !ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Failed to write raster cache %s: %m\n", path);
+        unlink(tmp_path);
+        return -1;
+    }
+
+    return 0;
+}
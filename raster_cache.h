@@ -0,0 +1,37 @@
+#ifndef RASTER_CACHE_H
+#define RASTER_CACHE_H
+
+#include <stdint.h>
+#include "fbsplash.h"
+#include "svg_renderer.h"
+
+/* Everything the rendered splash depends on
+ * A cached raster is only used when all fields match.
+ */
+typedef struct {
+    uint32_t xres;           // Visible resolution
+    uint32_t yres;
+    uint32_t bits_per_pixel; // Pixel depth
+    uint32_t line_length;    // Line stride in bytes
+    uint32_t pixel_layout;   // Channel shifts and widths of the pixel format
+    uint32_t rotation;       // Display rotation in degrees
+    uint32_t content;        // Hash of the geometry and render options
+} RasterCacheKey;
+
+/* Fill in the cache key for a framebuffer, scene and render options */
+void raster_cache_key(RasterCacheKey *key, const Framebuffer *fb, const SVGScene *scene,
+                      const RenderOptions *options);
+
+/* Blit a cached raster into the framebuffer if its key matches
+ * Returns: 0 if the cached pixels were drawn, -1 on a missing or stale cache
+ */
+int raster_cache_load(const char *path, Framebuffer *fb, const RasterCacheKey *key);
+
+/* Store the pixels inside rect so later boots can skip rendering
+ * The file is replaced atomically.
+ * Returns: 0 on success, -1 on failure
+ */
+int raster_cache_store(const char *path, const Framebuffer *fb, const RasterCacheKey *key,
+                       const FbRect *rect);
+
+#endif
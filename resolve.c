@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <string.h>
+#include "resolve.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define RESOLVE_HAVE_AVX2 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define SCALE 255.0f          // Quantized coverage of a fully covered pixel
+
+/* Quantize one coverage value, shared by the scalar kernel and the vector tails */
+static inline uint8_t quantize_one(float *coverage) {
+    float c = *coverage;
+    *coverage = 0.0f;
+    if (c <= 0.0f) {
+        return 0;
+    }
+    if (c >= 1.0f) {
+        return 255;
+    }
+    return (uint8_t)(c * SCALE + 0.5f);
+}
+
+/* Pack one color into RGB565 */
+static inline uint16_t pack_one_rgb565(uint32_t c) {
+    return ((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F);
+}
+
+/* Quantize integer coverage, RESOLVE_FIXED_ONE is a fully covered pixel */
+void resolve_fixed(int32_t *coverage, uint8_t *quantized, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t c = coverage[i];
+        coverage[i] = 0;
+        if (c <= 0) {
+            quantized[i] = 0;
+        } else if (c >= RESOLVE_FIXED_ONE) {
+            quantized[i] = 255;
+        } else {
+            quantized[i] = (uint8_t)((c * 255 + RESOLVE_FIXED_ONE / 2) / RESOLVE_FIXED_ONE);
+        }
+    }
+}
+
+static void resolve_scalar(float *coverage, uint8_t *quantized, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        quantized[i] = quantize_one(&coverage[i]);
+    }
+}
+
+static void pack_rgb565_scalar(uint16_t *dst, const uint32_t *colors, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        dst[i] = pack_one_rgb565(colors[i]);
+    }
+}
+
+#if defined(__SSE2__)
+/* Quantize four coverage values into 32-bit lanes and clear them */
+static inline __m128i quantize4_sse2(float *coverage) {
+    __m128 c = _mm_loadu_ps(coverage);
+    _mm_storeu_ps(coverage, _mm_setzero_ps());
+    c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(SCALE)), _mm_set1_ps(0.5f)));
+}
+
+static void resolve_sse2(float *coverage, uint8_t *quantized, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i lo = _mm_packs_epi32(quantize4_sse2(&coverage[i]), quantize4_sse2(&coverage[i + 4]));
+        __m128i hi = _mm_packs_epi32(quantize4_sse2(&coverage[i + 8]), quantize4_sse2(&coverage[i + 12]));
+        _mm_storeu_si128((__m128i *)&quantized[i], _mm_packus_epi16(lo, hi));
+    }
+
+    for (; i < count; i++) {
+        quantized[i] = quantize_one(&coverage[i]);
+    }
+}
+
+/* Pack four colors into RGB565 in the low halves of 32-bit lanes */
+static inline __m128i pack4_rgb565_sse2(__m128i c) {
+    __m128i r = _mm_and_si128(_mm_srli_epi32(c, 8), _mm_set1_epi32(0xF800));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(c, 5), _mm_set1_epi32(0x07E0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(c, 3), _mm_set1_epi32(0x001F));
+    __m128i p = _mm_or_si128(_mm_or_si128(r, g), b);
+
+    // Sign extend so the saturating pack keeps the bit pattern
+    return _mm_srai_epi32(_mm_slli_epi32(p, 16), 16);
+}
+
+static void pack_rgb565_sse2(uint16_t *dst, const uint32_t *colors, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = pack4_rgb565_sse2(_mm_loadu_si128((const __m128i *)&colors[i]));
+        __m128i hi = pack4_rgb565_sse2(_mm_loadu_si128((const __m128i *)&colors[i + 4]));
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packs_epi32(lo, hi));
+    }
+
+    for (; i < count; i++) {
+        dst[i] = pack_one_rgb565(colors[i]);
+    }
+}
+#endif
+
+#if defined(RESOLVE_HAVE_AVX2)
+/* Quantize eight coverage values into 32-bit lanes and clear them */
+__attribute__((target("avx2")))
+static inline __m256i quantize8_avx2(float *coverage) {
+    __m256 c = _mm256_loadu_ps(coverage);
+    _mm256_storeu_ps(coverage, _mm256_setzero_ps());
+    c = _mm256_min_ps(_mm256_max_ps(c, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(SCALE)),
+                                             _mm256_set1_ps(0.5f)));
+}
+
+__attribute__((target("avx2")))
+static void resolve_avx2(float *coverage, uint8_t *quantized, uint32_t count) {
+    // The packs work within 128-bit lanes, the permute puts the groups of four back in order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    uint32_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i ab = _mm256_packs_epi32(quantize8_avx2(&coverage[i]), quantize8_avx2(&coverage[i + 8]));
+        __m256i cd = _mm256_packs_epi32(quantize8_avx2(&coverage[i + 16]), quantize8_avx2(&coverage[i + 24]));
+        __m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(ab, cd), order);
+        _mm256_storeu_si256((__m256i *)&quantized[i], packed);
+    }
+
+    for (; i < count; i++) {
+        quantized[i] = quantize_one(&coverage[i]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void pack_rgb565_avx2(uint16_t *dst, const uint32_t *colors, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)&colors[i]);
+        __m256i r = _mm256_and_si256(_mm256_srli_epi32(c, 8), _mm256_set1_epi32(0xF800));
+        __m256i g = _mm256_and_si256(_mm256_srli_epi32(c, 5), _mm256_set1_epi32(0x07E0));
+        __m256i b = _mm256_and_si256(_mm256_srli_epi32(c, 3), _mm256_set1_epi32(0x001F));
+        __m256i p = _mm256_or_si256(_mm256_or_si256(r, g), b);
+
+        // Values fit in 16 bits, so the unsigned pack never saturates
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1));
+        _mm_storeu_si128((__m128i *)&dst[i], packed);
+    }
+
+    for (; i < count; i++) {
+        dst[i] = pack_one_rgb565(colors[i]);
+    }
+}
+#endif
+
+#if defined(__ARM_NEON)
+/* Quantize four coverage values to 16 bits and clear them */
+static inline uint16x4_t quantize4_neon(float *coverage) {
+    float32x4_t c = vld1q_f32(coverage);
+    vst1q_f32(coverage, vdupq_n_f32(0.0f));
+    c = vminq_f32(vmaxq_f32(c, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    return vmovn_u32(vcvtq_u32_f32(vaddq_f32(vmulq_n_f32(c, SCALE), vdupq_n_f32(0.5f))));
+}
+
+static void resolve_neon(float *coverage, uint8_t *quantized, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t q = vcombine_u16(quantize4_neon(&coverage[i]), quantize4_neon(&coverage[i + 4]));
+        vst1_u8(&quantized[i], vmovn_u16(q));
+    }
+
+    for (; i < count; i++) {
+        quantized[i] = quantize_one(&coverage[i]);
+    }
+}
+
+static void pack_rgb565_neon(uint16_t *dst, const uint32_t *colors, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t c = vld1q_u32(&colors[i]);
+        uint32x4_t r = vandq_u32(vshrq_n_u32(c, 8), vdupq_n_u32(0xF800));
+        uint32x4_t g = vandq_u32(vshrq_n_u32(c, 5), vdupq_n_u32(0x07E0));
+        uint32x4_t b = vandq_u32(vshrq_n_u32(c, 3), vdupq_n_u32(0x001F));
+        vst1_u16(&dst[i], vmovn_u32(vorrq_u32(vorrq_u32(r, g), b)));
+    }
+
+    for (; i < count; i++) {
+        dst[i] = pack_one_rgb565(colors[i]);
+    }
+}
+#endif
+static const ResolveKernel kernel_scalar = { "scalar", resolve_scalar, pack_rgb565_scalar };
+#if defined(__SSE2__)
+static const ResolveKernel kernel_sse2 = { "sse2", resolve_sse2, pack_rgb565_sse2 };
+#endif
+#if defined(RESOLVE_HAVE_AVX2)
+static const ResolveKernel kernel_avx2 = { "avx2", resolve_avx2, pack_rgb565_avx2 };
+#endif
+#if defined(__ARM_NEON)
+static const ResolveKernel kernel_neon = { "neon", resolve_neon, pack_rgb565_neon };
+#endif
+
+/* Kernels the CPU supports, from index 0 (scalar) upwards */
+const ResolveKernel* resolve_kernel_get(unsigned int index) {
+    const ResolveKernel *kernels[4];
+    unsigned int count = 0;
+
+    kernels[count++] = &kernel_scalar;
+#if defined(__SSE2__)
+    kernels[count++] = &kernel_sse2;
+#endif
+#if defined(RESOLVE_HAVE_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        kernels[count++] = &kernel_avx2;
+    }
+#endif
+#if defined(__ARM_NEON)
+    kernels[count++] = &kernel_neon;
+#endif
+
+    return (index < count) ? kernels[index] : NULL;
+}
+
+/* Fastest kernel the CPU supports, the last one in the list
+ * SPLASH_RESOLVE can name another supported kernel, e.g. for comparisons
+ */
+const ResolveKernel* resolve_kernel(void) {
+    static const ResolveKernel *best;
+
+    if (!best) {
+        const char *name = getenv("SPLASH_RESOLVE");
+        const ResolveKernel *k;
+        for (unsigned int i = 0; (k = resolve_kernel_get(i)) != NULL; i++) {
+            if (name && strcmp(k->name, name) == 0) {
+                best = k;
+                break;
+            }
+            best = k;
+        }
+    }
+    return best;
+}
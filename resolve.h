@@ -0,0 +1,40 @@
+#ifndef RESOLVE_H
+#define RESOLVE_H
+
+#include <stdint.h>
+
+/* Coverage resolve kernels
+ * A resolve kernel turns a row of path coverage into 8-bit coverage for
+ * composite_span(), coverage * 255 rounded and clamped, 0 where the path
+ * does not reach. The vibrancy curve and the blend are table lookups from
+ * there on, see composite.h.
+ */
+typedef struct {
+    const char *name;
+
+    // Quantize count coverage values to 8 bits and clear the coverage
+    void (*resolve)(float *coverage, uint8_t *quantized, uint32_t count);
+
+    // Pack count 0xRRGGBB colors into RGB565
+    void (*pack_rgb565)(uint16_t *dst, const uint32_t *colors, uint32_t count);
+} ResolveKernel;
+
+/* Coverage of a fully covered pixel for resolve_fixed() */
+#define RESOLVE_FIXED_ONE 32768
+
+/* Quantize integer coverage like the kernels do, then clear it
+ * For the fixed point rasterizer, there is no floating point involved.
+ */
+void resolve_fixed(int32_t *coverage, uint8_t *quantized, uint32_t count);
+
+/* Fastest kernel the CPU supports, chosen on the first call
+ * The SPLASH_RESOLVE environment variable can select another by name.
+ */
+const ResolveKernel* resolve_kernel(void);
+
+/* Kernels the CPU supports, from index 0 (scalar) upwards
+ * Returns: Kernel or NULL past the last one
+ */
+const ResolveKernel* resolve_kernel_get(unsigned int index);
+
+#endif
@@ -0,0 +1,269 @@
+#include <string.h>
+#include "rotate.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define ROTATE_TILE 32   // Tile edge in pixels, 4 KiB of 32-bit pixels per tile
+
+/* One rotated copy in progress */
+typedef struct {
+    uint8_t *dst;
+    size_t dst_stride;
+    const uint8_t *src;
+    size_t src_stride;
+    uint32_t width, height;  // Source size in pixels
+    uint32_t bpp;            // Bytes per pixel
+    int turns;
+} RotateBlit;
+
+/* Transpose a square block at source column sx and row sy */
+typedef void (*RotateBlock)(const RotateBlit *b, uint32_t sx, uint32_t sy);
+
+/* Copy one pixel, the constant sizes become single moves */
+static inline void copy_pixel(uint8_t *dst, const uint8_t *src, uint32_t bpp) {
+    switch (bpp) {
+        case 4: memcpy(dst, src, 4); break;
+        case 3: memcpy(dst, src, 3); break;
+        case 2: memcpy(dst, src, 2); break;
+        default: *dst = *src; break;
+    }
+}
+
+/* Destination address of source pixel (sx, sy) */
+static inline uint8_t *dst_pixel(const RotateBlit *b, uint32_t sx, uint32_t sy) {
+    uint32_t x, y;
+    switch (b->turns) {
+        case 1: x = b->height - 1 - sy; y = sx; break;
+        case 2: x = b->width - 1 - sx; y = b->height - 1 - sy; break;
+        case 3: x = sy; y = b->width - 1 - sx; break;
+        default: x = sx; y = sy; break;
+    }
+    return b->dst + y * b->dst_stride + x * b->bpp;
+}
+
+/* Rotate source columns sx0..sx1 of rows sy0..sy1 pixel by pixel */
+static void rotate_region(const RotateBlit *b, uint32_t sx0, uint32_t sy0, uint32_t sx1, uint32_t sy1) {
+    for (uint32_t sy = sy0; sy < sy1; sy++) {
+        const uint8_t *src = b->src + sy * b->src_stride + sx0 * b->bpp;
+        for (uint32_t sx = sx0; sx < sx1; sx++, src += b->bpp) {
+            copy_pixel(dst_pixel(b, sx, sy), src, b->bpp);
+        }
+    }
+}
+
+#if defined(__SSE2__)
+/* Transpose 4x4 32-bit pixels
+ * Rows are loaded bottom up for 90 degrees, so every transposed column
+ * lands right to left as one store.
+ */
+static void rotate_block4_sse2(const RotateBlit *b, uint32_t sx, uint32_t sy) {
+    const uint8_t *src = b->src + sy * b->src_stride + sx * 4;
+    ptrdiff_t step = (ptrdiff_t)b->src_stride;
+    if (b->turns == 1) {
+        src += 3 * step;
+        step = -step;
+    }
+
+    __m128i r0 = _mm_loadu_si128((const __m128i *)src);
+    __m128i r1 = _mm_loadu_si128((const __m128i *)(src + step));
+    __m128i r2 = _mm_loadu_si128((const __m128i *)(src + 2 * step));
+    __m128i r3 = _mm_loadu_si128((const __m128i *)(src + 3 * step));
+
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+    __m128i col[4] = {
+        _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+        _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3),
+    };
+
+    for (int c = 0; c < 4; c++) {
+        uint8_t *dst = (b->turns == 1) ? dst_pixel(b, sx + c, sy + 3) : dst_pixel(b, sx + c, sy);
+        _mm_storeu_si128((__m128i *)dst, col[c]);
+    }
+}
+
+/* Transpose 8x8 16-bit pixels, rows ordered as in the 32-bit version */
+static void rotate_block2_sse2(const RotateBlit *b, uint32_t sx, uint32_t sy) {
+    const uint8_t *src = b->src + sy * b->src_stride + sx * 2;
+    ptrdiff_t step = (ptrdiff_t)b->src_stride;
+    if (b->turns == 1) {
+        src += 7 * step;
+        step = -step;
+    }
+
+    __m128i r[8];
+    for (int i = 0; i < 8; i++) {
+        r[i] = _mm_loadu_si128((const __m128i *)(src + i * step));
+    }
+
+    __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]), a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]), a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]), a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]), a7 = _mm_unpackhi_epi16(r[6], r[7]);
+
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2), b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3), b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6), b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7), b7 = _mm_unpackhi_epi32(a5, a7);
+
+    __m128i col[8] = {
+        _mm_unpacklo_epi64(b0, b4), _mm_unpackhi_epi64(b0, b4),
+        _mm_unpacklo_epi64(b1, b5), _mm_unpackhi_epi64(b1, b5),
+        _mm_unpacklo_epi64(b2, b6), _mm_unpackhi_epi64(b2, b6),
+        _mm_unpacklo_epi64(b3, b7), _mm_unpackhi_epi64(b3, b7),
+    };
+
+    for (int c = 0; c < 8; c++) {
+        uint8_t *dst = (b->turns == 1) ? dst_pixel(b, sx + c, sy + 7) : dst_pixel(b, sx + c, sy);
+        _mm_storeu_si128((__m128i *)dst, col[c]);
+    }
+}
+
+/* Reverse a row of 32-bit pixels four at a time, returns pixels done */
+static uint32_t reverse_row4_sse2(uint8_t *dst, const uint8_t *src, uint32_t width) {
+    uint32_t x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + x * 4));
+        _mm_storeu_si128((__m128i *)(dst + (width - 4 - x) * 4), _mm_shuffle_epi32(v, 0x1B));
+    }
+    return x;
+}
+
+/* Reverse a row of 16-bit pixels eight at a time, returns pixels done */
+static uint32_t reverse_row2_sse2(uint8_t *dst, const uint8_t *src, uint32_t width) {
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + x * 2));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B);
+        _mm_storeu_si128((__m128i *)(dst + (width - 8 - x) * 2), _mm_shuffle_epi32(v, 0x4E));
+    }
+    return x;
+}
+#endif
+
+#if defined(__ARM_NEON)
+/* Transpose 4x4 32-bit pixels, rows ordered as in the SSE2 version */
+static void rotate_block4_neon(const RotateBlit *b, uint32_t sx, uint32_t sy) {
+    const uint8_t *src = b->src + sy * b->src_stride + sx * 4;
+    ptrdiff_t step = (ptrdiff_t)b->src_stride;
+    if (b->turns == 1) {
+        src += 3 * step;
+        step = -step;
+    }
+
+    uint32x4_t r0 = vld1q_u32((const uint32_t *)src);
+    uint32x4_t r1 = vld1q_u32((const uint32_t *)(src + step));
+    uint32x4_t r2 = vld1q_u32((const uint32_t *)(src + 2 * step));
+    uint32x4_t r3 = vld1q_u32((const uint32_t *)(src + 3 * step));
+
+    uint32x4x2_t t01 = vtrnq_u32(r0, r1);
+    uint32x4x2_t t23 = vtrnq_u32(r2, r3);
+    uint32x4_t col[4] = {
+        vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])),
+        vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])),
+        vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])),
+        vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])),
+    };
+
+    for (int c = 0; c < 4; c++) {
+        uint8_t *dst = (b->turns == 1) ? dst_pixel(b, sx + c, sy + 3) : dst_pixel(b, sx + c, sy);
+        vst1q_u32((uint32_t *)dst, col[c]);
+    }
+}
+#endif
+
+/* Block transpose for a pixel size, sets the block edge in pixels */
+static RotateBlock block_kernel(uint32_t bpp, uint32_t *block) {
+#if defined(__SSE2__)
+    if (bpp == 4) {
+        *block = 4;
+        return rotate_block4_sse2;
+    }
+    if (bpp == 2) {
+        *block = 8;
+        return rotate_block2_sse2;
+    }
+#elif defined(__ARM_NEON)
+    if (bpp == 4) {
+        *block = 4;
+        return rotate_block4_neon;
+    }
+#endif
+    (void)bpp;
+    *block = 1;
+    return NULL;
+}
+
+/* Rotate by 90 or 270 degrees tile by tile
+ * Both the source rows and the destination rows of a tile stay in cache
+ * while it is transposed, instead of striding over the whole screen per pixel.
+ */
+static void rotate_tiled(const RotateBlit *b) {
+    uint32_t block;
+    RotateBlock kernel = block_kernel(b->bpp, &block);
+
+    for (uint32_t ty = 0; ty < b->height; ty += ROTATE_TILE) {
+        uint32_t th = (b->height - ty < ROTATE_TILE) ? b->height - ty : ROTATE_TILE;
+        for (uint32_t tx = 0; tx < b->width; tx += ROTATE_TILE) {
+            uint32_t tw = (b->width - tx < ROTATE_TILE) ? b->width - tx : ROTATE_TILE;
+
+            // Whole blocks through the kernel, the ragged right and bottom strips per pixel
+            uint32_t bw = kernel ? tw / block * block : 0;
+            uint32_t bh = kernel ? th / block * block : 0;
+            for (uint32_t y = ty; y < ty + bh; y += block) {
+                for (uint32_t x = tx; x < tx + bw; x += block) {
+                    kernel(b, x, y);
+                }
+            }
+            rotate_region(b, tx + bw, ty, tx + tw, ty + th);
+            rotate_region(b, tx, ty + bh, tx + bw, ty + th);
+        }
+    }
+}
+
+/* Rotate by 180 degrees, every row is copied reversed */
+static void rotate_half(const RotateBlit *b) {
+    for (uint32_t sy = 0; sy < b->height; sy++) {
+        const uint8_t *src = b->src + sy * b->src_stride;
+        uint8_t *dst = b->dst + (b->height - 1 - sy) * b->dst_stride;
+        uint32_t done = 0;
+
+#if defined(__SSE2__)
+        if (b->bpp == 4) {
+            done = reverse_row4_sse2(dst, src, b->width);
+        } else if (b->bpp == 2) {
+            done = reverse_row2_sse2(dst, src, b->width);
+        }
+#endif
+        for (uint32_t sx = done; sx < b->width; sx++) {
+            copy_pixel(dst + (b->width - 1 - sx) * b->bpp, src + sx * b->bpp, b->bpp);
+        }
+    }
+}
+
+/* Copy a block of pixels rotated clockwise by quarter turns */
+void rotate_blit(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                 uint32_t width, uint32_t height, uint32_t bytes_per_pixel, int turns) {
+    RotateBlit b = { dst, dst_stride, src, src_stride, width, height, bytes_per_pixel, turns & 3 };
+
+    switch (b.turns) {
+        case 0:
+            for (uint32_t y = 0; y < height; y++) {
+                memcpy(dst + y * dst_stride, src + y * src_stride, (size_t)width * bytes_per_pixel);
+            }
+            break;
+        case 2:
+            rotate_half(&b);
+            break;
+        default:
+            rotate_tiled(&b);
+            break;
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef ROTATE_H
+#define ROTATE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Copy a block of pixels rotated clockwise by quarter turns
+ * dst: Top-left pixel of the destination, height x width pixels for odd
+ *      turns and width x height for even ones
+ * src: Top-left pixel of the width x height source
+ * bytes_per_pixel: 1 to 4
+ * turns: Quarter turns clockwise, 0 to 3
+ * 90 and 270 degrees walk the block in cache-sized tiles, with SSE2
+ * transposes for 16 and 32-bit pixels and NEON ones for 32-bit pixels.
+ */
+void rotate_blit(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                 uint32_t width, uint32_t height, uint32_t bytes_per_pixel, int turns);
+
+#endif
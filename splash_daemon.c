@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "splash_daemon.h"
+#include "progress.h"
+#include "text.h"
+
+#define REPLY_TIMEOUT_MS 2000   // How long a client waits for the daemon
+
+/* Logos the daemon can show */
+typedef enum {
+    LOGO_BOOT,
+    LOGO_SHUTDOWN,
+    NUM_LOGOS
+} LogoKind;
+
+/* Logo scene and its raster, captured from the screen the first time it is drawn */
+typedef struct {
+    const SVGScene *scene;
+    FbRect rect;             // Screen rectangle of the raster
+    Framebuffer *raster;     // NULL until drawn once
+} DaemonLogo;
+
+struct SplashDaemon {
+    int fd;
+    char *path;
+    Framebuffer *fb;
+    const DisplayInfo *display_info;
+    RenderOptions options;
+    DaemonLogo logos[NUM_LOGOS];
+    LogoKind current;
+    SVGPath *shutdown_paths;
+    SVGScene shutdown_scene;
+    ProgressBar bar;
+    bool bar_shown;
+    TextLine status;
+    bool status_shown;
+};
+
+/* Set by SIGTERM and SIGINT, the daemon finishes the current command and stops */
+static volatile sig_atomic_t stop_requested;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+/* Build the shutdown logo, the boot geometry in grey */
+static int make_shutdown_scene(SplashDaemon *d, const SVGScene *boot) {
+    d->shutdown_paths = malloc(boot->num_paths * sizeof(SVGPath));
+    if (!d->shutdown_paths) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < boot->num_paths; i++) {
+        SVGPath *path = &d->shutdown_paths[i];
+        *path = boot->paths[i];
+
+        // Same brightness, no color
+        Color c = path->fill_color;
+        uint8_t grey = (uint8_t)((c.r * 77 + c.g * 150 + c.b * 29) >> 8);
+        path->fill_color.r = path->fill_color.g = path->fill_color.b = grey;
+    }
+
+    d->shutdown_scene = *boot;
+    d->shutdown_scene.paths = d->shutdown_paths;
+    return 0;
+}
+
+/* Copy a logo from the screen into its resident raster */
+static void capture_logo(SplashDaemon *d, DaemonLogo *logo) {
+    uint32_t width = logo->rect.x1 - logo->rect.x0;
+    uint32_t height = logo->rect.y1 - logo->rect.y0;
+    if (width == 0 || height == 0) {
+        return;
+    }
+
+    logo->raster = fb_create_offscreen(d->fb, width, height);
+    if (!logo->raster) {
+        return;
+    }
+
+    size_t row_bytes = (size_t)width * d->fb->format.bytes_per_pixel;
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(fb_pixel_address(logo->raster, 0, y),
+               fb_pixel_address(d->fb, logo->rect.x0, logo->rect.y0 + y), row_bytes);
+    }
+}
+
+/* Replace the logo on screen
+ * A logo drawn before is blitted from its raster, otherwise it is
+ * rendered once and captured.
+ */
+static void show_logo(SplashDaemon *d, LogoKind kind) {
+    if (kind == d->current) {
+        return;
+    }
+
+    // Both logos share one area and either writes all of it, background included
+    DaemonLogo *logo = &d->logos[kind];
+    if (logo->raster) {
+        fb_blit_rotated(d->fb, logo->rect.x0, logo->rect.y0, logo->raster, 0);
+    } else {
+        render_scene(d->fb, logo->scene, d->display_info, &d->options);
+        capture_logo(d, logo);
+    }
+    d->current = kind;
+}
+
+/* Whether a command starts with a word, followed by the end or a space */
+static const char *command_arg(const char *command, const char *word) {
+    size_t len = strlen(word);
+    if (strncmp(command, word, len) != 0) {
+        return NULL;
+    }
+    if (command[len] == '\0') {
+        return command + len;
+    }
+    return (command[len] == ' ') ? command + len + 1 : NULL;
+}
+
+/* Execute one command
+ * Returns: false once the daemon should stop
+ */
+static bool handle_command(SplashDaemon *d, char *command, char *reply, size_t reply_size) {
+    // Tolerate line based senders such as echo
+    size_t len = strlen(command);
+    while (len > 0 && (command[len - 1] == '\n' || command[len - 1] == '\r' || command[len - 1] == ' ')) {
+        command[--len] = '\0';
+    }
+
+    const char *arg;
+    snprintf(reply, reply_size, "ok");
+
+    if ((arg = command_arg(command, "progress")) != NULL) {
+        char *end;
+        long percent = strtol(arg, &end, 10);
+        if (end == arg || *end != '\0') {
+            snprintf(reply, reply_size, "error invalid percentage: %.64s", arg);
+            return true;
+        }
+        if (!d->bar_shown) {
+            progress_bar_init(&d->bar, d->fb, d->display_info, d->options.rotation);
+            d->bar_shown = true;
+        }
+        progress_bar_draw(d->fb, &d->bar, (int)percent);
+    } else if ((arg = command_arg(command, "status")) != NULL) {
+        if (!d->status_shown) {
+            if (text_line_init(&d->status, d->fb, d->display_info, d->options.rotation,
+                               d->options.background) != 0) {
+                snprintf(reply, reply_size, "error failed to set up the status line");
+                return true;
+            }
+            d->status_shown = true;
+        }
+        text_line_draw(d->fb, &d->status, arg);
+    } else if ((arg = command_arg(command, "logo")) != NULL) {
+        if (strcmp(arg, "boot") == 0) {
+            show_logo(d, LOGO_BOOT);
+        } else if (strcmp(arg, "shutdown") == 0) {
+            show_logo(d, LOGO_SHUTDOWN);
+        } else {
+            snprintf(reply, reply_size, "error unknown logo: %.64s", arg);
+            return true;
+        }
+    } else if (command_arg(command, "quit") != NULL) {
+        return false;
+    } else {
+        snprintf(reply, reply_size, "error unknown command: %.64s", command);
+        return true;
+    }
+
+    fb_flush(d->fb);
+    return true;
+}
+
+/* Listen on a control socket for a framebuffer that shows the boot logo */
+SplashDaemon* splash_daemon_create(const char *path, Framebuffer *fb, const DisplayInfo *display_info,
+                                   const SVGScene *scene, const RenderOptions *options,
+                                   const TextLine *status) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return NULL;
+    }
+    strcpy(addr.sun_path, path);
+
+    // Replace a socket left behind, but never anything else
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "%s exists and is not a socket\n", path);
+            return NULL;
+        }
+        unlink(path);
+    }
+
+    SplashDaemon *d = calloc(1, sizeof(SplashDaemon));
+    if (!d) {
+        fprintf(stderr, "Failed to allocate daemon\n");
+        return NULL;
+    }
+    d->fb = fb;
+    d->display_info = display_info;
+    d->options = *options;
+    d->current = LOGO_BOOT;
+    d->path = strdup(path);
+    d->fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+
+    if (!d->path || d->fd == -1 || make_shutdown_scene(d, scene) != 0 ||
+        bind(d->fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        fprintf(stderr, "Failed to listen on %s: %m\n", path);
+        if (d->fd != -1) close(d->fd);
+        free(d->shutdown_paths);
+        free(d->path);
+        free(d);
+        return NULL;
+    }
+
+    d->logos[LOGO_BOOT].scene = scene;
+    d->logos[LOGO_SHUTDOWN].scene = &d->shutdown_scene;
+    for (int i = 0; i < NUM_LOGOS; i++) {
+        render_logo_area(fb, display_info, options, &d->logos[i].rect);
+    }
+
+    // The boot logo is on screen already, and maybe a status line
+    capture_logo(d, &d->logos[LOGO_BOOT]);
+    if (status) {
+        d->status = *status;
+        d->status_shown = true;
+    }
+
+    // Tear-free updates where the driver can pan
+    fb_flip_init(fb);
+    return d;
+}
+
+/* Handle commands until quit or a signal */
+int splash_daemon_run(SplashDaemon *d) {
+    struct sigaction sa = { .sa_handler = handle_stop_signal }, old_term, old_int;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, &old_term);
+    sigaction(SIGINT, &sa, &old_int);
+    stop_requested = 0;
+
+    int status = 0;
+    bool running = true;
+    char command[SPLASH_DAEMON_MAX_MESSAGE + 1];
+    char reply[SPLASH_DAEMON_MAX_MESSAGE];
+
+    while (running && !stop_requested) {
+        struct sockaddr_un from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(d->fd, command, SPLASH_DAEMON_MAX_MESSAGE, 0,
+                               (struct sockaddr *)&from, &from_len);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "Failed to receive command: %m\n");
+            status = -1;
+            break;
+        }
+        command[len] = '\0';
+
+        running = handle_command(d, command, reply, sizeof(reply));
+
+        // Unbound senders have no address to answer to
+        if (from_len > sizeof(sa_family_t)) {
+            sendto(d->fd, reply, strlen(reply), MSG_DONTWAIT, (struct sockaddr *)&from, from_len);
+        }
+    }
+
+    sigaction(SIGTERM, &old_term, NULL);
+    sigaction(SIGINT, &old_int, NULL);
+    return status;
+}
+
+/* Close the socket, remove its path and free the daemon */
+void splash_daemon_destroy(SplashDaemon *d) {
+    if (!d) {
+        return;
+    }
+
+    close(d->fd);
+    unlink(d->path);
+    for (int i = 0; i < NUM_LOGOS; i++) {
+        fb_cleanup(d->logos[i].raster);
+    }
+    if (d->status_shown) text_line_free(&d->status);
+    free(d->shutdown_paths);
+    free(d->path);
+    free(d);
+}
+
+/* Send one command and wait for the reply */
+int splash_daemon_send(const char *path, const char *command, char *reply, size_t reply_size) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(addr.sun_path) || reply_size == 0) {
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    reply[0] = '\0';
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        snprintf(reply, reply_size, "error socket: %m");
+        return -1;
+    }
+
+    // Binding without a path picks an abstract address the daemon can answer
+    struct sockaddr_un self = { .sun_family = AF_UNIX };
+    struct timeval timeout = { REPLY_TIMEOUT_MS / 1000, (REPLY_TIMEOUT_MS % 1000) * 1000 };
+    if (bind(fd, (struct sockaddr *)&self, sizeof(sa_family_t)) == -1 ||
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == -1 ||
+        sendto(fd, command, strlen(command), 0, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        snprintf(reply, reply_size, "error %s: %m", path);
+        close(fd);
+        return -1;
+    }
+
+    ssize_t len = recv(fd, reply, reply_size - 1, 0);
+    close(fd);
+    if (len < 0) {
+        snprintf(reply, reply_size, "error no reply from %s", path);
+        return -1;
+    }
+    reply[len] = '\0';
+    return strcmp(reply, "ok") == 0 ? 0 : -1;
+}
@@ -0,0 +1,55 @@
+#ifndef SPLASH_DAEMON_H
+#define SPLASH_DAEMON_H
+
+#include <stddef.h>
+#include "fbsplash.h"
+#include "svg_renderer.h"
+#include "text.h"
+
+/* Default control socket */
+#define SPLASH_DAEMON_SOCKET "/run/unofficialos-splash.sock"
+
+/* Longest command or reply, one datagram each */
+#define SPLASH_DAEMON_MAX_MESSAGE 256
+
+/* Splash kept running after the first frame
+ * The framebuffer, layout and rasterized logos stay resident and commands
+ * arrive as datagrams on a Unix socket, one per datagram:
+ *   progress N       Show the progress bar at N percent
+ *   status TEXT      Show TEXT on the status line under the logo
+ *   logo boot        Show the boot logo
+ *   logo shutdown    Show the shutdown logo
+ *   quit             Stop the daemon
+ * Senders with an address of their own get "ok" or "error MESSAGE" back
+ * once the change is on screen.
+ */
+typedef struct SplashDaemon SplashDaemon;
+
+/* Listen on a control socket for a framebuffer that shows the boot logo
+ * The logo on screen is captured so switching back to it is a blit.
+ * path: Socket path, an existing socket there is replaced
+ * scene: Boot logo, the shutdown logo is the same geometry in grey. It
+ *        must outlive the daemon, like the background of the options.
+ * status: Status line on screen already or NULL, taken over with its atlas
+ *         by a daemon that starts
+ * Returns: Daemon or NULL on failure
+ */
+SplashDaemon* splash_daemon_create(const char *path, Framebuffer *fb, const DisplayInfo *display_info,
+                                   const SVGScene *scene, const RenderOptions *options,
+                                   const TextLine *status);
+
+/* Handle commands until quit, SIGTERM or SIGINT
+ * Returns: 0 after quit or a signal, -1 if the socket fails
+ */
+int splash_daemon_run(SplashDaemon *daemon);
+
+/* Close the socket, remove its path and free the daemon */
+void splash_daemon_destroy(SplashDaemon *daemon);
+
+/* Send one command and wait for the reply
+ * reply: Receives the NUL terminated reply
+ * Returns: 0 if the daemon answered "ok", -1 otherwise
+ */
+int splash_daemon_send(const char *path, const char *command, char *reply, size_t reply_size);
+
+#endif
@@ -0,0 +1,427 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "svg_loader.h"
+#include "svg_parser.h"
+
+#define MAX_COLOR_LENGTH 63
+
+struct SvgFile {
+    const char *data;        // Mapped file
+    size_t size;
+    const char *body;        // First byte after the root element
+    ViewBox view_box;
+};
+
+/* Start tag of an element, everything points into the mapped file */
+typedef struct {
+    const char *name;
+    size_t name_length;
+    const char *attributes;  // First byte after the name
+    const char *end;         // Closing '>' of the tag
+    bool self_closing;
+} SvgElement;
+
+/* Path element to draw, d points into the mapped file */
+typedef struct {
+    const char *d;
+    size_t d_length;
+    Color fill;
+    FillRule fill_rule;
+} SvgDrawnPath;
+
+/* Attribute of a start tag, the value excludes its quotes */
+typedef struct {
+    const char *name;
+    size_t name_length;
+    const char *value;
+    size_t value_length;
+} SvgAttribute;
+
+/* Elements whose paths are never drawn directly */
+static const char *const hidden_containers[] = {
+    "defs", "clipPath", "mask", "marker", "pattern", "symbol",
+};
+
+/* Whether a name that is not NUL terminated equals a string */
+static bool name_is(const char *name, size_t length, const char *expected) {
+    return strlen(expected) == length && memcmp(name, expected, length) == 0;
+}
+
+/* Find the next start tag, skipping comments, declarations and end tags
+ * Returns: Byte after the tag, or NULL when there is none
+ */
+static const char *next_element(const char *p, const char *end, SvgElement *element) {
+    while ((p = memchr(p, '<', end - p)) != NULL) {
+        const char *close = NULL;
+        if (end - p >= 4 && memcmp(p, "<!--", 4) == 0) {
+            close = memmem(p + 4, end - p - 4, "-->", 3);
+            p = close ? close + 3 : end;
+            continue;
+        }
+        if (end - p >= 9 && memcmp(p, "<![CDATA[", 9) == 0) {
+            close = memmem(p + 9, end - p - 9, "]]>", 3);
+            p = close ? close + 3 : end;
+            continue;
+        }
+        if (p + 1 < end && (p[1] == '?' || p[1] == '!' || p[1] == '/')) {
+            close = memchr(p, '>', end - p);
+            p = close ? close + 1 : end;
+            continue;
+        }
+
+        element->name = ++p;
+        while (p < end && !isspace(*p) && *p != '/' && *p != '>') p++;
+        element->name_length = p - element->name;
+        element->attributes = p;
+
+        // A '>' inside a quoted value does not end the tag
+        while (p < end && *p != '>') {
+            if (*p == '"' || *p == '\'') {
+                const char *quote = memchr(p + 1, *p, end - p - 1);
+                if (!quote) {
+                    return NULL;
+                }
+                p = quote;
+            }
+            p++;
+        }
+        if (p >= end) {
+            return NULL;
+        }
+        element->end = p;
+        element->self_closing = p[-1] == '/';
+        return p + 1;
+    }
+    return NULL;
+}
+
+/* Read the next attribute of a start tag
+ * Returns: false after the last attribute
+ */
+static bool next_attribute(const char **p, const char *tag_end, SvgAttribute *attribute) {
+    const char *s = *p;
+    while (s < tag_end && (isspace(*s) || *s == '/')) s++;
+    if (s >= tag_end) {
+        return false;
+    }
+
+    attribute->name = s;
+    while (s < tag_end && *s != '=' && !isspace(*s)) s++;
+    attribute->name_length = s - attribute->name;
+    while (s < tag_end && isspace(*s)) s++;
+
+    // Attributes without a quoted value carry nothing we read
+    attribute->value = NULL;
+    attribute->value_length = 0;
+    if (s < tag_end && *s == '=') {
+        s++;
+        while (s < tag_end && isspace(*s)) s++;
+        if (s < tag_end && (*s == '"' || *s == '\'')) {
+            const char *quote = memchr(s + 1, *s, tag_end - s - 1);
+            if (!quote) {
+                return false;
+            }
+            attribute->value = s + 1;
+            attribute->value_length = quote - s - 1;
+            s = quote + 1;
+        }
+    }
+
+    *p = (s > attribute->name) ? s : s + 1;
+    return true;
+}
+
+/* Parse up to count numbers of an attribute value
+ * Returns: Number of values parsed
+ */
+static int parse_numbers(const char *value, size_t length, float *numbers, int count) {
+    const char *p = value, *end = value + length;
+    int parsed = 0;
+    while (parsed < count) {
+        while (p < end && (isspace(*p) || *p == ',')) p++;
+        if (p >= end) {
+            break;
+        }
+
+        // The closing quote ends every number
+        char *num_end;
+        numbers[parsed] = strtof(p, &num_end);
+        if (num_end == p || num_end > end) {
+            break;
+        }
+        p = num_end;
+        parsed++;
+    }
+    return parsed;
+}
+
+/* Find a property such as fill in a style attribute */
+static bool style_property(const char *style, size_t length, const char *name,
+                           const char **value, size_t *value_length) {
+    const char *p = style, *end = style + length;
+    while (p < end) {
+        const char *decl_end = memchr(p, ';', end - p);
+        if (!decl_end) {
+            decl_end = end;
+        }
+
+        const char *colon = memchr(p, ':', decl_end - p);
+        if (colon) {
+            const char *name_end = colon;
+            while (p < name_end && isspace(*p)) p++;
+            while (name_end > p && isspace(name_end[-1])) name_end--;
+
+            if (name_is(p, name_end - p, name)) {
+                const char *v = colon + 1, *v_end = decl_end;
+                while (v < v_end && isspace(*v)) v++;
+                while (v_end > v && isspace(v_end[-1])) v_end--;
+                *value = v;
+                *value_length = v_end - v;
+                return true;
+            }
+        }
+        p = decl_end + 1;
+    }
+    return false;
+}
+
+/* Map an SVG file and read the viewBox of its root element */
+SvgFile* svg_open(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        fprintf(stderr, "Failed to open %s: %m\n", path);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %m\n", path);
+        return NULL;
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    SvgFile *file = calloc(1, sizeof(SvgFile));
+    if (!file) {
+        munmap(data, st.st_size);
+        return NULL;
+    }
+    file->data = data;
+    file->size = st.st_size;
+
+    SvgElement root;
+    const char *end = file->data + file->size;
+    file->body = next_element(file->data, end, &root);
+    if (!file->body || !name_is(root.name, root.name_length, "svg")) {
+        fprintf(stderr, "%s is not an SVG file\n", path);
+        svg_close(file);
+        return NULL;
+    }
+
+    float view_box[4] = { 0 }, width = 0, height = 0;
+    bool has_view_box = false;
+    const char *p = root.attributes;
+    SvgAttribute attribute;
+    while (next_attribute(&p, root.end, &attribute)) {
+        if (!attribute.value) {
+            continue;
+        }
+        if (name_is(attribute.name, attribute.name_length, "viewBox")) {
+            has_view_box = parse_numbers(attribute.value, attribute.value_length, view_box, 4) == 4;
+        } else if (name_is(attribute.name, attribute.name_length, "width")) {
+            parse_numbers(attribute.value, attribute.value_length, &width, 1);
+        } else if (name_is(attribute.name, attribute.name_length, "height")) {
+            parse_numbers(attribute.value, attribute.value_length, &height, 1);
+        }
+    }
+
+    if (has_view_box) {
+        file->view_box = (ViewBox){ view_box[0], view_box[1], view_box[2], view_box[3] };
+    } else {
+        file->view_box = (ViewBox){ 0, 0, width, height };
+    }
+    if (!(file->view_box.width > 0) || !(file->view_box.height > 0)) {
+        fprintf(stderr, "%s has no usable viewBox or size\n", path);
+        svg_close(file);
+        return NULL;
+    }
+
+    return file;
+}
+
+/* View box of the root element */
+const ViewBox* svg_view_box(const SvgFile *file) {
+    return &file->view_box;
+}
+
+/* Find the next <path> that is drawn, skipping hidden containers
+ * Returns: Byte after its tag, or NULL when there is none
+ */
+static const char *next_drawn_path(const char *p, const char *end, SvgDrawnPath *path) {
+    SvgElement element;
+    while ((p = next_element(p, end, &element)) != NULL) {
+        // Skip definitions and masks with everything inside them
+        bool hidden = false;
+        for (size_t i = 0; i < sizeof(hidden_containers) / sizeof(hidden_containers[0]); i++) {
+            hidden |= name_is(element.name, element.name_length, hidden_containers[i]);
+        }
+        if (hidden) {
+            if (!element.self_closing) {
+                char close_tag[16];
+                int len = snprintf(close_tag, sizeof(close_tag), "</%.*s",
+                                   (int)element.name_length, element.name);
+                const char *close = memmem(p, end - p, close_tag, len);
+                p = close ? close + len : end;
+            }
+            continue;
+        }
+        if (!name_is(element.name, element.name_length, "path")) {
+            continue;
+        }
+
+        const char *fill = NULL, *rule = NULL;
+        size_t fill_length = 0, rule_length = 0;
+        const char *a = element.attributes;
+        SvgAttribute attribute;
+        bool styled = false, rule_styled = false;
+        path->d = NULL;
+        path->d_length = 0;
+        while (next_attribute(&a, element.end, &attribute)) {
+            if (!attribute.value) {
+                continue;
+            }
+            if (name_is(attribute.name, attribute.name_length, "d")) {
+                path->d = attribute.value;
+                path->d_length = attribute.value_length;
+            } else if (name_is(attribute.name, attribute.name_length, "fill") && !styled) {
+                fill = attribute.value;
+                fill_length = attribute.value_length;
+            } else if (name_is(attribute.name, attribute.name_length, "fill-rule") && !rule_styled) {
+                rule = attribute.value;
+                rule_length = attribute.value_length;
+            } else if (name_is(attribute.name, attribute.name_length, "style")) {
+                // Style properties win over the presentation attributes
+                styled = style_property(attribute.value, attribute.value_length, "fill",
+                                        &fill, &fill_length);
+                rule_styled = style_property(attribute.value, attribute.value_length, "fill-rule",
+                                             &rule, &rule_length);
+            }
+        }
+
+        if (!path->d || (fill && name_is(fill, fill_length, "none"))) {
+            continue;
+        }
+
+        char color[MAX_COLOR_LENGTH + 1] = "";
+        if (fill) {
+            size_t len = (fill_length < MAX_COLOR_LENGTH) ? fill_length : MAX_COLOR_LENGTH;
+            memcpy(color, fill, len);
+            color[len] = '\0';
+        }
+        path->fill = parse_color(color);
+        path->fill_rule = (rule && name_is(rule, rule_length, "evenodd")) ? FILL_EVENODD : FILL_NONZERO;
+        return p;
+    }
+    return NULL;
+}
+
+/* Load every <path> of the file into a scene
+ * A counting pass sizes one arena for the scene, its paths, subpaths and
+ * points, then a second pass parses into it.
+ */
+SVGScene* svg_load_scene(const SvgFile *file, float tolerance) {
+    const char *end = file->data + file->size;
+    const char *p = file->body;
+    SvgDrawnPath drawn;
+
+    uint32_t num_paths = 0;
+    PathCounts total = { 0, 0 };
+    while ((p = next_drawn_path(p, end, &drawn)) != NULL) {
+        PathCounts counts;
+        count_svg_path(drawn.d, drawn.d_length, tolerance, &counts);
+        if (counts.subpaths > 0) {
+            num_paths++;
+            total.subpaths += counts.subpaths;
+            total.points += counts.points;
+        }
+    }
+    if (num_paths == 0) {
+        fprintf(stderr, "No filled paths in the SVG file\n");
+        return NULL;
+    }
+
+    GeometryArena arena;
+    size_t size = geometry_arena_round(sizeof(SVGScene)) +
+                  geometry_arena_round(num_paths * sizeof(SVGPath)) +
+                  geometry_arena_round(total.subpaths * sizeof(Path)) +
+                  geometry_arena_round(total.points * sizeof(Point));
+    if (geometry_arena_init(&arena, size) != 0) {
+        fprintf(stderr, "Failed to allocate %zu bytes of geometry\n", size);
+        return NULL;
+    }
+
+    SVGScene *scene = geometry_arena_alloc(&arena, sizeof(SVGScene));
+    SVGPath *paths = geometry_arena_alloc(&arena, num_paths * sizeof(SVGPath));
+    PathStorage storage = {
+        geometry_arena_alloc(&arena, total.subpaths * sizeof(Path)), total.subpaths,
+        geometry_arena_alloc(&arena, total.points * sizeof(Point)), total.points,
+    };
+    *scene = (SVGScene){ paths, 0, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, file->view_box };
+
+    p = file->body;
+    while (scene->num_paths < num_paths && (p = next_drawn_path(p, end, &drawn)) != NULL) {
+        SVGPath *svg = &paths[scene->num_paths];
+        Point *first = storage.points;
+        if (!parse_svg_path_into(svg, drawn.d, drawn.d_length, drawn.fill, tolerance, &storage)) {
+            // The counting pass saw less geometry than parsing produced
+            fprintf(stderr, "Path %u of the SVG file does not fit its counted storage\n",
+                    scene->num_paths);
+            svg_free_scene(scene);
+            return NULL;
+        }
+        svg->fill_rule = drawn.fill_rule;
+        if (svg->num_paths == 0) {
+            continue;
+        }
+        scene->num_paths++;
+
+        // Points of the path are contiguous in the arena
+        for (Point *pt = first; pt < storage.points; pt++) {
+            if (pt->x < scene->min_x) scene->min_x = pt->x;
+            if (pt->x > scene->max_x) scene->max_x = pt->x;
+            if (pt->y < scene->min_y) scene->min_y = pt->y;
+            if (pt->y > scene->max_y) scene->max_y = pt->y;
+        }
+    }
+
+    return scene;
+}
+
+/* Unmap the file, scenes loaded from it stay valid */
+void svg_close(SvgFile *file) {
+    if (!file) {
+        return;
+    }
+    munmap((void *)file->data, file->size);
+    free(file);
+}
+
+/* Free a scene loaded by svg_load_scene(), it starts its arena */
+void svg_free_scene(SVGScene *scene) {
+    free(scene);
+}
@@ -0,0 +1,37 @@
+#ifndef SVG_LOADER_H
+#define SVG_LOADER_H
+
+#include "svg_types.h"
+
+/* SVG file mapped for loading
+ * Opening reads the root element only, so the view box is known and
+ * the layout can be computed before the paths are flattened for it.
+ */
+typedef struct SvgFile SvgFile;
+
+/* Map an SVG file and read the viewBox of its root element
+ * Without a viewBox the width and height attributes give the view box.
+ * Returns: File or NULL on failure
+ */
+SvgFile* svg_open(const char *path);
+
+/* View box of the root element */
+const ViewBox* svg_view_box(const SvgFile *file);
+
+/* Load every <path> of the file into a scene
+ * d, fill and fill-rule are read, from style properties first. Paths
+ * filled with none and those inside defs, clipPath, mask, marker, pattern
+ * and symbol are skipped. Groups and transforms are not applied. The scene and all
+ * of its geometry are one allocation, sized by counting first.
+ * tolerance: Curve flattening tolerance in path units
+ * Returns: Scene to release with svg_free_scene() or NULL on failure
+ */
+SVGScene* svg_load_scene(const SvgFile *file, float tolerance);
+
+/* Unmap the file, scenes loaded from it stay valid */
+void svg_close(SvgFile *file);
+
+/* Free a scene loaded by svg_load_scene() */
+void svg_free_scene(SVGScene *scene);
+
+#endif
@@ -2,245 +2,487 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
 #include "svg_parser.h"
 
-#define INITIAL_CAPACITY 100
-#define MAX_SUBPATHS 10
+#define MAX_CURVE_SEGMENTS 1024  // Bounds the points of one degenerate curve
 
-/* Track current position during path parsing */
-static Point current_point = {0, 0};
-static Point start_point = {0, 0};
-
-/* Structure to handle compound paths with holes */
+/* State of one walk over path data, parses on other threads do not share any
+ * Without an SVGPath only subpaths and points are counted, so the same
+ * walk sizes the storage and then fills it.
+ */
 typedef struct {
-    Path paths[MAX_SUBPATHS];
-    int num_paths;
-} CompoundPath;
+    Point current_point;     // Pen position
+    Point start_point;       // Start of the subpath, where Z returns to
+    Point last_control;      // Control point S and T reflect
+    SVGPath *svg;            // Path being filled, NULL while counting
+    PathStorage *storage;    // Free subpaths and points, NULL while counting
+    bool subpath_open;       // Points go to the last subpath
+    bool overflow;           // Storage ran out, the geometry is incomplete
+    PathCounts counts;       // Subpaths and points so far
+} ParseContext;
 
 /* Parse a floating point number from a string
- * Advances the string pointer past the parsed number
+ * Advances the string pointer past the parsed number. The data must be
+ * followed by a character that ends a number, such as a NUL or a quote.
+ * Returns: false if there is no number before end
  */
-static float parse_number(const char **str) {
+static bool parse_number(const char **str, const char *end, float *num) {
     // Skip whitespace and commas
-    while (isspace(**str) || **str == ',') (*str)++;
+    while (*str < end && (isspace(**str) || **str == ',')) (*str)++;
+    if (*str >= end) {
+        return false;
+    }
 
-    char *end;
-    float num = strtof(*str, &end);
-    *str = end;
-    return num;
+    char *num_end;
+    *num = strtof(*str, &num_end);
+    if (num_end == *str || num_end > end) {
+        return false;
+    }
+    *str = num_end;
+    return true;
 }
 
-/* Add a point to a path, growing the array if needed */
-static void add_point_to_path(Path *path, float x, float y) {
-    if (path->num_points >= path->capacity) {
-        path->capacity *= 2;
-        Point *new_points = realloc(path->points, path->capacity * sizeof(Point));
-        if (!new_points) {
-            return;
-        }
-        path->points = new_points;
+/* Parse an arc flag, a single 0 or 1 that needs no separator */
+static bool parse_flag(const char **str, const char *end, float *flag) {
+    while (*str < end && (isspace(**str) || **str == ',')) (*str)++;
+
+    if (*str >= end || (**str != '0' && **str != '1')) {
+        return false;
     }
-    path->points[path->num_points].x = x;
-    path->points[path->num_points].y = y;
-    path->num_points++;
+    *flag = (float)(**str - '0');
+    (*str)++;
+    return true;
 }
 
-/* Add all paths from a compound path to the SVG structure
- * First path is considered the outer path, subsequent paths are holes
- */
-static void add_compound_path_to_svg(SVGPath *svg, CompoundPath *compound) {
-    for (int i = 0; i < compound->num_paths; i++) {
-        if (svg->num_paths >= svg->capacity) {
-            svg->capacity *= 2;
-            Path *new_paths = realloc(svg->paths, svg->capacity * sizeof(Path));
-            if (!new_paths) {
-                return;
-            }
-            svg->paths = new_paths;
-        }
-        svg->paths[svg->num_paths] = compound->paths[i];
-        svg->paths[svg->num_paths].is_hole = (i > 0); // First path is outer, rest are holes
-        svg->num_paths++;
+/* Number of arguments a path command takes, -1 for unknown commands */
+static int command_arguments(char command) {
+    switch (toupper(command)) {
+        case 'Z': return 0;
+        case 'H': case 'V': return 1;
+        case 'M': case 'L': case 'T': return 2;
+        case 'S': case 'Q': return 4;
+        case 'C': return 6;
+        case 'A': return 7;
+        default: return -1;
+    }
+}
+
+/* Start a subpath, its direction decides whether it fills or cuts a hole */
+static void begin_subpath(ParseContext *ctx) {
+    ctx->subpath_open = true;
+    ctx->counts.subpaths++;
+    if (!ctx->svg) {
+        return;
+    }
+
+    PathStorage *storage = ctx->storage;
+    if (storage->free_paths == 0) {
+        ctx->overflow = true;
+        return;
+    }
+    Path *path = &ctx->svg->paths[ctx->svg->num_paths++];
+    path->points = storage->points;
+    path->num_points = 0;
+    path->capacity = 0;
+    storage->free_paths--;
+}
+
+/* Add a point to the current subpath, starting one if needed */
+static void add_point(ParseContext *ctx, float x, float y) {
+    if (!ctx->subpath_open) {
+        begin_subpath(ctx);
     }
+    ctx->counts.points++;
+    if (!ctx->svg || ctx->overflow) {
+        return;
+    }
+
+    PathStorage *storage = ctx->storage;
+    if (storage->free_points == 0) {
+        ctx->overflow = true;
+        return;
+    }
+    Path *path = &ctx->svg->paths[ctx->svg->num_paths - 1];
+    storage->points->x = x;
+    storage->points->y = y;
+    storage->points++;
+    storage->free_points--;
+    path->num_points++;
+    path->capacity = path->num_points;
 }
 
-/* Parse an RGB color string into a Color structure */
+/* Parse an RGB or hex color string into a Color structure */
 Color parse_color(const char *color_str) {
     Color color = {0, 0, 0, 255}; // Default to opaque black
-    
+    unsigned int r, g, b;
+
+    while (isspace(*color_str)) color_str++;
+
     if (strstr(color_str, "rgb(") == color_str) {
-        int r, g, b;
-        if (sscanf(color_str, "rgb(%d,%d,%d)", &r, &g, &b) == 3) {
+        if (sscanf(color_str, "rgb( %u , %u , %u )", &r, &g, &b) == 3) {
             color.r = (uint8_t)r;
             color.g = (uint8_t)g;
             color.b = (uint8_t)b;
         }
+    } else if (*color_str == '#') {
+        size_t digits = strspn(color_str + 1, "0123456789abcdefABCDEF");
+        if (digits == 6 && sscanf(color_str + 1, "%2x%2x%2x", &r, &g, &b) == 3) {
+            color.r = (uint8_t)r;
+            color.g = (uint8_t)g;
+            color.b = (uint8_t)b;
+        } else if (digits == 3 && sscanf(color_str + 1, "%1x%1x%1x", &r, &g, &b) == 3) {
+            // #rgb repeats each digit
+            color.r = (uint8_t)(r * 17);
+            color.g = (uint8_t)(g * 17);
+            color.b = (uint8_t)(b * 17);
+        }
+    } else if (strncmp(color_str, "white", 5) == 0) {
+        color.r = color.g = color.b = 255;
     }
 
     return color;
 }
 
-/* Parse an SVG path data string into an SVGPath structure
- * Handles multiple subpaths and holes
- * Supports commands: M, L, H, V, C, Z
+/* Parse a color that is the first length bytes of a string, nothing else */
+bool parse_color_exact(const char *color_str, size_t length, Color *color) {
+    char buf[32];
+    if (length >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, color_str, length);
+    buf[length] = '\0';
+
+    bool valid;
+    if (buf[0] == '#') {
+        size_t digits = strspn(buf + 1, "0123456789abcdefABCDEF");
+        valid = (digits == 3 || digits == 6) && digits + 1 == length;
+    } else if (strncmp(buf, "rgb(", 4) == 0) {
+        unsigned int r, g, b;
+        int end = -1;
+        valid = sscanf(buf, "rgb( %u , %u , %u )%n", &r, &g, &b, &end) == 3 && (size_t)end == length &&
+                r <= 255 && g <= 255 && b <= 255;
+    } else {
+        valid = strcmp(buf, "black") == 0 || strcmp(buf, "white") == 0;
+    }
+
+    if (valid) {
+        *color = parse_color(buf);
+    }
+    return valid;
+}
+
+/* Count the points of a curve without evaluating them */
+static void count_points(ParseContext *ctx, uint32_t n) {
+    if (!ctx->subpath_open) {
+        begin_subpath(ctx);
+    }
+    ctx->counts.points += n;
+}
+
+/* Segments a curve needs to stay within the tolerance of its chords
+ * Wang's formula, second_diff is the degree-weighted largest second
+ * difference of the control points.
  */
-SVGPath* parse_svg_path(const char *path_data, const char *style) {
-    // Initialize SVG structure
-    SVGPath *svg = malloc(sizeof(SVGPath));
-    if (!svg) return NULL;
-
-    svg->paths = malloc(INITIAL_CAPACITY * sizeof(Path));
-    if (!svg->paths) {
-        free(svg);
-        return NULL;
+static uint32_t curve_segments(float second_diff, float tolerance) {
+    float n = ceilf(sqrtf(second_diff / tolerance));
+    if (!(n >= 1)) {
+        return 1;
     }
+    return (n > MAX_CURVE_SEGMENTS) ? MAX_CURVE_SEGMENTS : (uint32_t)n;
+}
 
-    svg->num_paths = 0;
-    svg->capacity = INITIAL_CAPACITY;
-    svg->fill_color = parse_color(style);
-
-    // Initialize compound path structure
-    CompoundPath compound = {0};
-    compound.num_paths = 0;
-
-    // Initialize first path
-    Path *current_path = &compound.paths[0];
-    current_path->points = malloc(INITIAL_CAPACITY * sizeof(Point));
-    if (!current_path->points) {
-        free(svg->paths);
-        free(svg);
-        return NULL;
+/* Length of p0 - 2 p1 + p2 */
+static float second_difference(Point p0, Point p1, Point p2) {
+    return hypotf(p0.x - 2 * p1.x + p2.x, p0.y - 2 * p1.y + p2.y);
+}
+
+/* Flatten a quadratic Bezier from the current point, the end point is exact */
+static void flatten_quad(ParseContext *ctx, Point p0, Point p1, Point p2, float tolerance) {
+    uint32_t n = curve_segments(0.25f * second_difference(p0, p1, p2), tolerance);
+    if (!ctx->svg) {
+        count_points(ctx, n);
+        return;
+    }
+    for (uint32_t i = 1; i < n; i++) {
+        float t = (float)i / n;
+        float mt = 1 - t;
+        add_point(ctx,
+                  p0.x * mt * mt + 2 * p1.x * mt * t + p2.x * t * t,
+                  p0.y * mt * mt + 2 * p1.y * mt * t + p2.y * t * t);
+    }
+    add_point(ctx, p2.x, p2.y);
+}
+
+/* Flatten a cubic Bezier from the current point, the end point is exact */
+static void flatten_cubic(ParseContext *ctx, Point p0, Point p1, Point p2, Point p3, float tolerance) {
+    float d1 = second_difference(p0, p1, p2);
+    float d2 = second_difference(p1, p2, p3);
+    uint32_t n = curve_segments(0.75f * ((d1 > d2) ? d1 : d2), tolerance);
+    if (!ctx->svg) {
+        count_points(ctx, n);
+        return;
+    }
+    for (uint32_t i = 1; i < n; i++) {
+        float t = (float)i / n;
+        float t_squared = t * t;
+        float mt = 1 - t;
+        float mt_squared = mt * mt;
+
+        // Cubic Bezier formula
+        add_point(ctx,
+                  p0.x * mt_squared * mt + 3 * p1.x * mt_squared * t +
+                  3 * p2.x * mt * t_squared + p3.x * t_squared * t,
+                  p0.y * mt_squared * mt + 3 * p1.y * mt_squared * t +
+                  3 * p2.y * mt * t_squared + p3.y * t_squared * t);
+    }
+    add_point(ctx, p3.x, p3.y);
+}
+
+/* Flatten an elliptical arc given by its end points, as in the SVG spec
+ * Radii too small to reach the end point are scaled up, zero radii
+ * make a straight line.
+ */
+static void flatten_arc(ParseContext *ctx, Point p0, float rx, float ry, float angle, bool large_arc,
+                        bool sweep, Point p1, float tolerance) {
+    if (p0.x == p1.x && p0.y == p1.y) {
+        return;
+    }
+    rx = fabsf(rx);
+    ry = fabsf(ry);
+    if (rx == 0 || ry == 0) {
+        add_point(ctx, p1.x, p1.y);
+        return;
+    }
+
+    // End points in the frame of the ellipse axes
+    float phi = angle * (float)M_PI / 180.0f;
+    float cos_phi = cosf(phi), sin_phi = sinf(phi);
+    float dx = (p0.x - p1.x) / 2, dy = (p0.y - p1.y) / 2;
+    float x1 = cos_phi * dx + sin_phi * dy;
+    float y1 = -sin_phi * dx + cos_phi * dy;
+
+    float lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+    if (lambda > 1) {
+        rx *= sqrtf(lambda);
+        ry *= sqrtf(lambda);
+    }
+
+    // Center, on the side the flags select
+    float num = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+    float den = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+    float coef = (num > 0) ? sqrtf(num / den) : 0;
+    if (large_arc == sweep) {
+        coef = -coef;
+    }
+    float cx1 = coef * rx * y1 / ry;
+    float cy1 = -coef * ry * x1 / rx;
+    float cx = cos_phi * cx1 - sin_phi * cy1 + (p0.x + p1.x) / 2;
+    float cy = sin_phi * cx1 + cos_phi * cy1 + (p0.y + p1.y) / 2;
+
+    float theta = atan2f((y1 - cy1) / ry, (x1 - cx1) / rx);
+    float delta = atan2f((-y1 - cy1) / ry, (-x1 - cx1) / rx) - theta;
+    if (sweep && delta < 0) {
+        delta += 2 * (float)M_PI;
+    } else if (!sweep && delta > 0) {
+        delta -= 2 * (float)M_PI;
     }
-    current_path->num_points = 0;
-    current_path->capacity = INITIAL_CAPACITY;
-    current_path->is_hole = 0;
 
+    // Step angle whose chord stays within the tolerance of the larger radius
+    float r = (rx > ry) ? rx : ry;
+    float step = (tolerance < r) ? 2 * acosf(1 - tolerance / r) : (float)M_PI / 2;
+    float n = ceilf(fabsf(delta) / step);
+    uint32_t segments = (n < 1) ? 1 : (n > MAX_CURVE_SEGMENTS) ? MAX_CURVE_SEGMENTS : (uint32_t)n;
+    if (!ctx->svg) {
+        count_points(ctx, segments);
+        return;
+    }
+
+    for (uint32_t i = 1; i < segments; i++) {
+        float a = theta + delta * i / segments;
+        float ex = rx * cosf(a), ey = ry * sinf(a);
+        add_point(ctx, cos_phi * ex - sin_phi * ey + cx, sin_phi * ex + cos_phi * ey + cy);
+    }
+    add_point(ctx, p1.x, p1.y);
+}
+
+/* Walk path data into a builder
+ * Handles multiple subpaths and holes
+ * Supports the full path grammar: M, L, H, V, C, S, Q, T, A and Z, each
+ * absolute or relative, with implicitly repeated arguments
+ */
+static void walk_path(const char *path_data, size_t length, float tolerance, ParseContext *ctx) {
     const char *p = path_data;
+    const char *end = path_data + length;
     char command = 'M';
-    float x1, y1, x2, y2, x3, y3;
+    char previous = 'M';  // Last command drawn, S and T only reflect curves
+    float args[7];
     bool new_subpath = true;
 
     // Parse path commands
-    while (*p) {
+    while (p < end) {
         if (isalpha(*p)) {
-            // Handle new subpath creation
-            if (*p == 'M' && !new_subpath) {
-                if (current_path->num_points > 0) {
-                    compound.num_paths++;
-                    if (compound.num_paths < MAX_SUBPATHS) {
-                        current_path = &compound.paths[compound.num_paths];
-                        current_path->points = malloc(INITIAL_CAPACITY * sizeof(Point));
-                        current_path->num_points = 0;
-                        current_path->capacity = INITIAL_CAPACITY;
-                        current_path->is_hole = 1;
-                    }
-                }
+            // A move after drawing starts a new subpath with its next point
+            if ((*p == 'M' || *p == 'm') && !new_subpath) {
+                ctx->subpath_open = false;
             }
             command = *p++;
-            new_subpath = (command == 'M');
+            new_subpath = (command == 'M' || command == 'm');
+        }
+
+        // Skip unknown commands and arguments that do not parse
+        int count = command_arguments(command);
+        bool valid = count >= 0;
+        for (int i = 0; valid && i < count; i++) {
+            bool flag = (toupper(command) == 'A') && (i == 3 || i == 4);
+            valid = flag ? parse_flag(&p, end, &args[i]) : parse_number(&p, end, &args[i]);
+        }
+        if (!valid) {
+            while (p < end && !isalpha(*p)) p++;
+            continue;
         }
 
+        // Relative coordinates are offsets from the current point
+        bool relative = islower(command);
+        float ox = relative ? ctx->current_point.x : 0;
+        float oy = relative ? ctx->current_point.y : 0;
+        Point from = ctx->current_point;
+        Point control = ctx->current_point;
+
         // Process commands
-        switch (command) {
+        switch (toupper(command)) {
             case 'M': // Move To
-                x1 = parse_number(&p);
-                y1 = parse_number(&p);
-                add_point_to_path(current_path, x1, y1);
-                current_point.x = start_point.x = x1;
-                current_point.y = start_point.y = y1;
-                command = 'L'; // After M, implicit command is L
+                add_point(ctx, args[0] + ox, args[1] + oy);
+                ctx->current_point.x = ctx->start_point.x = args[0] + ox;
+                ctx->current_point.y = ctx->start_point.y = args[1] + oy;
+                command = relative ? 'l' : 'L'; // After M, implicit command is L
                 break;
 
             case 'L': // Line To
-                x1 = parse_number(&p);
-                y1 = parse_number(&p);
-                add_point_to_path(current_path, x1, y1);
-                current_point.x = x1;
-                current_point.y = y1;
+                ctx->current_point = (Point){ args[0] + ox, args[1] + oy };
+                add_point(ctx, ctx->current_point.x, ctx->current_point.y);
                 break;
 
             case 'H': // Horizontal Line
-                x1 = parse_number(&p);
-                add_point_to_path(current_path, x1, current_point.y);
-                current_point.x = x1;
+                ctx->current_point.x = args[0] + ox;
+                add_point(ctx, ctx->current_point.x, ctx->current_point.y);
                 break;
 
             case 'V': // Vertical Line
-                y1 = parse_number(&p);
-                add_point_to_path(current_path, current_point.x, y1);
-                current_point.y = y1;
+                ctx->current_point.y = args[0] + oy;
+                add_point(ctx, ctx->current_point.x, ctx->current_point.y);
                 break;
 
             case 'Z': // Close Path
-            case 'z':
-                if (current_path->num_points > 0) {
-                    add_point_to_path(current_path, start_point.x, start_point.y);
+                if (ctx->subpath_open) {
+                    add_point(ctx, ctx->start_point.x, ctx->start_point.y);
                 }
+                ctx->current_point = ctx->start_point;
                 break;
 
             case 'C': // Cubic Bezier Curve
-                // Get control points and end point
-                x1 = parse_number(&p);
-                y1 = parse_number(&p);
-                x2 = parse_number(&p);
-                y2 = parse_number(&p);
-                x3 = parse_number(&p);
-                y3 = parse_number(&p);
-
-                // Approximate curve with line segments
-                for (float t = 0; t <= 1; t += 0.1) {
-                    float t_squared = t * t;
-                    float t_cubed = t_squared * t;
-                    float mt = 1 - t;
-                    float mt_squared = mt * mt;
-                    float mt_cubed = mt_squared * mt;
-
-                    // Cubic Bezier formula
-                    float px = current_point.x * mt_cubed +
-                              3 * x1 * mt_squared * t +
-                              3 * x2 * mt * t_squared +
-                              x3 * t_cubed;
-
-                    float py = current_point.y * mt_cubed +
-                              3 * y1 * mt_squared * t +
-                              3 * y2 * mt * t_squared +
-                              y3 * t_cubed;
-
-                    add_point_to_path(current_path, px, py);
+                control = (Point){ args[2] + ox, args[3] + oy };
+                ctx->current_point = (Point){ args[4] + ox, args[5] + oy };
+                flatten_cubic(ctx, from, (Point){ args[0] + ox, args[1] + oy },
+                              control, ctx->current_point, tolerance);
+                break;
+
+            case 'S': // Smooth Cubic, first control mirrors the last one
+                if (previous == 'C' || previous == 'S') {
+                    control = (Point){ 2 * from.x - ctx->last_control.x, 2 * from.y - ctx->last_control.y };
                 }
+                ctx->current_point = (Point){ args[2] + ox, args[3] + oy };
+                flatten_cubic(ctx, from, control, (Point){ args[0] + ox, args[1] + oy },
+                              ctx->current_point, tolerance);
+                control = (Point){ args[0] + ox, args[1] + oy };
+                break;
 
-                current_point.x = x3;
-                current_point.y = y3;
+            case 'Q': // Quadratic Bezier Curve
+                control = (Point){ args[0] + ox, args[1] + oy };
+                ctx->current_point = (Point){ args[2] + ox, args[3] + oy };
+                flatten_quad(ctx, from, control, ctx->current_point, tolerance);
+                break;
+
+            case 'T': // Smooth Quadratic, control mirrors the last one
+                if (previous == 'Q' || previous == 'T') {
+                    control = (Point){ 2 * from.x - ctx->last_control.x, 2 * from.y - ctx->last_control.y };
+                }
+                ctx->current_point = (Point){ args[0] + ox, args[1] + oy };
+                flatten_quad(ctx, from, control, ctx->current_point, tolerance);
                 break;
 
-            default:
-                // Skip unknown commands
-                while (*p && !isalpha(*p)) p++;
+            case 'A': // Elliptical Arc
+                ctx->current_point = (Point){ args[5] + ox, args[6] + oy };
+                flatten_arc(ctx, from, args[0], args[1], args[2], args[3] != 0, args[4] != 0,
+                            ctx->current_point, tolerance);
                 break;
         }
+        previous = (char)toupper(command);
+        ctx->last_control = control;
 
         // Skip whitespace
-        while (isspace(*p)) p++;
-    }
+        while (p < end && isspace(*p)) p++;
 
-    // Add final path if it contains points
-    if (current_path->num_points > 0) {
-        compound.num_paths++;
+        // Close Path takes no arguments, anything but a command after it is skipped
+        if (previous == 'Z' && p < end && !isalpha(*p)) {
+            while (p < end && !isalpha(*p)) p++;
+        }
     }
+}
 
-    // Add all paths to SVG structure
-    add_compound_path_to_svg(svg, &compound);
+/* Count the subpaths and points path data parses into */
+void count_svg_path(const char *path_data, size_t length, float tolerance, PathCounts *counts) {
+    ParseContext ctx = { { 0, 0 }, { 0, 0 }, { 0, 0 }, NULL, NULL, false, false, { 0, 0 } };
+    walk_path(path_data, length, tolerance, &ctx);
+    *counts = ctx.counts;
+}
 
+/* Parse path data into storage sized by count_svg_path() */
+bool parse_svg_path_into(SVGPath *svg, const char *path_data, size_t length, Color fill, float tolerance,
+                         PathStorage *storage) {
+    svg->paths = storage->paths;
+    svg->num_paths = 0;
+    svg->fill_color = fill;
+    svg->fill_rule = FILL_NONZERO;
+
+    ParseContext ctx = { { 0, 0 }, { 0, 0 }, { 0, 0 }, svg, storage, false, false, { 0, 0 } };
+    walk_path(path_data, length, tolerance, &ctx);
+    storage->paths += svg->num_paths;
+    svg->capacity = svg->num_paths;
+    return !ctx.overflow;
+}
+
+/* Parse an SVG path data string into an SVGPath structure */
+SVGPath* parse_svg_path(const char *path_data, const char *style, float tolerance) {
+    return parse_svg_path_data(path_data, strlen(path_data), parse_color(style), tolerance);
+}
+
+/* Parse path data that is not NUL terminated into one allocation */
+SVGPath* parse_svg_path_data(const char *path_data, size_t length, Color fill, float tolerance) {
+    PathCounts counts;
+    count_svg_path(path_data, length, tolerance, &counts);
+
+    GeometryArena arena;
+    size_t size = geometry_arena_round(sizeof(SVGPath)) +
+                  geometry_arena_round(counts.subpaths * sizeof(Path)) +
+                  geometry_arena_round(counts.points * sizeof(Point));
+    if (geometry_arena_init(&arena, size) != 0) {
+        return NULL;
+    }
+
+    SVGPath *svg = geometry_arena_alloc(&arena, sizeof(SVGPath));
+    PathStorage storage = {
+        geometry_arena_alloc(&arena, counts.subpaths * sizeof(Path)), counts.subpaths,
+        geometry_arena_alloc(&arena, counts.points * sizeof(Point)), counts.points,
+    };
+    if (!parse_svg_path_into(svg, path_data, length, fill, tolerance, &storage)) {
+        free_svg_path(svg);
+        return NULL;
+    }
     return svg;
 }
 
-/* Free all resources associated with an SVG path */
+/* Free an SVG path and its geometry, all in one block */
 void free_svg_path(SVGPath *svg) {
-    if (svg) {
-        for (uint32_t i = 0; i < svg->num_paths; i++) {
-            free(svg->paths[i].points);
-        }
-        free(svg->paths);
-        free(svg);
-    }
+    free(svg);
 }
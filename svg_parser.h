@@ -1,21 +1,69 @@
 #ifndef SVG_PARSER_H
 #define SVG_PARSER_H
 
+#include <stddef.h>
 #include "svg_types.h"
+#include "geometry_arena.h"
+
+/* Subpaths and points that path data parses into */
+typedef struct {
+    uint32_t subpaths;
+    uint32_t points;
+} PathCounts;
+
+/* Free geometry that paths are parsed into, advanced past what they use
+ * All subpaths and points of the paths parsed into it end up contiguous.
+ */
+typedef struct {
+    Path *paths;             // Next free subpath
+    uint32_t free_paths;
+    Point *points;           // Next free point
+    uint32_t free_points;
+} PathStorage;
 
 /* Parse an SVG path string into an SVGPath structure
  * path_data: SVG path data string (e.g., "M 0,0 L 100,100 Z")
  * style: CSS style string containing color information
+ * tolerance: Largest distance in path units between a curve and the lines
+ *            it is flattened to, see render_flatten_tolerance()
+ * The path and its geometry share one allocation.
+ * Returns: Pointer to parsed SVGPath structure or NULL on failure
+ */
+SVGPath* parse_svg_path(const char *path_data, const char *style, float tolerance);
+
+/* Parse path data of a given length that need not be NUL terminated
+ * The byte after the data must end a number, like the closing quote of an
+ * attribute in a mapped file.
  * Returns: Pointer to parsed SVGPath structure or NULL on failure
  */
-SVGPath* parse_svg_path(const char *path_data, const char *style);
+SVGPath* parse_svg_path_data(const char *path_data, size_t length, Color fill, float tolerance);
 
-/* Free resources associated with an SVGPath structure */
+/* Count the subpaths and points path data parses into at a tolerance
+ * This walks the data like parsing does without storing anything, so
+ * storage for a path or a whole scene can be allocated at once.
+ */
+void count_svg_path(const char *path_data, size_t length, float tolerance, PathCounts *counts);
+
+/* Parse path data into storage sized by count_svg_path()
+ * svg: Receives the subpaths, which point into the storage
+ * Returns: false if the storage was too small and geometry is missing
+ */
+bool parse_svg_path_into(SVGPath *svg, const char *path_data, size_t length, Color fill, float tolerance,
+                         PathStorage *storage);
+
+/* Free an SVGPath from parse_svg_path() together with its geometry */
 void free_svg_path(SVGPath *path);
 
 /* Parse a color string into a Color structure
- * Supports RGB format (e.g., "rgb(255,0,0)")
+ * Supports RGB format (e.g., "rgb(255,0,0)"), #rrggbb, #rgb, black and white
  */
 Color parse_color(const char *color_str);
 
+/* Parse a color that is the first length bytes of a string, nothing else
+ * Unlike parse_color(), which reads anything else as black, this tells a
+ * typo from a real color, for colors typed on the command line.
+ * Returns: false if it is not one of the forms parse_color() supports
+ */
+bool parse_color_exact(const char *color_str, size_t length, Color *color);
+
 #endif
@@ -1,280 +1,1128 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
 #include "svg_renderer.h"
+#include "resolve.h"
+#include "composite.h"
+#include "prof.h"
 
-#define MAX_INTERSECTIONS 1000
 #define SUBPIXEL_PRECISION 8  // Sub-pixel precision for anti-aliasing
+#define BANDS_PER_THREAD 4    // Bands per render thread, evens out uneven rows
+#define MIN_BAND_ROWS 8       // Smallest band worth handing to another thread
+#define MIN_FILL_RUN 8        // Shortest run of one color written as a fill
+#define ANALYTIC_EPSILON (1.0f / 512)  // Smallest analytic coverage that is drawn
+#define REFERENCE_SAMPLES 64  // Sample lines per row for RENDER_AA_REFERENCE
 
-/* Original SVG dimensions used for scaling calculations */
-static const float BASE_SVG_WIDTH = 2325.72f;
-static const float BASE_SVG_HEIGHT = 274.08f;
+/* Fixed point geometry for RENDER_AA_FIXED
+ * Coordinates and slopes are 16.16 and stepped x positions 32.32, so no
+ * floating point is needed per sample line or pixel. Coverage per sample
+ * line is accumulated in 1/4096 steps. 24.8 coordinates would be enough for
+ * the pixel math, but rounding end points that coarsely moves them across
+ * the 1/8 pixel sample lines and changes whole samples.
+ */
+#define FIX_SHIFT 16
+#define FIX_ONE (1 << FIX_SHIFT)
+#define FIX_SAMPLE_STEP (FIX_ONE / SUBPIXEL_PRECISION)
+#define FIX_COVERAGE_SHIFT 12
+
+/* Path edge in screen space, oriented top to bottom
+ * An edge crosses every sample line y with y_top <= y < y_bottom.
+ * Edges are read-only while rasterizing so bands can share them.
+ */
+typedef struct {
+    float x_top;             // X-coordinate at y_top
+    float y_top;             // Upper end of the edge
+    float y_bottom;          // Lower end of the edge
+    double dxdy;             // X step per unit of y
+    float winding;           // +1 if the path runs down the screen here, -1 if up
+    int32_t fix_x_top;       // x_top, y_top and y_bottom in 16.16 fixed point
+    int32_t fix_y_top;
+    int32_t fix_y_bottom;
+    int64_t fix_dxdy;        // dxdy in 16.16 fixed point, steep edges need more bits
+} Edge;
+
+/* Edge crossing the current row or sample line */
+typedef struct {
+    const Edge *edge;
+    union {
+        double x;            // X-coordinate at the current sample line, stepped
+                             // incrementally so it needs the extra precision
+        int64_t fix_x;       // The same in 32.32 fixed point for RENDER_AA_FIXED
+    };
+} ActiveEdge;
+
+/* Active edge table over a y-sorted edge array, one per band */
+typedef struct {
+    const Edge *edges;       // All edges sorted by y_top
+    uint32_t num_edges;
+    uint32_t next_edge;      // First edge not yet activated
+    ActiveEdge *active;      // Edges crossing the current row or sample line
+    uint32_t num_active;
+    FillRule fill_rule;      // Which winding counts are inside the path
+} EdgeTable;
+
+/* Row scratch buffers shared by the rasterizers and all paths of a scene */
+typedef struct {
+    float *coverage;         // Coverage per pixel of the current row and path
+    float *cells;            // Signed area deltas for the analytic rasterizer
+    int32_t *fix_coverage;   // Coverage for RENDER_AA_FIXED, RESOLVE_FIXED_ONE is full
+    uint8_t *quantized;      // 8-bit coverage of the current path for compositing
+    uint32_t *colors;        // Premultiplied scene colors of the current row, 0 if undrawn
+    uint8_t *alpha;          // Scene alpha of the current row, 0 if undrawn
+    int x_min, x_max;        // Pixels of the row with coverage, x_min > x_max if none
+} RowBuffers;
+
+/* Scene path in screen space */
+typedef struct {
+    const Edge *edges;       // Edges of this path sorted by y_top
+    uint32_t num_edges;
+    int y_start, y_end;      // Rows the path can touch, y_end inclusive
+    uint32_t fill_color;     // 0xRRGGBB
+    FillRule fill_rule;
+} ScenePath;
+
+/* Scratch memory of one render thread */
+typedef struct {
+    RowBuffers row;
+    ActiveEdge *active;      // Active edges of all paths, sliced per path
+    EdgeTable *tables;       // Active edge table per path
+} RenderScratch;
 
-/* Structure to track path intersections with scanlines */
+/* A scene split into bands of rows, rasterized as thread pool tasks
+ * Every band sweeps its rows once for all paths, writes disjoint rows and
+ * records the area it drew. The damage is reported once all bands are joined.
+ */
+typedef struct {
+    Framebuffer *fb;
+    const ScenePath *paths;
+    uint32_t num_paths;
+    RenderAA aa;
+    bool linear_blend;
+    const ResolveKernel *resolve;
+    int width;
+    int y_start, y_end;      // Rows to render, y_end inclusive
+    int band_rows;
+    RenderScratch *scratch;  // One per thread
+    FbRect *drawn;           // One per band
+} RenderJob;
+
+/* Mapping from SVG coordinates to the screen
+ * Points are scaled and offset into the upright picture first, then turned
+ * clockwise onto the panel for geometry rotation.
+ */
 typedef struct {
-    float x;                 // Floating-point X-coordinate of intersection
-    bool is_hole_edge;       // Whether this intersection is from a hole
-} Intersection;
-
-/* Pre-calculated cosine values for common rotation angles */
-static const float rotation_cos[] = {
-    1.0f,   // 0 degrees
-    0.0f,   // 90 degrees
-    -1.0f,  // 180 degrees
-    0.0f    // 270 degrees
-};
-
-/* Pre-calculated sine values for common rotation angles */
-static const float rotation_sin[] = {
-    0.0f,   // 0 degrees
-    1.0f,   // 90 degrees
-    0.0f,   // 180 degrees
-    -1.0f   // 270 degrees
-};
-
-/* Comparison function for sorting intersections by x-coordinate */
-static int compare_intersections(const void *a, const void *b) {
-    float diff = ((Intersection*)a)->x - ((Intersection*)b)->x;
+    float scale;
+    float offset_x, offset_y;
+    int turns;                // Quarter turns clockwise, 0 to 3
+    float logical_width;      // Size of the upright picture
+    float logical_height;
+} Transform;
+
+/* Map a point from SVG coordinates to the screen */
+static inline Point transform_point(const Transform *t, Point p) {
+    Point l = { p.x * t->scale + t->offset_x, p.y * t->scale + t->offset_y };
+
+    switch (t->turns) {
+        case 1: return (Point){ t->logical_height - l.y, l.x };
+        case 2: return (Point){ t->logical_width - l.x, t->logical_height - l.y };
+        case 3: return (Point){ l.y, t->logical_width - l.x };
+        default: return l;
+    }
+}
+
+/* Divide rounding to the nearest integer, the divisor is not zero */
+static inline int64_t fix_div_round(int64_t n, int64_t d) {
+    if (d < 0) {
+        n = -n;
+        d = -d;
+    }
+    return (n >= 0) ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+/* Comparison function for sorting edges by their upper end */
+static int compare_edges(const void *a, const void *b) {
+    float diff = ((const Edge*)a)->y_top - ((const Edge*)b)->y_top;
     return (diff < 0) ? -1 : (diff > 0) ? 1 : 0;
 }
 
-/* Calculate bounding box of SVG path */
-static void calculate_svg_bounds(SVGPath *svg, float *min_x, float *max_x, float *min_y, float *max_y) {
-    *min_x = *min_y = 1e6f;
-    *max_x = *max_y = -1e6f;
+/* Number of edges a path can have at most, one per point */
+static uint32_t count_path_edges(const SVGPath *svg) {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < svg->num_paths; i++) {
+        total += svg->paths[i].num_points;
+    }
+    return total;
+}
+
+/* Build the edge table of a path in screen space, sorted by y_top
+ * Horizontal edges never cross a sample line and are dropped.
+ * edges: Room for count_path_edges() entries
+ * min_y/max_y receive the vertical screen extent of all points.
+ * Returns: Number of edges stored
+ */
+static uint32_t build_edge_table(const SVGPath *svg, const Transform *t, Edge *edges,
+                                 float *min_y, float *max_y) {
+    *min_y = 1e6f;
+    *max_y = -1e6f;
 
+    uint32_t count = 0;
     for (uint32_t i = 0; i < svg->num_paths; i++) {
-        Path *path = &svg->paths[i];
+        const Path *path = &svg->paths[i];
+
+        // Every subpath keeps the direction it was drawn in, the fill rule
+        // turns the winding count into inside and outside
         for (uint32_t j = 0; j < path->num_points; j++) {
-            if (path->points[j].x < *min_x) *min_x = path->points[j].x;
-            if (path->points[j].x > *max_x) *max_x = path->points[j].x;
-            if (path->points[j].y < *min_y) *min_y = path->points[j].y;
-            if (path->points[j].y > *max_y) *max_y = path->points[j].y;
+            uint32_t k = (j + 1) % path->num_points;
+
+            Point p1 = transform_point(t, path->points[j]);
+            Point p2 = transform_point(t, path->points[k]);
+            float x1 = p1.x, y1 = p1.y;
+            float x2 = p2.x, y2 = p2.y;
+
+            if (y1 < *min_y) *min_y = y1;
+            if (y1 > *max_y) *max_y = y1;
+
+            if (y1 == y2) {
+                continue;
+            }
+
+            Edge *e = &edges[count++];
+            if (y1 < y2) {
+                e->x_top = x1;
+                e->y_top = y1;
+                e->y_bottom = y2;
+                e->winding = 1.0f;
+            } else {
+                e->x_top = x2;
+                e->y_top = y2;
+                e->y_bottom = y1;
+                e->winding = -1.0f;
+            }
+            e->dxdy = (double)(x2 - x1) / (y2 - y1);
+
+            // Fixed point copy from the rounded end points, an edge that
+            // rounds to zero height never crosses a sample line
+            int32_t fix_x1 = (int32_t)lrintf(x1 * FIX_ONE), fix_y1 = (int32_t)lrintf(y1 * FIX_ONE);
+            int32_t fix_x2 = (int32_t)lrintf(x2 * FIX_ONE), fix_y2 = (int32_t)lrintf(y2 * FIX_ONE);
+            e->fix_x_top = (y1 < y2) ? fix_x1 : fix_x2;
+            e->fix_y_top = (y1 < y2) ? fix_y1 : fix_y2;
+            e->fix_y_bottom = (y1 < y2) ? fix_y2 : fix_y1;
+            e->fix_dxdy = (fix_y1 == fix_y2) ? 0 : fix_div_round((int64_t)(fix_x2 - fix_x1) << FIX_SHIFT,
+                                                                 fix_y2 - fix_y1);
         }
     }
+
+    qsort(edges, count, sizeof(Edge), compare_edges);
+    return count;
 }
 
-/* Rotate an SVG path by a specified angle
- * Uses pre-calculated sine and cosine values for efficiency
+/* Drop edges that end at or above y and activate those starting above limit
+ * Newly activated edges get their x at sample line y.
  */
-void rotate_svg_path(SVGPath *svg, int angle) {
-    // Calculate center of rotation based on original SVG dimensions
-    float center_x = BASE_SVG_WIDTH / 2.0f;
-    float center_y = BASE_SVG_HEIGHT / 2.0f;
+static void update_active_edges(EdgeTable *table, float y, float limit) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < table->num_active; i++) {
+        if (table->active[i].edge->y_bottom > y) {
+            table->active[kept++] = table->active[i];
+        }
+    }
+    table->num_active = kept;
+
+    while (table->next_edge < table->num_edges && table->edges[table->next_edge].y_top < limit) {
+        const Edge *e = &table->edges[table->next_edge++];
+        if (e->y_bottom > y) {
+            ActiveEdge *a = &table->active[table->num_active++];
+            a->edge = e;
+            a->x = e->x_top + (y - e->y_top) * e->dxdy;
+        }
+    }
+}
 
-    int angle_index = (angle / 90) % 4;
-    float cos_angle = rotation_cos[angle_index];
-    float sin_angle = rotation_sin[angle_index];
+/* Whether a winding count is inside a path under its fill rule */
+static inline bool winding_inside(int winding, FillRule rule) {
+    return (rule == FILL_EVENODD) ? (winding & 1) != 0 : winding != 0;
+}
 
-    // Rotate each point in each path
-    for (uint32_t i = 0; i < svg->num_paths; i++) {
-        Path *path = &svg->paths[i];
-        for (uint32_t j = 0; j < path->num_points; j++) {
-            // Translate to origin
-            float x = path->points[j].x - center_x;
-            float y = path->points[j].y - center_y;
+/* Coverage of a pixel from its accumulated signed area under a fill rule
+ * The area is the winding count averaged over the pixel, so nonzero takes
+ * its magnitude and even-odd folds it back at every odd count.
+ */
+static inline float fold_coverage(float area, FillRule rule) {
+    float c = fabsf(area);
+    if (c > 1.0f) {
+        if (rule == FILL_EVENODD) {
+            c = fmodf(c, 2.0f);
+            c = (c > 1.0f) ? 2.0f - c : c;
+        } else {
+            c = 1.0f;
+        }
+    }
+    return c;
+}
+
+/* Widen the range of pixels with coverage in the current row */
+static inline void mark_row_range(RowBuffers *row, int x_start, int x_end) {
+    if (x_start < row->x_min) row->x_min = x_start;
+    if (x_end > row->x_max) row->x_max = x_end;
+}
+
+/* Accumulate coverage of one row with SUBPIXEL_PRECISION sample lines
+ * Spans between sorted intersections are filled where the winding count is
+ * inside under the path's fill rule, plus a horizontal estimate at span ends.
+ */
+static void rasterize_row_supersample(EdgeTable *table, RowBuffers *row, int y, int width) {
+    for (int subpixel = 0; subpixel < SUBPIXEL_PRECISION; subpixel++) {
+        float subpixel_y = y + (float)subpixel / SUBPIXEL_PRECISION;
+
+        // Step edges that stay active to this sample line. The first line of
+        // each row starts from the exact position so every row comes out the
+        // same no matter which band it is rendered in.
+        for (uint32_t i = 0; i < table->num_active; i++) {
+            ActiveEdge *a = &table->active[i];
+            if (subpixel == 0) {
+                a->x = a->edge->x_top + (subpixel_y - a->edge->y_top) * a->edge->dxdy;
+            } else {
+                a->x += a->edge->dxdy * (1.0 / SUBPIXEL_PRECISION);
+            }
+        }
+
+        // Retire finished edges and activate those starting at or above this line
+        update_active_edges(table, subpixel_y, nextafterf(subpixel_y, INFINITY));
+
+        // The list is nearly sorted from the previous line, insertion sort is linear
+        ActiveEdge *active = table->active;
+        uint32_t num_active = table->num_active;
+        for (uint32_t i = 1; i < num_active; i++) {
+            ActiveEdge a = active[i];
+            uint32_t j = i;
+            while (j > 0 && active[j - 1].x > a.x) {
+                active[j] = active[j - 1];
+                j--;
+            }
+            active[j] = a;
+        }
+        PROF_COUNT(PROF_INTERSECTIONS, num_active);
+
+        // Accumulate coverage between pairs of intersections
+        int winding = 0;
+        for (uint32_t i = 0; i + 1 < num_active; i++) {
+            winding += (int)active[i].edge->winding;
+            if (!winding_inside(winding, table->fill_rule)) {
+                continue;
+            }
+
+            float x_start = (float)active[i].x;
+            float x_end = (float)active[i + 1].x;
+
+            // Pixels the span reaches into, the one holding x_end is the last
+            int ix_start = (int)floorf(x_start);
+            int ix_end = (int)ceilf(x_end) - 1;
+
+            // Clip to screen bounds
+            if (ix_start < 0) ix_start = 0;
+            if (ix_end >= width) ix_end = width - 1;
+            if (ix_start > ix_end) continue;
+
+            mark_row_range(row, ix_start, ix_end);
 
-            // Rotate
-            float new_x = x * cos_angle - y * sin_angle;
-            float new_y = x * sin_angle + y * cos_angle;
+            // Accumulate coverage for each pixel
+            for (int x = ix_start; x <= ix_end; x++) {
+                float pixel_coverage = 1.0f;
 
-            // Translate back
-            path->points[j].x = new_x + center_x;
-            path->points[j].y = new_y + center_y;
+                // Take off the parts of the pixel left of x_start and right of
+                // x_end, a span inside one pixel keeps x_end - x_start
+                if (x == ix_start && x_start > x) {
+                    pixel_coverage -= x_start - x;
+                }
+                if (x == ix_end && x_end < x + 1) {
+                    pixel_coverage -= (x + 1) - x_end;
+                }
+
+                row->coverage[x] += pixel_coverage / SUBPIXEL_PRECISION;
+            }
         }
     }
 }
 
-/* Enhanced color blending for vibrant anti-aliasing
- * Maintains color saturation while blending with black background
+/* Accumulate coverage of one row for RENDER_AA_REFERENCE
+ * Sample lines run through the middle of REFERENCE_SAMPLES equal slices of
+ * the row, edge positions are computed afresh on each and every span adds
+ * its exact overlap with each pixel. Same fill rule as the supersampler.
  */
-static uint32_t blend_color_vibrant(uint32_t color, float alpha) {
-    // Extract RGB components
-    uint8_t r = (color >> 16) & 0xFF;
-    uint8_t g = (color >> 8) & 0xFF;
-    uint8_t b = color & 0xFF;
+static void rasterize_row_reference(EdgeTable *table, RowBuffers *row, int y, int width) {
+    for (int sample = 0; sample < REFERENCE_SAMPLES; sample++) {
+        float sample_y = y + (sample + 0.5f) / REFERENCE_SAMPLES;
+        update_active_edges(table, sample_y, nextafterf(sample_y, INFINITY));
 
-    // Adjust alpha to maintain color vibrancy at edges
-    // We use a non-linear alpha curve that preserves more of the original color
-    alpha = alpha < 0.5f ? 2.0f * alpha * alpha : 1.0f - 2.0f * (1.0f - alpha) * (1.0f - alpha);
+        ActiveEdge *active = table->active;
+        uint32_t num_active = table->num_active;
+        for (uint32_t i = 0; i < num_active; i++) {
+            active[i].x = active[i].edge->x_top + (sample_y - active[i].edge->y_top) * active[i].edge->dxdy;
+        }
+        for (uint32_t i = 1; i < num_active; i++) {
+            ActiveEdge a = active[i];
+            uint32_t j = i;
+            while (j > 0 && active[j - 1].x > a.x) {
+                active[j] = active[j - 1];
+                j--;
+            }
+            active[j] = a;
+        }
+
+        int winding = 0;
+        for (uint32_t i = 0; i + 1 < num_active; i++) {
+            winding += (int)active[i].edge->winding;
+            if (!winding_inside(winding, table->fill_rule)) {
+                continue;
+            }
 
-    // Convert back to integer color value (blending with black background)
-    uint8_t new_r = (uint8_t)(r * alpha);
-    uint8_t new_g = (uint8_t)(g * alpha);
-    uint8_t new_b = (uint8_t)(b * alpha);
+            double x_start = (active[i].x > 0) ? active[i].x : 0;
+            double x_end = (active[i + 1].x < width) ? active[i + 1].x : width;
+            if (x_end <= x_start) {
+                continue;
+            }
 
-    return (new_r << 16) | (new_g << 8) | new_b;
+            int ix_start = (int)x_start;
+            int ix_end = (int)ceil(x_end) - 1;
+            mark_row_range(row, ix_start, ix_end);
+            for (int x = ix_start; x <= ix_end; x++) {
+                double left = (x > x_start) ? x : x_start;
+                double right = (x + 1 < x_end) ? x + 1 : x_end;
+                row->coverage[x] += (float)((right - left) / REFERENCE_SAMPLES);
+            }
+        }
+    }
 }
 
-/* Render a path including holes using scanline algorithm with anti-aliasing */
-static void render_path(Framebuffer *fb, SVGPath *svg, DisplayInfo *display_info) {
-    float min_x, max_x, min_y, max_y;
-    calculate_svg_bounds(svg, &min_x, &max_x, &min_y, &max_y);
+/* X of an edge at sample line y in 32.32 fixed point, y in 16.16 */
+static inline int64_t edge_fix_x(const Edge *e, int32_t y) {
+    return ((int64_t)e->fix_x_top << FIX_SHIFT) + (int64_t)(y - e->fix_y_top) * e->fix_dxdy;
+}
 
-    // Calculate scaling to maintain aspect ratio
-    float scale_x = (float)display_info->svg_width / BASE_SVG_WIDTH;
-    float scale_y = (float)display_info->svg_height / BASE_SVG_HEIGHT;
-    float scale = (scale_x < scale_y) ? scale_x : scale_y;
+/* Drop edges that end at or above sample line y and activate those crossing it
+ * Fixed point version of update_active_edges(), y in 16.16
+ */
+static void update_active_edges_fixed(EdgeTable *table, int32_t y) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < table->num_active; i++) {
+        if (table->active[i].edge->fix_y_bottom > y) {
+            table->active[kept++] = table->active[i];
+        }
+    }
+    table->num_active = kept;
 
-    // Calculate centering offsets
-    float offset_x = display_info->x_offset;
-    float offset_y = display_info->y_offset;
-
-    // Adjust offset to center the scaled SVG
-    offset_x += (display_info->svg_width - (BASE_SVG_WIDTH * scale)) / 2;
-    offset_y += (display_info->svg_height - (BASE_SVG_HEIGHT * scale)) / 2;
-
-    // Calculate screen space bounds with some padding for anti-aliasing
-    int screen_min_y = (int)((min_y * scale + offset_y) - 1);
-    int screen_max_y = (int)((max_y * scale + offset_y) + 1);
-
-    // Clip to screen bounds
-    if (screen_min_y < 0) screen_min_y = 0;
-    if (screen_max_y >= (int)fb->vinfo.yres) screen_max_y = fb->vinfo.yres - 1;
-
-    // Allocate intersection array
-    Intersection *intersections = malloc(MAX_INTERSECTIONS * sizeof(Intersection));
-    if (!intersections) return;
-
-    // Convert color components to 32-bit color
-    uint32_t fill_color = (svg->fill_color.r << 16) |
-                         (svg->fill_color.g << 8) |
-                          svg->fill_color.b;
-
-    // Create a temporary buffer to track pixel coverage
-    float *coverage_buffer = calloc(fb->vinfo.xres, sizeof(float));
-    if (!coverage_buffer) {
-        free(intersections);
-        return;
+    while (table->next_edge < table->num_edges && table->edges[table->next_edge].fix_y_top <= y) {
+        const Edge *e = &table->edges[table->next_edge++];
+        if (e->fix_y_bottom > y) {
+            ActiveEdge *a = &table->active[table->num_active++];
+            a->edge = e;
+            a->fix_x = edge_fix_x(e, y);
+        }
     }
+}
 
-    // Process each scanline with subpixel precision for anti-aliasing
-    for (int y = screen_min_y; y <= screen_max_y; y++) {
-        // Clear coverage buffer for the current scanline
-        memset(coverage_buffer, 0, fb->vinfo.xres * sizeof(float));
-
-        // Process multiple subpixel scanlines for anti-aliasing
-        for (int subpixel = 0; subpixel < SUBPIXEL_PRECISION; subpixel++) {
-            float subpixel_y = y + (float)subpixel / SUBPIXEL_PRECISION;
-            int num_intersections = 0;
-
-            // Find intersections with all path segments
-            for (uint32_t i = 0; i < svg->num_paths; i++) {
-                Path *path = &svg->paths[i];
-                for (uint32_t j = 0; j < path->num_points; j++) {
-                    uint32_t k = (j + 1) % path->num_points;
-
-                    float y1 = path->points[j].y * scale + offset_y;
-                    float y2 = path->points[k].y * scale + offset_y;
-
-                    // Check if segment crosses current scanline
-                    if ((y1 <= subpixel_y && y2 > subpixel_y) || (y2 <= subpixel_y && y1 > subpixel_y)) {
-                        float x1 = path->points[j].x * scale + offset_x;
-                        float x2 = path->points[k].x * scale + offset_x;
-
-                        if (num_intersections < MAX_INTERSECTIONS) {
-                            float x;
-                            if (y1 == y2) {
-                                x = x1;
-                            } else {
-                                // Calculate intersection x-coordinate with floating-point precision
-                                x = x1 + (subpixel_y - y1) * (x2 - x1) / (y2 - y1);
-                            }
-
-                            intersections[num_intersections].x = x;
-                            intersections[num_intersections].is_hole_edge = path->is_hole;
-                            num_intersections++;
-                        }
-                    }
-                }
+/* Accumulate coverage of one row with SUBPIXEL_PRECISION sample lines in
+ * fixed point. Same rules as rasterize_row_supersample(), every sample line
+ * adds up to 1 << FIX_COVERAGE_SHIFT per pixel so a fully covered pixel
+ * reaches RESOLVE_FIXED_ONE.
+ */
+static void rasterize_row_fixed(EdgeTable *table, RowBuffers *row, int y, int width) {
+    int32_t *coverage = row->fix_coverage;
+
+    for (int subpixel = 0; subpixel < SUBPIXEL_PRECISION; subpixel++) {
+        int32_t sample_y = (int32_t)((uint32_t)y << FIX_SHIFT) + subpixel * FIX_SAMPLE_STEP;
+
+        // Step edges that stay active to this sample line, exact at the
+        // first line of each row like the float version
+        for (uint32_t i = 0; i < table->num_active; i++) {
+            ActiveEdge *a = &table->active[i];
+            if (subpixel == 0) {
+                a->fix_x = edge_fix_x(a->edge, sample_y);
+            } else {
+                a->fix_x += a->edge->fix_dxdy * FIX_SAMPLE_STEP;
             }
+        }
+
+        update_active_edges_fixed(table, sample_y);
+
+        // The list is nearly sorted from the previous line, insertion sort is linear
+        ActiveEdge *active = table->active;
+        uint32_t num_active = table->num_active;
+        for (uint32_t i = 1; i < num_active; i++) {
+            ActiveEdge a = active[i];
+            uint32_t j = i;
+            while (j > 0 && active[j - 1].fix_x > a.fix_x) {
+                active[j] = active[j - 1];
+                j--;
+            }
+            active[j] = a;
+        }
+        PROF_COUNT(PROF_INTERSECTIONS, num_active);
+
+        int winding = 0;
+        for (uint32_t i = 0; i + 1 < num_active; i++) {
+            winding += (int)active[i].edge->winding;
+            if (!winding_inside(winding, table->fill_rule)) {
+                continue;
+            }
+
+            // Round the 32.32 positions to 16.16
+            int64_t x_start = (active[i].fix_x + (FIX_ONE / 2)) >> FIX_SHIFT;
+            int64_t x_end = (active[i + 1].fix_x + (FIX_ONE / 2)) >> FIX_SHIFT;
+
+            // Pixels the span reaches into, the one holding x_end is the last
+            int ix_start = (int)(x_start >> FIX_SHIFT);
+            int ix_end = (int)((x_end + FIX_ONE - 1) >> FIX_SHIFT) - 1;
+
+            // Clip to screen bounds
+            if (ix_start < 0) ix_start = 0;
+            if (ix_end >= width) ix_end = width - 1;
+            if (ix_start > ix_end) continue;
 
-            if (num_intersections > 0) {
-                // Sort intersections by x-coordinate
-                qsort(intersections, num_intersections, sizeof(Intersection), compare_intersections);
-
-                bool inside_main = false;
-                bool inside_hole = false;
-
-                // Accumulate coverage between pairs of intersections
-                for (int i = 0; i < num_intersections - 1; i++) {
-                    if (intersections[i].is_hole_edge) {
-                        inside_hole = !inside_hole;
-                    } else {
-                        inside_main = !inside_main;
-                    }
-
-                    // Only fill if inside main path and not inside hole
-                    if (inside_main && !inside_hole) {
-                        float x_start = intersections[i].x;
-                        float x_end = intersections[i + 1].x;
-
-                        // Process each pixel with anti-aliasing
-                        int ix_start = (int)floorf(x_start);
-                        int ix_end = (int)ceilf(x_end);
-
-                        // Clip to screen bounds
-                        if (ix_start < 0) ix_start = 0;
-                        if (ix_end >= (int)fb->vinfo.xres) ix_end = fb->vinfo.xres - 1;
-
-                        // Accumulate coverage for each pixel
-                        for (int x = ix_start; x <= ix_end; x++) {
-                            float pixel_coverage = 1.0f;
-
-                            // Calculate coverage for left edge
-                            if (x == ix_start && x_start > ix_start) {
-                                pixel_coverage *= (1.0f - (x_start - ix_start));
-                            }
-
-                            // Calculate coverage for right edge
-                            if (x == ix_end && x_end < ix_end + 1) {
-                                pixel_coverage *= (x_end - ix_end);
-                            }
-
-                            // Accumulate coverage
-                            coverage_buffer[x] += pixel_coverage / SUBPIXEL_PRECISION;
-                        }
-                    }
+            mark_row_range(row, ix_start, ix_end);
+
+            for (int x = ix_start; x <= ix_end; x++) {
+                int64_t pixel_coverage = FIX_ONE;
+                int64_t pixel_left = (int64_t)x << FIX_SHIFT;
+
+                // Partial coverage at the left and right edges
+                if (x == ix_start && x_start > pixel_left) {
+                    pixel_coverage -= x_start - pixel_left;
+                }
+                if (x == ix_end && x_end < pixel_left + FIX_ONE) {
+                    pixel_coverage -= pixel_left + FIX_ONE - x_end;
                 }
+
+                coverage[x] += (int32_t)(pixel_coverage >> (FIX_SHIFT - FIX_COVERAGE_SHIFT));
+            }
+        }
+    }
+}
+
+/* Add the signed area of a line segment inside one row to the cell deltas
+ * y0 and y1 are relative to the top of the row in [0, 1], dir is the winding.
+ * Each cell receives the area covered inside it, the remainder of the
+ * segment's height carries over to the cell to its right, so a prefix sum
+ * over the cells yields exact coverage.
+ */
+static void accumulate_line(RowBuffers *row, float x0, float y0, float x1, float y1,
+                            float dir, int width) {
+    float d = (y1 - y0) * dir;
+    if (d == 0.0f) {
+        return;
+    }
+
+    // Clamp to the row, coverage left of the screen collapses onto x = 0
+    if (x0 < 0.0f) x0 = 0.0f;
+    if (x1 < 0.0f) x1 = 0.0f;
+    if (x0 > width) x0 = (float)width;
+    if (x1 > width) x1 = (float)width;
+
+    float x_left = (x0 < x1) ? x0 : x1;
+    float x_right = (x0 < x1) ? x1 : x0;
+    float left_floor = floorf(x_left);
+    float right_ceil = ceilf(x_right);
+    int ix_left = (int)left_floor;
+    int ix_right = (int)right_ceil;
+    float *cells = row->cells;
+
+    if (ix_right <= ix_left + 1) {
+        // The segment stays within one pixel column
+        float x_mid = 0.5f * (x0 + x1) - left_floor;
+        cells[ix_left] += d - d * x_mid;
+        cells[ix_left + 1] += d * x_mid;
+        ix_right = ix_left + 1;
+    } else {
+        // Spread the area over the columns the segment crosses
+        float inv = 1.0f / (x_right - x_left);
+        float left_frac = x_left - left_floor;
+        float area_first = 0.5f * inv * (1.0f - left_frac) * (1.0f - left_frac);
+        float right_frac = x_right - right_ceil + 1.0f;
+        float area_last = 0.5f * inv * right_frac * right_frac;
+
+        cells[ix_left] += d * area_first;
+        if (ix_right == ix_left + 2) {
+            cells[ix_left + 1] += d * (1.0f - area_first - area_last);
+        } else {
+            float area_second = inv * (1.5f - left_frac);
+            cells[ix_left + 1] += d * (area_second - area_first);
+            for (int x = ix_left + 2; x < ix_right - 1; x++) {
+                cells[x] += d * inv;
             }
+            float area_before_last = area_second + (ix_right - ix_left - 3) * inv;
+            cells[ix_right - 1] += d * (1.0f - area_before_last - area_last);
         }
+        cells[ix_right] += d * area_last;
+    }
 
-        // Render the scanline using the accumulated coverage
-        for (uint32_t x = 0; x < fb->vinfo.xres; x++) {
-            if (coverage_buffer[x] > 0.0f) {
-                // Clamp coverage to [0, 1]
-                if (coverage_buffer[x] > 1.0f) coverage_buffer[x] = 1.0f;
-
-                // If coverage is very high (interior of shape), use original color
-                if (coverage_buffer[x] > 0.98f) {
-                    set_pixel(fb, x, y, fill_color);
-                } else {
-                    // For edges, use vibrant color blending
-                    uint32_t aa_color = blend_color_vibrant(fill_color, coverage_buffer[x]);
-                    set_pixel(fb, x, y, aa_color);
+    mark_row_range(row, ix_left, ix_right);
+}
+
+/* Compute exact area coverage of one row in a single pass
+ * Every active edge deposits its signed area into the cell deltas, a prefix
+ * sum then turns them into the winding count averaged over each pixel,
+ * which the fill rule folds into coverage.
+ */
+static void rasterize_row_analytic(EdgeTable *table, RowBuffers *row, int y, int width) {
+    float row_top = (float)y;
+    float row_bottom = (float)(y + 1);
+
+    update_active_edges(table, row_top, row_bottom);
+
+    for (uint32_t i = 0; i < table->num_active; i++) {
+        const Edge *e = table->active[i].edge;
+        float y0 = (e->y_top > row_top) ? e->y_top : row_top;
+        float y1 = (e->y_bottom < row_bottom) ? e->y_bottom : row_bottom;
+        float x0 = e->x_top + (y0 - e->y_top) * (float)e->dxdy;
+        float x1 = e->x_top + (y1 - e->y_top) * (float)e->dxdy;
+        accumulate_line(row, x0, y0 - row_top, x1, y1 - row_top, e->winding, width);
+    }
+
+    if (row->x_min > row->x_max) {
+        return;
+    }
+
+    // Integrate the deltas, cells past the last touched one are all zero
+    float sum = 0.0f;
+    for (int x = row->x_min; x <= row->x_max; x++) {
+        sum += row->cells[x];
+        row->cells[x] = 0.0f;
+        if (x >= width) {
+            continue;
+        }
+
+        // Round-off below one 8-bit step is treated as no coverage
+        float c = fold_coverage(sum, table->fill_rule);
+        if (c < ANALYTIC_EPSILON) c = 0.0f;
+        row->coverage[x] = c;
+    }
+    if (row->x_max >= width) {
+        row->x_max = width - 1;
+    }
+}
+
+/* Composite a path's coverage over the scene row
+ * Coverage is quantized to 8 bits, then the path goes over what earlier
+ * paths left in the row. The coverage buffer is left clear for the next path.
+ */
+static inline void composite_row(const ResolveKernel *kernel, RowBuffers *row, uint32_t fill_color,
+                                 RenderAA aa) {
+    uint32_t count = (uint32_t)(row->x_max - row->x_min + 1);
+    uint8_t *quantized = row->quantized + row->x_min;
+    if (aa == RENDER_AA_FIXED) {
+        resolve_fixed(row->fix_coverage + row->x_min, quantized, count);
+    } else {
+        kernel->resolve(row->coverage + row->x_min, quantized, count);
+    }
+    composite_span(quantized, row->colors + row->x_min, row->alpha + row->x_min, count, fill_color);
+}
+
+/* Write the composited scene row, each drawn pixel once
+ * Opaque pixels are stored as they are, with long runs of one color going to
+ * the fill kernel. Partly covered ones are put over the pixels below, which
+ * hold the background. Pixels go straight to the pixel format kernels, the
+ * range is already on screen and the caller reports the damage.
+ */
+static void write_row(Framebuffer *fb, RowBuffers *row, int x_min, int x_max, int y, bool linear_blend) {
+    const PixelFormat *fmt = &fb->format;
+    const uint32_t *colors = row->colors;
+    const uint8_t *alpha = row->alpha;
+    int x = x_min;
+
+    while (x <= x_max) {
+        if (alpha[x] == 0) {
+            x++;
+            continue;
+        }
+
+        int start = x;
+        if (alpha[x] != 255) {
+            while (x <= x_max && alpha[x] != 0 && alpha[x] != 255) x++;
+            if (linear_blend) {
+                fmt->over_linear(fmt, fb_pixel_address(fb, start, y), colors + start, alpha + start, x - start);
+            } else {
+                fmt->over(fmt, fb_pixel_address(fb, start, y), colors + start, alpha + start, x - start);
+            }
+            PROF_COUNT(PROF_PIXELS, x - start);
+            continue;
+        }
+
+        while (x <= x_max && alpha[x] == 255) {
+            int run = x + 1;
+            while (run <= x_max && alpha[run] == 255 && colors[run] == colors[x]) run++;
+
+            if (run - x >= MIN_FILL_RUN) {
+                if (x > start) {
+                    fmt->store(fmt, fb_pixel_address(fb, start, y), colors + start, x - start);
                 }
+                fmt->fill(fb_pixel_address(fb, x, y), pixel_pack(fmt, colors[x]), run - x);
+                PROF_COUNT(PROF_PIXELS, run - start);
+                start = run;
             }
+            x = run;
+        }
+        if (x > start) {
+            fmt->store(fmt, fb_pixel_address(fb, start, y), colors + start, x - start);
+            PROF_COUNT(PROF_PIXELS, x - start);
         }
     }
 
-    // Clean up
-    free(coverage_buffer);
-    free(intersections);
+    // Leave the row empty for the next one
+    memset(row->colors + x_min, 0, (x_max - x_min + 1) * sizeof(uint32_t));
+    memset(row->alpha + x_min, 0, x_max - x_min + 1);
 }
 
-/* Render an SVG path to the framebuffer with anti-aliasing */
-void render_svg_path(Framebuffer *fb, SVGPath *svg, DisplayInfo *display_info) {
-    static bool first_path = true;
-
-    // Clear screen before rendering first path
-    if (first_path) {
-        for (uint32_t y = 0; y < fb->vinfo.yres; y++) {
-            for (uint32_t x = 0; x < fb->vinfo.xres; x++) {
-                set_pixel(fb, x, y, 0x00000000);
+/* Quarter turns of a rotation in degrees */
+static inline int rotation_turns(const RenderOptions *options) {
+    return (options->rotation / 90) % 4;
+}
+
+/* Size of the upright picture, the panel size turned for 90 and 270 degrees */
+static void logical_size(const Framebuffer *fb, int turns, uint32_t *width, uint32_t *height) {
+    *width = (turns & 1) ? fb->vinfo.yres : fb->vinfo.xres;
+    *height = (turns & 1) ? fb->vinfo.xres : fb->vinfo.yres;
+}
+
+/* Scale from SVG coordinates to pixels, keeping the aspect ratio */
+static float layout_scale(const DisplayInfo *display_info) {
+    float scale_x = (float)display_info->svg_width / display_info->view_box.width;
+    float scale_y = (float)display_info->svg_height / display_info->view_box.height;
+    return (scale_x < scale_y) ? scale_x : scale_y;
+}
+
+/* Curve flattening tolerance in path units for a layout */
+float render_flatten_tolerance(const DisplayInfo *display_info) {
+    float scale = layout_scale(display_info);
+    return (scale > 0) ? RENDER_FLATTEN_TOLERANCE / scale : RENDER_FLATTEN_TOLERANCE;
+}
+
+/* Set up the mapping from SVG coordinates to the screen
+ * turns: Quarter turns applied to the geometry, 0 maps into the upright picture
+ */
+static void setup_transform(Transform *t, const Framebuffer *fb, const DisplayInfo *display_info,
+                            const RenderOptions *options, int turns) {
+    memset(t, 0, sizeof(*t));
+
+    uint32_t width, height;
+    logical_size(fb, rotation_turns(options), &width, &height);
+    t->turns = turns;
+    t->logical_width = (float)width;
+    t->logical_height = (float)height;
+
+    t->scale = layout_scale(display_info);
+
+    // Calculate centering offsets
+    t->offset_x = display_info->x_offset;
+    t->offset_y = display_info->y_offset;
+
+    // Adjust offset to center the scaled view box
+    const ViewBox *view_box = &display_info->view_box;
+    t->offset_x += (display_info->svg_width - (view_box->width * t->scale)) / 2 - view_box->x * t->scale;
+    t->offset_y += (display_info->svg_height - (view_box->height * t->scale)) / 2 - view_box->y * t->scale;
+}
+
+/* Whether an edge ends at or above row y, so it can never become active */
+static inline bool edge_ends_above(const Edge *e, int y, RenderAA aa) {
+    if (aa == RENDER_AA_FIXED) {
+        return e->fix_y_bottom <= (int32_t)((uint32_t)y << FIX_SHIFT);
+    }
+    return e->y_bottom <= (float)y;
+}
+
+/* Whether an edge starts at or below row y + 1, so it does not touch row y */
+static inline bool edge_starts_below(const Edge *e, int y, RenderAA aa) {
+    if (aa == RENDER_AA_FIXED) {
+        return e->fix_y_top >= (int32_t)((uint32_t)(y + 1) << FIX_SHIFT);
+    }
+    return e->y_top >= (float)(y + 1);
+}
+
+/* Rasterize one band of rows of a scene
+ * Each band walks the shared edges with its own active lists and scratch
+ * buffers, so bands can run on any thread in any order. Within a row all
+ * paths are composited first and the pixels are written once.
+ */
+static void render_band(void *arg, unsigned int band, unsigned int thread) {
+    RenderJob *job = arg;
+    RenderScratch *scratch = &job->scratch[thread];
+    RowBuffers *row = &scratch->row;
+    int width = job->width;
+
+    int band_start = job->y_start + (int)band * job->band_rows;
+    int band_end = band_start + job->band_rows - 1;
+    if (band_end > job->y_end) band_end = job->y_end;
+
+    FbRect *drawn = &job->drawn[band];
+    int x_min = width, x_max = -1, y_min = band_end + 1, y_max = -1;
+
+    // Fresh active edge tables for the band, each path gets its own slice
+    ActiveEdge *active = scratch->active;
+    for (uint32_t i = 0; i < job->num_paths; i++) {
+        const ScenePath *path = &job->paths[i];
+        EdgeTable *table = &scratch->tables[i];
+        EdgeTable fresh = { path->edges, path->num_edges, 0, active, 0, path->fill_rule };
+        *table = fresh;
+        active += path->num_edges;
+
+        // Edges above the first row can never become active
+        while (table->next_edge < table->num_edges &&
+               edge_ends_above(&table->edges[table->next_edge], band_start, job->aa)) {
+            table->next_edge++;
+        }
+    }
+
+    for (int y = band_start; y <= band_end; y++) {
+        int row_min = width, row_max = -1;
+
+        for (uint32_t i = 0; i < job->num_paths; i++) {
+            const ScenePath *path = &job->paths[i];
+            EdgeTable *table = &scratch->tables[i];
+
+            if (y < path->y_start || y > path->y_end) {
+                continue;
+            }
+
+            // Nothing left to draw once all edges are consumed
+            if (table->num_active == 0 && table->next_edge == table->num_edges) {
+                continue;
+            }
+
+            // Skip rows before the next edge starts
+            if (table->num_active == 0 && edge_starts_below(&table->edges[table->next_edge], y, job->aa)) {
+                continue;
             }
+
+            row->x_min = width;
+            row->x_max = -1;
+            uint64_t path_start = prof_enabled ? prof_now() : 0;
+
+            if (job->aa == RENDER_AA_ANALYTIC) {
+                rasterize_row_analytic(table, row, y, width);
+            } else if (job->aa == RENDER_AA_FIXED) {
+                rasterize_row_fixed(table, row, y, width);
+            } else if (job->aa == RENDER_AA_REFERENCE) {
+                rasterize_row_reference(table, row, y, width);
+            } else {
+                rasterize_row_supersample(table, row, y, width);
+            }
+
+            if (row->x_min <= row->x_max) {
+                composite_row(job->resolve, row, path->fill_color, job->aa);
+                if (row->x_min < row_min) row_min = row->x_min;
+                if (row->x_max > row_max) row_max = row->x_max;
+            }
+            if (prof_enabled) {
+                prof_path_add(i, 0, 1, prof_now() - path_start);
+            }
+        }
+
+        if (row_min <= row_max) {
+            write_row(job->fb, row, row_min, row_max, y, job->linear_blend);
+
+            if (row_min < x_min) x_min = row_min;
+            if (row_max > x_max) x_max = row_max;
+            if (y < y_min) y_min = y;
+            y_max = y;
         }
-        first_path = false;
     }
 
-    render_path(fb, svg, display_info);
+    if (x_min <= x_max) {
+        drawn->x0 = (uint32_t)x_min;
+        drawn->x1 = (uint32_t)x_max + 1;
+        drawn->y0 = (uint32_t)y_min;
+        drawn->y1 = (uint32_t)y_max + 1;
+    } else {
+        memset(drawn, 0, sizeof(*drawn));
+    }
+}
+
+/* Free per-thread scratch buffers */
+static void free_scratch(RenderScratch *scratch, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        free(scratch[i].row.alpha);
+        free(scratch[i].row.colors);
+        free(scratch[i].row.quantized);
+        free(scratch[i].row.fix_coverage);
+        free(scratch[i].row.cells);
+        free(scratch[i].row.coverage);
+        free(scratch[i].tables);
+        free(scratch[i].active);
+    }
+    free(scratch);
+}
+
+/* Allocate per-thread scratch buffers
+ * Returns: Array of count entries or NULL on failure
+ */
+static RenderScratch *alloc_scratch(unsigned int count, uint32_t num_paths, uint32_t num_edges,
+                                    int width) {
+    RenderScratch *scratch = calloc(count, sizeof(RenderScratch));
+    if (!scratch) {
+        return NULL;
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        RenderScratch *s = &scratch[i];
+        s->active = malloc((num_edges ? num_edges : 1) * sizeof(ActiveEdge));
+        s->tables = malloc(num_paths * sizeof(EdgeTable));
+
+        // Coverage and cell deltas have a guard entry for the right edge
+        s->row.coverage = calloc(width + 2, sizeof(float));
+        s->row.cells = calloc(width + 2, sizeof(float));
+        s->row.fix_coverage = calloc(width + 2, sizeof(int32_t));
+        s->row.quantized = malloc(width);
+        s->row.colors = calloc(width, sizeof(uint32_t));
+        s->row.alpha = calloc(width, 1);
+
+        if (!s->active || !s->tables || !s->row.coverage || !s->row.cells ||
+            !s->row.fix_coverage || !s->row.quantized || !s->row.colors || !s->row.alpha) {
+            free_scratch(scratch, i + 1);
+            return NULL;
+        }
+    }
+
+    return scratch;
+}
+
+/* Render all paths of a scene in one top to bottom sweep
+ * The rows of the scene are split into bands that run on the thread pool.
+ */
+static void render_paths(Framebuffer *fb, const SVGScene *scene, const Transform *transform,
+                         const RenderOptions *options) {
+    if (scene->num_paths == 0) {
+        return;
+    }
+
+    uint32_t total_edges = 0;
+    for (uint32_t i = 0; i < scene->num_paths; i++) {
+        total_edges += count_path_edges(&scene->paths[i]);
+    }
+
+    Edge *edges = malloc((total_edges ? total_edges : 1) * sizeof(Edge));
+    ScenePath *paths = malloc(scene->num_paths * sizeof(ScenePath));
+    if (!edges || !paths) {
+        fprintf(stderr, "Failed to allocate render buffers\n");
+        free(paths);
+        free(edges);
+        return;
+    }
+
+    // Build the y-sorted edge tables of all paths once, back to back
+    PROF_PHASE_BEGIN(build_start);
+    if (prof_enabled) {
+        prof_paths_reserve(scene->num_paths);
+    }
+    int scene_min_y = (int)fb->vinfo.yres, scene_max_y = -1;
+    uint32_t num_edges = 0;
+    for (uint32_t i = 0; i < scene->num_paths; i++) {
+        const SVGPath *svg = &scene->paths[i];
+        ScenePath *path = &paths[i];
+        float min_y = 0.0f, max_y = 0.0f;
+
+        path->edges = edges + num_edges;
+        path->num_edges = build_edge_table(svg, transform, edges + num_edges, &min_y, &max_y);
+        num_edges += path->num_edges;
+        if (prof_enabled) {
+            prof_path_add(i, path->num_edges, 0, 0);
+        }
+
+        // Convert color components to 32-bit color
+        path->fill_color = (svg->fill_color.r << 16) |
+                           (svg->fill_color.g << 8) |
+                            svg->fill_color.b;
+        path->fill_rule = svg->fill_rule;
+
+        // Calculate screen space bounds with some padding for anti-aliasing
+        path->y_start = (int)(min_y - 1);
+        path->y_end = (int)(max_y + 1);
+
+        // Clip to screen bounds
+        if (path->y_start < 0) path->y_start = 0;
+        if (path->y_end >= (int)fb->vinfo.yres) path->y_end = fb->vinfo.yres - 1;
+        if (path->num_edges == 0 || path->y_start > path->y_end) {
+            continue;
+        }
+
+        if (path->y_start < scene_min_y) scene_min_y = path->y_start;
+        if (path->y_end > scene_max_y) scene_max_y = path->y_end;
+    }
+    PROF_COUNT(PROF_EDGES, num_edges);
+    PROF_PHASE_END(build_start, "edge_build");
+
+    if (scene_min_y > scene_max_y) {
+        free(paths);
+        free(edges);
+        return;
+    }
+
+    int width = (int)fb->vinfo.xres;
+    int rows = scene_max_y - scene_min_y + 1;
+
+    // Enough bands to balance the threads, but none too small to be worth it.
+    // A single band runs inline without waking the workers
+    ThreadPool *pool = options->pool;
+    unsigned int num_bands = thread_pool_size(pool) * BANDS_PER_THREAD;
+    if (num_bands > (unsigned int)(rows / MIN_BAND_ROWS)) num_bands = rows / MIN_BAND_ROWS;
+    if (num_bands <= 1) {
+        num_bands = 1;
+        pool = NULL;
+    }
+    unsigned int threads = thread_pool_size(pool);
+
+    RenderScratch *scratch = alloc_scratch(threads, scene->num_paths, num_edges, width);
+    FbRect *drawn = calloc(num_bands, sizeof(FbRect));
+    if (!scratch || !drawn) {
+        fprintf(stderr, "Failed to allocate render buffers\n");
+        free(drawn);
+        if (scratch) free_scratch(scratch, threads);
+        free(paths);
+        free(edges);
+        return;
+    }
+
+    RenderJob job = {
+        .fb = fb,
+        .paths = paths,
+        .num_paths = scene->num_paths,
+        .aa = options->aa,
+        .linear_blend = options->linear_blend,
+        .resolve = resolve_kernel(),
+        .width = width,
+        .y_start = scene_min_y,
+        .y_end = scene_max_y,
+        .band_rows = (rows + num_bands - 1) / num_bands,
+        .scratch = scratch,
+        .drawn = drawn,
+    };
+
+    PROF_PHASE_BEGIN(raster_start);
+    thread_pool_run(pool, render_band, &job, num_bands);
+    PROF_PHASE_END(raster_start, "raster");
+
+    // Report what the bands drew now that no thread writes anymore
+    for (unsigned int i = 0; i < num_bands; i++) {
+        fb_add_damage(fb, drawn[i].x0, drawn[i].y0,
+                      drawn[i].x1 - drawn[i].x0, drawn[i].y1 - drawn[i].y0);
+    }
+
+    // Clean up
+    free(drawn);
+    free_scratch(scratch, threads);
+    free(paths);
+    free(edges);
+}
+
+/* Rectangle of the width x height upright picture that the view box covers */
+static void view_box_rect(const DisplayInfo *display_info, const Transform *t, uint32_t width,
+                          uint32_t height, FbRect *rect) {
+    const ViewBox *vb = &display_info->view_box;
+    Point top_left = transform_point(t, (Point){ vb->x, vb->y });
+    Point bottom_right = transform_point(t, (Point){ vb->x + vb->width, vb->y + vb->height });
+
+    // Pad by a pixel for anti-aliasing and clip to the picture
+    float x0 = floorf(top_left.x) - 1, y0 = floorf(top_left.y) - 1;
+    float x1 = ceilf(bottom_right.x) + 1, y1 = ceilf(bottom_right.y) + 1;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > width) x1 = width;
+    if (y1 > height) y1 = height;
+    if (x1 < x0) x1 = x0;
+    if (y1 < y0) y1 = y0;
+
+    rect->x0 = (uint32_t)x0;
+    rect->y0 = (uint32_t)y0;
+    rect->x1 = (uint32_t)x1;
+    rect->y1 = (uint32_t)y1;
+}
+
+/* Screen rectangle of the logo */
+void render_logo_area(const Framebuffer *fb, const DisplayInfo *display_info, const RenderOptions *options,
+                      FbRect *rect) {
+    int turns = rotation_turns(options);
+    uint32_t width, height;
+    logical_size(fb, turns, &width, &height);
+
+    // Area in the upright picture, turned like the rotated blit turns it
+    Transform t;
+    FbRect upright;
+    setup_transform(&t, fb, display_info, options, 0);
+    view_box_rect(display_info, &t, width, height, &upright);
+    *rect = fb_rect_rotate(&upright, turns, width, height);
+}
+
+/* Render a scene upright into a compact buffer, then blit it turned
+ * The buffer only covers the logo area, so the rasterizer sweeps the
+ * rows of the upright logo and the rotation is one tiled copy.
+ */
+static void render_rotated(Framebuffer *fb, const SVGScene *scene, const DisplayInfo *display_info,
+                           const RenderOptions *options, int turns) {
+    uint32_t width, height;
+    logical_size(fb, turns, &width, &height);
+
+    Transform t;
+    FbRect rect;
+    setup_transform(&t, fb, display_info, options, 0);
+    view_box_rect(display_info, &t, width, height, &rect);
+    if (rect.x1 <= rect.x0 || rect.y1 <= rect.y0) {
+        return;
+    }
+
+    Framebuffer *upright = fb_create_offscreen(fb, rect.x1 - rect.x0, rect.y1 - rect.y0);
+    if (!upright) {
+        fprintf(stderr, "Failed to allocate render buffers\n");
+        return;
+    }
+
+    // The buffer starts out black, other backgrounds go under the logo
+    if (options->background) {
+        PROF_PHASE_BEGIN(background_start);
+        background_draw_upright(upright, options->background, rect.x0, rect.y0, width, height);
+        PROF_PHASE_END(background_start, "logo_background");
+    }
+
+    t.offset_x -= rect.x0;
+    t.offset_y -= rect.y0;
+    render_paths(upright, scene, &t, options);
+
+    PROF_PHASE_BEGIN(blit_start);
+    FbRect out = fb_rect_rotate(&rect, turns, width, height);
+    fb_blit_rotated(fb, out.x0, out.y0, upright, turns);
+    PROF_PHASE_END(blit_start, "rotate_blit");
+
+    fb_cleanup(upright);
+}
+
+/* Render a whole scene to the framebuffer with anti-aliasing */
+void render_scene(Framebuffer *fb, const SVGScene *scene, const DisplayInfo *display_info,
+                  const RenderOptions *options) {
+    static const RenderOptions defaults = { RENDER_AA_DEFAULT, 0, NULL, false, NULL, false };
+    if (!options) {
+        options = &defaults;
+    }
+
+    int turns = rotation_turns(options);
+    if (turns != 0 && !options->rotate_geometry) {
+        render_rotated(fb, scene, display_info, options, turns);
+        return;
+    }
+
+    // Paths are drawn over the background of their area
+    PROF_PHASE_BEGIN(background_start);
+    FbRect area;
+    render_logo_area(fb, display_info, options, &area);
+    background_draw(fb, options->background, turns, &area, NULL);
+    PROF_PHASE_END(background_start, "logo_background");
+
+    Transform t;
+    setup_transform(&t, fb, display_info, options, turns);
+    render_paths(fb, scene, &t, options);
+}
+
+/* Render an SVG path to the framebuffer with anti-aliasing */
+void render_svg_path(Framebuffer *fb, const SVGPath *svg, const DisplayInfo *display_info,
+                     const RenderOptions *options) {
+    // A scene of one path, the sweep does not need its bounds
+    SVGScene scene = { svg, 1, 0.0f, 0.0f, 0.0f, 0.0f, display_info->view_box };
+    render_scene(fb, &scene, display_info, options);
 }
@@ -3,15 +3,89 @@
 
 #include "fbsplash.h"
 #include "svg_types.h"
+#include "thread_pool.h"
+#include "background.h"
+
+/* Anti-aliasing engine
+ * RENDER_AA_SUPERSAMPLE: 8 sample lines per row with estimated edge coverage
+ * RENDER_AA_ANALYTIC: Exact signed-area coverage, one pass per row
+ * RENDER_AA_FIXED: Supersampling in fixed point without any floating point
+ *                  per sample line or pixel, for SoCs with a slow FPU
+ * RENDER_AA_REFERENCE: 64 sample lines with exact horizontal coverage, slow,
+ *                      the yardstick the other engines are measured against
+ */
+typedef enum {
+    RENDER_AA_SUPERSAMPLE,
+    RENDER_AA_ANALYTIC,
+    RENDER_AA_FIXED,
+    RENDER_AA_REFERENCE,
+} RenderAA;
+
+/* Engine used when none is chosen, building with SPLASH_FIXED_POINT
+ * makes the integer rasterizer the default
+ */
+#ifdef SPLASH_FIXED_POINT
+#define RENDER_AA_DEFAULT RENDER_AA_FIXED
+#else
+#define RENDER_AA_DEFAULT RENDER_AA_SUPERSAMPLE
+#endif
+
+/* Rendering options
+ * aa: Anti-aliasing engine
+ * rotation: Display rotation in degrees (0, 90, 180 or 270) clockwise. The
+ *           scene is rasterized upright into a compact buffer that is
+ *           blitted turned onto the panel.
+ * pool: Threads that rasterize bands of rows in parallel, NULL renders on
+ *       the calling thread. The output is identical either way.
+ * rotate_geometry: Turn the geometry while mapping it to the panel instead
+ *                  of blitting. It takes about as long, but supersampled
+ *                  edges then differ between orientations. Kept for comparison.
+ * background: Drawn under the logo inside its area, NULL is black
+ * linear_blend: Blend anti-aliased edges with the background in linear
+ *               light, gamma-correct for sRGB screens, at some cost per edge
+ */
+typedef struct {
+    RenderAA aa;
+    int rotation;
+    ThreadPool *pool;
+    bool rotate_geometry;
+    const Background *background;
+    bool linear_blend;
+} RenderOptions;
+
+/* Largest distance in pixels between a curve and its flattened lines */
+#define RENDER_FLATTEN_TOLERANCE 0.25f
+
+/* Curve flattening tolerance in path units for a layout
+ * Curves parsed with it stay within RENDER_FLATTEN_TOLERANCE pixels on
+ * screen, so their point count follows the output resolution.
+ */
+float render_flatten_tolerance(const DisplayInfo *display_info);
+
+/* Render all paths of a scene to the framebuffer in one sweep
+ * Rows are visited once for the whole scene with shared scratch buffers,
+ * later paths go over earlier ones and every drawn pixel is written once.
+ * The background is drawn under the logo area first, the rest of the
+ * screen is left to the caller, see render_logo_area().
+ * options: NULL selects the default engine without rotation
+ */
+void render_scene(Framebuffer *fb, const SVGScene *scene, const DisplayInfo *display_info,
+                  const RenderOptions *options);
 
 /* Render an SVG path to the framebuffer
- * Handles multiple paths and holes, applies scaling and centering
+ * Handles multiple paths and holes, applies rotation, scaling and centering
+ * options: NULL selects the default engine without rotation
  */
-void render_svg_path(Framebuffer *fb, SVGPath *svg, DisplayInfo *display_info);
+void render_svg_path(Framebuffer *fb, const SVGPath *svg, const DisplayInfo *display_info,
+                     const RenderOptions *options);
 
-/* Rotate an SVG path by the specified angle
- * angle: Must be 90, 180, or 270 degrees
+/* Get the screen rectangle of the logo, its view box laid out on the panel
+ * render_scene() writes every pixel of it, the background included, so the
+ * background of the rest of the screen is drawn around it. Only the
+ * layout is needed, the scene may still be parsing.
+ * rect: Receives the area clipped to the screen
  */
-void rotate_svg_path(SVGPath *svg, int angle);
+void render_logo_area(const Framebuffer *fb, const DisplayInfo *display_info, const RenderOptions *options,
+                      FbRect *rect);
 
 #endif
@@ -13,13 +13,13 @@ typedef struct {
 } Point;
 
 /* Path structure representing a series of connected points
- * Can be either an outer path or a hole in another path
+ * Whether it fills or cuts a hole follows from its direction and the fill
+ * rule of the SVGPath it belongs to
  */
 typedef struct {
     Point *points;           // Array of points in the path
     uint32_t num_points;     // Number of points currently in use
     uint32_t capacity;       // Allocated capacity for points array
-    bool is_hole;           // True if this path represents a hole
 } Path;
 
 /* Color structure representing RGBA color values */
@@ -30,6 +30,19 @@ typedef struct {
     uint8_t a;              // Alpha component (0-255)
 } Color;
 
+/* Rule that decides which points the subpaths of a path enclose
+ * Each subpath winds around a point some number of times, counting +1 or
+ * -1 by its direction.
+ * FILL_NONZERO: Inside where the count is not zero, the SVG default. A
+ *               subpath running the other way round cuts a hole.
+ * FILL_EVENODD: Inside where the count is odd, so nested subpaths
+ *               alternate between filled and hole whatever their direction
+ */
+typedef enum {
+    FILL_NONZERO,
+    FILL_EVENODD,
+} FillRule;
+
 /* SVGPath structure representing a complete SVG path
  * Can contain multiple sub-paths including holes
  */
@@ -38,6 +51,25 @@ typedef struct {
     uint32_t num_paths;     // Number of paths currently in use
     uint32_t capacity;      // Allocated capacity for paths array
     Color fill_color;       // Fill color for the path
+    FillRule fill_rule;     // How overlapping subpaths fill
 } SVGPath;
 
+/* Area of user space an image is drawn in, from the SVG viewBox */
+typedef struct {
+    float x, y;             // Top left corner
+    float width, height;    // Size, both positive
+} ViewBox;
+
+/* SVGScene structure holding all paths of an image
+ * The bounds enclose every point of every path, the view box is what
+ * the layout fits onto the screen
+ */
+typedef struct {
+    const SVGPath *paths;   // Array of paths in drawing order
+    uint32_t num_paths;     // Number of paths
+    float min_x, min_y;     // Top left corner of the bounds
+    float max_x, max_y;     // Bottom right corner of the bounds
+    ViewBox view_box;       // Area of the image that is laid out
+} SVGScene;
+
 #endif
@@ -0,0 +1,365 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "text.h"
+#include "progress.h"
+
+#define FONT_COLUMNS 5           // Glyph width in font cells
+#define FONT_ROWS 9              // Glyph height, 7 cells above the baseline and 2 below
+#define FONT_ADVANCE 6           // Cells from one glyph to the next
+#define FONT_LINE 10             // Cells from one line to the next
+#define TEXT_SCREEN_LINES 36     // Text height as a fraction of the screen height
+#define TEXT_COLOR 0xE0E0E0
+
+/* Printable ASCII, one row per byte from the top, bit 4 is the left column */
+static const uint8_t font[TEXT_NUM_GLYPHS][FONT_ROWS] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // ' '
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04, 0x00, 0x00 },  // '!'
+    { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // '"'
+    { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A, 0x00, 0x00 },  // '#'
+    { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04, 0x00, 0x00 },  // '$'
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03, 0x00, 0x00 },  // '%'
+    { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D, 0x00, 0x00 },  // '&'
+    { 0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // '\''
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02, 0x00, 0x00 },  // '('
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08, 0x00, 0x00 },  // ')'
+    { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00, 0x00, 0x00 },  // '*'
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00, 0x00, 0x00 },  // '+'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x04, 0x08 },  // ','
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00 },  // '-'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00, 0x00 },  // '.'
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00, 0x00 },  // '/'
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E, 0x00, 0x00 },  // '0'
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 },  // '1'
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F, 0x00, 0x00 },  // '2'
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E, 0x00, 0x00 },  // '3'
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02, 0x00, 0x00 },  // '4'
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E, 0x00, 0x00 },  // '5'
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E, 0x00, 0x00 },  // '6'
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08, 0x00, 0x00 },  // '7'
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E, 0x00, 0x00 },  // '8'
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C, 0x00, 0x00 },  // '9'
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x00 },  // ':'
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x04, 0x08, 0x00 },  // ';'
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02, 0x00, 0x00 },  // '<'
+    { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00 },  // '='
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08, 0x00, 0x00 },  // '>'
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04, 0x00, 0x00 },  // '?'
+    { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E, 0x00, 0x00 },  // '@'
+    { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11, 0x00, 0x00 },  // 'A'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E, 0x00, 0x00 },  // 'B'
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E, 0x00, 0x00 },  // 'C'
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C, 0x00, 0x00 },  // 'D'
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F, 0x00, 0x00 },  // 'E'
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10, 0x00, 0x00 },  // 'F'
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F, 0x00, 0x00 },  // 'G'
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11, 0x00, 0x00 },  // 'H'
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 },  // 'I'
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C, 0x00, 0x00 },  // 'J'
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11, 0x00, 0x00 },  // 'K'
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F, 0x00, 0x00 },  // 'L'
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11, 0x00, 0x00 },  // 'M'
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x00, 0x00 },  // 'N'
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00 },  // 'O'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10, 0x00, 0x00 },  // 'P'
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D, 0x00, 0x00 },  // 'Q'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11, 0x00, 0x00 },  // 'R'
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E, 0x00, 0x00 },  // 'S'
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00 },  // 'T'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00 },  // 'U'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x00, 0x00 },  // 'V'
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A, 0x00, 0x00 },  // 'W'
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11, 0x00, 0x00 },  // 'X'
+    { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x00, 0x00 },  // 'Y'
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F, 0x00, 0x00 },  // 'Z'
+    { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E, 0x00, 0x00 },  // '['
+    { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00, 0x00 },  // '\\'
+    { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E, 0x00, 0x00 },  // ']'
+    { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // '^'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x00 },  // '_'
+    { 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // '`'
+    { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00, 0x00 },  // 'a'
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E, 0x00, 0x00 },  // 'b'
+    { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x00, 0x00 },  // 'c'
+    { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F, 0x00, 0x00 },  // 'd'
+    { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00, 0x00 },  // 'e'
+    { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08, 0x00, 0x00 },  // 'f'
+    { 0x00, 0x00, 0x0F, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x0E },  // 'g'
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00, 0x00 },  // 'h'
+    { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 },  // 'i'
+    { 0x02, 0x00, 0x06, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },  // 'j'
+    { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12, 0x00, 0x00 },  // 'k'
+    { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00, 0x00 },  // 'l'
+    { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11, 0x00, 0x00 },  // 'm'
+    { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00, 0x00 },  // 'n'
+    { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00, 0x00 },  // 'o'
+    { 0x00, 0x00, 0x1E, 0x11, 0x11, 0x11, 0x1E, 0x10, 0x10 },  // 'p'
+    { 0x00, 0x00, 0x0F, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x01 },  // 'q'
+    { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10, 0x00, 0x00 },  // 'r'
+    { 0x00, 0x00, 0x0F, 0x10, 0x0E, 0x01, 0x1E, 0x00, 0x00 },  // 's'
+    { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06, 0x00, 0x00 },  // 't'
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00, 0x00 },  // 'u'
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x00, 0x00 },  // 'v'
+    { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A, 0x00, 0x00 },  // 'w'
+    { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x00, 0x00 },  // 'x'
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x0E },  // 'y'
+    { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00, 0x00 },  // 'z'
+    { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02, 0x00, 0x00 },  // '{'
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00 },  // '|'
+    { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08, 0x00, 0x00 },  // '}'
+    { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00, 0x00 },  // '~'
+};
+
+/* Font cells of one glyph, with a clear border so neighbours need no checks */
+#define GRID_WIDTH (FONT_ADVANCE + 2)
+#define GRID_HEIGHT (FONT_LINE + 2)
+#define CELL_SET 0x10            // Set cell, clear cells hold a corner bit per filled corner
+
+typedef uint8_t GlyphGrid[GRID_HEIGHT][GRID_WIDTH];
+
+/* Whether font cell (x, y) of a glyph is set, cells outside are clear */
+static bool font_cell(const uint8_t *glyph, int x, int y) {
+    if (x < 0 || x >= FONT_COLUMNS || y < 0 || y >= FONT_ROWS) {
+        return false;
+    }
+    return (glyph[y] >> (FONT_COLUMNS - 1 - x)) & 1;
+}
+
+/* Classify the cells of a glyph
+ * Set cells are squares. A clear cell between two set cells that meet at
+ * one of its corners is filled up to halfway along the diagonal of that
+ * corner, so steps of the bitmap turn into slopes once glyphs are scaled
+ * up. Corner bit 1 is on the right, bit 2 at the bottom.
+ */
+static void build_grid(const uint8_t *glyph, GlyphGrid grid) {
+    for (int y = -1; y <= FONT_LINE; y++) {
+        for (int x = -1; x <= FONT_ADVANCE; x++) {
+            uint8_t cell = 0;
+            if (font_cell(glyph, x, y)) {
+                cell = CELL_SET;
+            } else {
+                for (int corner = 0; corner < 4; corner++) {
+                    int dx = (corner & 1) ? 1 : -1, dy = (corner & 2) ? 1 : -1;
+                    if (font_cell(glyph, x + dx, y) && font_cell(glyph, x, y + dy)) {
+                        cell |= 1 << corner;
+                    }
+                }
+            }
+            grid[y + 1][x + 1] = cell;
+        }
+    }
+}
+
+/* Area of the corner fill {a + b < 1/2} inside [0, a] x [0, b] */
+static float corner_area(float a, float b) {
+    float ta = (a < 0.5f) ? 0.5f - a : 0;
+    float tb = (b < 0.5f) ? 0.5f - b : 0;
+    float tab = (a + b < 0.5f) ? 0.5f - a - b : 0;
+    return (0.25f - ta * ta - tb * tb + tab * tab) / 2;
+}
+
+/* Area of the corner fill inside [a0, a1] x [b0, b1], measured from the corner */
+static float corner_overlap(float a0, float a1, float b0, float b1) {
+    return corner_area(a1, b1) - corner_area(a0, b1) - corner_area(a1, b0) + corner_area(a0, b0);
+}
+
+/* Anti-aliased coverage of one glyph, upright, width * height bytes
+ * Each pixel gets the exact area of the cells and corner fills under it,
+ * at least a pixel per cell means at most two cells along each axis.
+ */
+static void rasterize_glyph(const GlyphGrid grid, uint8_t *mask, uint32_t width, uint32_t height) {
+    float scale_x = (float)FONT_ADVANCE / width;
+    float scale_y = (float)FONT_LINE / height;
+
+    for (uint32_t y = 0; y < height; y++) {
+        float fy0 = y * scale_y, fy1 = (y + 1) * scale_y;
+        int cy0 = (int)fy0, cy1 = (int)(fy1 - 1e-4f);
+        for (uint32_t x = 0; x < width; x++) {
+            float fx0 = x * scale_x, fx1 = (x + 1) * scale_x;
+            int cx0 = (int)fx0, cx1 = (int)(fx1 - 1e-4f);
+
+            float area = 0;
+            for (int cy = cy0; cy <= cy1; cy++) {
+                // Part of the cell under the pixel, relative to the cell
+                float y0 = ((cy > fy0) ? cy : fy0) - cy;
+                float y1 = ((cy + 1 < fy1) ? cy + 1 : fy1) - cy;
+                for (int cx = cx0; cx <= cx1; cx++) {
+                    uint8_t cell = grid[cy + 1][cx + 1];
+                    if (cell == 0) {
+                        continue;
+                    }
+                    float x0 = ((cx > fx0) ? cx : fx0) - cx;
+                    float x1 = ((cx + 1 < fx1) ? cx + 1 : fx1) - cx;
+                    if (cell & CELL_SET) {
+                        area += (x1 - x0) * (y1 - y0);
+                        continue;
+                    }
+
+                    // Corners on the right or bottom are measured mirrored
+                    for (int corner = 0; corner < 4; corner++) {
+                        if (cell >> corner & 1) {
+                            float a0 = (corner & 1) ? 1 - x1 : x0, a1 = (corner & 1) ? 1 - x0 : x1;
+                            float b0 = (corner & 2) ? 1 - y1 : y0, b1 = (corner & 2) ? 1 - y0 : y1;
+                            area += corner_overlap(a0, a1, b0, b1);
+                        }
+                    }
+                }
+            }
+
+            uint32_t c = (uint32_t)(area / (scale_x * scale_y) * 255 + 0.5f);
+            mask[y * width + x] = (c > 255) ? 255 : (uint8_t)c;
+        }
+    }
+}
+
+/* Rasterize the font for one line height */
+int text_atlas_init(TextAtlas *atlas, uint32_t height, int turns) {
+    memset(atlas, 0, sizeof(*atlas));
+    atlas->height = height;
+    atlas->width = (height * FONT_ADVANCE + FONT_LINE / 2) / FONT_LINE;
+    if (atlas->width == 0) atlas->width = 1;
+    atlas->turns = turns;
+
+    uint32_t width = atlas->width;
+    size_t glyph_size = (size_t)width * height;
+    uint8_t *upright = malloc(glyph_size);
+    atlas->coverage = malloc(TEXT_NUM_GLYPHS * glyph_size);
+    if (!upright || !atlas->coverage) {
+        fprintf(stderr, "Failed to allocate the glyph atlas\n");
+        free(upright);
+        free(atlas->coverage);
+        atlas->coverage = NULL;
+        return -1;
+    }
+
+    // Turned masks are as wide as the glyph is high
+    uint32_t mask_width = (turns & 1) ? height : width;
+    uint32_t mask_height = (turns & 1) ? width : height;
+
+    for (uint32_t g = 0; g < TEXT_NUM_GLYPHS; g++) {
+        GlyphGrid grid;
+        build_grid(font[g], grid);
+        rasterize_glyph(grid, upright, width, height);
+
+        uint8_t *mask = atlas->coverage + g * glyph_size;
+        bool blank = true;
+        for (uint32_t my = 0; my < mask_height; my++) {
+            for (uint32_t mx = 0; mx < mask_width; mx++) {
+                // Upright glyph pixel shown at mask pixel (mx, my), as fb_rect_rotate() turns
+                uint32_t gx, gy;
+                switch (turns) {
+                    case 1: gx = my; gy = height - 1 - mx; break;
+                    case 2: gx = width - 1 - mx; gy = height - 1 - my; break;
+                    case 3: gx = width - 1 - my; gy = mx; break;
+                    default: gx = mx; gy = my; break;
+                }
+                uint8_t c = upright[gy * width + gx];
+                mask[my * mask_width + mx] = c;
+                blank &= c == 0;
+            }
+        }
+        atlas->blank[g] = blank;
+    }
+
+    free(upright);
+    return 0;
+}
+
+/* Free the masks of an atlas */
+void text_atlas_free(TextAtlas *atlas) {
+    free(atlas->coverage);
+    atlas->coverage = NULL;
+}
+
+/* Place a text line below the logo and rasterize its font */
+int text_line_init(TextLine *line, const Framebuffer *fb, const DisplayInfo *display_info,
+                   int rotation, const Background *background) {
+    int turns = (rotation / 90) % 4;
+    line->logical_width = (turns & 1) ? fb->vinfo.yres : fb->vinfo.xres;
+    line->logical_height = (turns & 1) ? fb->vinfo.xres : fb->vinfo.yres;
+    line->color = TEXT_COLOR;
+    line->background = background;
+    memset(&line->shown, 0, sizeof(line->shown));
+    line->text[0] = '\0';
+
+    // Readable whatever the logo size, and never below one pixel per font cell
+    uint32_t height = line->logical_height / TEXT_SCREEN_LINES;
+    if (height < FONT_LINE) height = FONT_LINE;
+    if (height > line->logical_height) height = line->logical_height;
+
+    // Half a line below where the progress bar goes, or above it when the
+    // bar is pushed to the bottom of the screen
+    ProgressBar bar;
+    progress_bar_init(&bar, fb, display_info, rotation);
+    uint32_t gap = height / 2;
+    uint32_t y = bar.rect.y1 + gap;
+    if (y + height > line->logical_height) {
+        y = (bar.rect.y0 >= height + gap) ? bar.rect.y0 - height - gap : line->logical_height - height;
+    }
+
+    line->area.x0 = 0;
+    line->area.y0 = y;
+    line->area.x1 = line->logical_width;
+    line->area.y1 = y + height;
+
+    return text_atlas_init(&line->atlas, height, turns);
+}
+
+/* Show a string on the line, replacing the one before */
+void text_line_draw(Framebuffer *fb, TextLine *line, const char *text) {
+    const TextAtlas *atlas = &line->atlas;
+    if (!atlas->coverage) {
+        return;
+    }
+
+    // Cut off what does not fit
+    size_t length = strlen(text);
+    size_t fit = (line->area.x1 - line->area.x0) / atlas->width;
+    if (length > fit) length = fit;
+    if (length > TEXT_MAX_LENGTH) length = TEXT_MAX_LENGTH;
+    if (strlen(line->text) == length && memcmp(line->text, text, length) == 0) {
+        return;
+    }
+
+    uint32_t text_width = (uint32_t)length * atlas->width;
+    FbRect box = { line->area.x0 + (line->area.x1 - line->area.x0 - text_width) / 2, line->area.y0, 0,
+                   line->area.y1 };
+    box.x1 = box.x0 + text_width;
+
+    // Background under the new string, and where the old one sticks out
+    FbRect old = fb_rect_rotate(&line->shown, atlas->turns, line->logical_width, line->logical_height);
+    FbRect out = fb_rect_rotate(&box, atlas->turns, line->logical_width, line->logical_height);
+    background_draw(fb, line->background, atlas->turns, &old, &out);
+    background_draw(fb, line->background, atlas->turns, &out, NULL);
+
+    // Glyph masks go over it row by row, the background draw marked them damaged
+    const PixelFormat *fmt = &fb->format;
+    size_t glyph_size = (size_t)atlas->width * atlas->height;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char ch = (unsigned char)text[i];
+        uint32_t g = (ch >= TEXT_FIRST_GLYPH && ch < TEXT_FIRST_GLYPH + TEXT_NUM_GLYPHS) ?
+                     ch - TEXT_FIRST_GLYPH : '?' - TEXT_FIRST_GLYPH;
+        if (atlas->blank[g]) {
+            continue;
+        }
+
+        FbRect cell = { box.x0 + (uint32_t)i * atlas->width, box.y0, 0, box.y1 };
+        cell.x1 = cell.x0 + atlas->width;
+        FbRect r = fb_rect_rotate(&cell, atlas->turns, line->logical_width, line->logical_height);
+
+        const uint8_t *mask = atlas->coverage + g * glyph_size;
+        uint32_t mask_width = r.x1 - r.x0;
+        for (uint32_t y = r.y0; y < r.y1; y++, mask += mask_width) {
+            fmt->blend(fmt, fb_pixel_address(fb, r.x0, y), line->color, mask, mask_width);
+        }
+    }
+
+    memcpy(line->text, text, length);
+    line->text[length] = '\0';
+    line->shown = box;
+}
+
+/* Free the atlas of a text line */
+void text_line_free(TextLine *line) {
+    text_atlas_free(&line->atlas);
+}
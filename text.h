@@ -0,0 +1,71 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fbsplash.h"
+#include "background.h"
+
+/* Status text under the logo
+ * Glyphs come from a small built-in bitmap font covering printable ASCII.
+ * For one text height every glyph is scaled and anti-aliased once into an
+ * atlas of 8-bit coverage masks, already turned for the panel, so drawing
+ * a string is one alpha blend per glyph row through the pixel format and
+ * nothing is rasterized again.
+ */
+
+#define TEXT_FIRST_GLYPH 32      // Space, the first glyph of the font
+#define TEXT_NUM_GLYPHS 95       // Space to tilde, others are drawn as '?'
+#define TEXT_MAX_LENGTH 255      // Longest string a text line keeps
+
+/* Coverage masks of every glyph at one size */
+typedef struct {
+    uint32_t width;          // Advance of every glyph in pixels, spacing included
+    uint32_t height;         // Line height in pixels, descenders included
+    int turns;               // Quarter turns of the masks onto the panel
+    uint8_t *coverage;       // Masks one after another, rows as on the panel
+    bool blank[TEXT_NUM_GLYPHS];  // Glyphs without coverage, such as space
+} TextAtlas;
+
+/* Rasterize the font for one line height
+ * turns: Quarter turns from the upright picture to the panel
+ * Returns: 0 on success, -1 if the masks cannot be allocated
+ */
+int text_atlas_init(TextAtlas *atlas, uint32_t height, int turns);
+
+/* Free the masks of an atlas */
+void text_atlas_free(TextAtlas *atlas);
+
+/* Line of text centered below the progress bar
+ * The line is laid out in logical coordinates like the logo and turned
+ * onto the panel, so it follows the display rotation.
+ */
+typedef struct {
+    TextAtlas atlas;
+    FbRect area;             // Line in the upright picture, text is centered in it
+    FbRect shown;            // Upright bounds of the text on screen, empty before the first draw
+    uint32_t logical_width;  // Size of the upright picture
+    uint32_t logical_height;
+    uint32_t color;          // Text color, 0xRRGGBB
+    const Background *background;  // Drawn under the text, NULL is black
+    char text[TEXT_MAX_LENGTH + 1];  // String on screen
+} TextLine;
+
+/* Place a text line below the logo and rasterize its font
+ * rotation: Display rotation in degrees, as used for the logo
+ * background: Background of the screen, must outlive the line
+ * Returns: 0 on success, -1 on failure
+ */
+int text_line_init(TextLine *line, const Framebuffer *fb, const DisplayInfo *display_info,
+                   int rotation, const Background *background);
+
+/* Show a string on the line, replacing the one before
+ * Only the bounds of the old and new string are redrawn, and nothing if
+ * the string is unchanged. Strings wider than the screen are cut off.
+ */
+void text_line_draw(Framebuffer *fb, TextLine *line, const char *text);
+
+/* Free the atlas of a text line */
+void text_line_free(TextLine *line);
+
+#endif
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "thread_pool.h"
+
+typedef struct {
+    ThreadPool *pool;
+    pthread_t thread;
+    unsigned int index;
+} ThreadPoolWorker;
+
+struct ThreadPool {
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;      // Signalled when a run starts or on shutdown
+    pthread_cond_t done_cond;      // Signalled when the last task of a run finishes
+    ThreadPoolWorker *workers;
+    unsigned int num_workers;
+
+    // Current run, protected by lock
+    ThreadPoolTask fn;
+    void *arg;
+    unsigned int num_tasks;
+    unsigned int next_task;
+    unsigned int done_tasks;
+    unsigned long generation;      // Incremented for every run
+    bool stop;
+};
+
+/* Claim and run tasks until none are left, called with the lock held */
+static void run_tasks(ThreadPool *pool, unsigned int thread) {
+    while (pool->next_task < pool->num_tasks) {
+        unsigned int task = pool->next_task++;
+
+        pthread_mutex_unlock(&pool->lock);
+        pool->fn(pool->arg, task, thread);
+        pthread_mutex_lock(&pool->lock);
+
+        if (++pool->done_tasks == pool->num_tasks) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+}
+
+/* Worker thread main loop */
+static void *worker_main(void *arg) {
+    ThreadPoolWorker *worker = arg;
+    ThreadPool *pool = worker->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stop && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_cond, &pool->lock);
+        }
+        if (pool->stop) {
+            break;
+        }
+        seen = pool->generation;
+        run_tasks(pool, worker->index);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/* Create a pool with the given total number of threads */
+ThreadPool* thread_pool_create(unsigned int threads) {
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? (unsigned int)cpus : 1;
+    }
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    if (threads > 1) {
+        pool->workers = calloc(threads - 1, sizeof(ThreadPoolWorker));
+        if (!pool->workers) {
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+    }
+
+    // Fewer workers than requested still work, just with less parallelism
+    for (unsigned int i = 0; i + 1 < threads; i++) {
+        ThreadPoolWorker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->index = i + 1;
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            fprintf(stderr, "Failed to start render thread %u of %u\n", i + 2, threads);
+            break;
+        }
+        pool->num_workers++;
+    }
+
+    return pool;
+}
+
+/* Total number of threads taking part in a run */
+unsigned int thread_pool_size(const ThreadPool *pool) {
+    return pool ? pool->num_workers + 1 : 1;
+}
+
+/* Run fn for every task index and wait for all of them */
+void thread_pool_run(ThreadPool *pool, ThreadPoolTask fn, void *arg, unsigned int num_tasks) {
+    if (!pool || pool->num_workers == 0 || num_tasks <= 1) {
+        for (unsigned int task = 0; task < num_tasks; task++) {
+            fn(arg, task, 0);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->num_tasks = num_tasks;
+    pool->next_task = 0;
+    pool->done_tasks = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+
+    // Help with the work, then wait for tasks still running on workers
+    run_tasks(pool, 0);
+    while (pool->done_tasks < pool->num_tasks) {
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/* Stop the workers and free the pool */
+void thread_pool_destroy(ThreadPool *pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned int i = 0; i < pool->num_workers; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
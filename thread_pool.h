@@ -0,0 +1,33 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/* Small fixed-size pool of worker threads
+ * The calling thread takes part in every run, so a pool of size 1 has no
+ * workers and runs everything inline.
+ */
+typedef struct ThreadPool ThreadPool;
+
+/* Task function, called once for every task index of a run
+ * thread: Index of the running thread below thread_pool_size(), the caller is 0.
+ *         Lets tasks use per-thread scratch memory without locking.
+ */
+typedef void (*ThreadPoolTask)(void *arg, unsigned int task, unsigned int thread);
+
+/* Create a pool with the given total number of threads, including the caller
+ * threads: 0 selects the number of online CPUs
+ * Returns: Pointer to the pool or NULL on failure
+ */
+ThreadPool* thread_pool_create(unsigned int threads);
+
+/* Total number of threads taking part in a run */
+unsigned int thread_pool_size(const ThreadPool *pool);
+
+/* Run fn for task indices 0..num_tasks-1 and wait for all of them
+ * pool: NULL runs all tasks on the calling thread
+ */
+void thread_pool_run(ThreadPool *pool, ThreadPoolTask fn, void *arg, unsigned int num_tasks);
+
+/* Stop the workers and free the pool */
+void thread_pool_destroy(ThreadPool *pool);
+
+#endif